@@ -41,6 +41,26 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
     }
     switch (key)
     {
+    case GLFW_KEY_F9:
+        if (action == GLFW_PRESS) {
+            base->base_defragmenter.start();
+        }
+        break;
+    case GLFW_KEY_F10:
+        if (action == GLFW_PRESS) {
+            base->base_showMemoryStatistics = !base->base_showMemoryStatistics;
+        }
+        break;
+    case GLFW_KEY_F11:
+        if (action == GLFW_PRESS) {
+            base->writeMemoryStatistics();
+        }
+        break;
+    case GLFW_KEY_F12:
+        if (action == GLFW_PRESS) {
+            base->writeTrace();
+        }
+        break;
     case GLFW_KEY_W:
         if (action == GLFW_PRESS) {
             base->base_camera.keys.up = true;
@@ -124,15 +144,129 @@ void scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
     base->base_camera.translateDistance(-translateDistance);
 }
 
+void BaseSample::parseCommandLineArgs(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        // Returns the value following the argument
+        auto nextValue = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw MakeErrorInfo(("Missing value for command line argument " + arg).c_str());
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--headless") {
+            base_headless = true;
+        }
+        else if (arg == "--width") {
+            base_headlessExtent.width = std::stoul(nextValue());
+        }
+        else if (arg == "--height") {
+            base_headlessExtent.height = std::stoul(nextValue());
+        }
+        else if (arg == "--frames") {
+            base_headlessFrameCount = std::stoull(nextValue());
+        }
+        else if (arg == "--frames-in-flight") {
+            base_maxFramesInFlight = std::stoul(nextValue());
+        }
+        else if (arg == "--per-frame-depth") {
+            base_perFrameDepthImages = true;
+        }
+        else if (arg == "--trace") {
+            base_traceFilePath = nextValue();
+            base_writeTraceAtExit = true;
+        }
+        else if (arg == "--memory-stats") {
+            base_memoryStatisticsFilePath = nextValue();
+            base_writeMemoryStatisticsAtExit = true;
+        }
+        else if (arg == "--defragment") {
+            base_autoDefragmentation = true;
+        }
+        else if (arg == "--host-allocations") {
+            base_trackHostAllocations = true;
+        }
+        else if (arg == "--pooled-host-allocations") {
+            base_trackHostAllocations = true;
+            base_pooledHostAllocations = true;
+        }
+        else if (arg == "--no-memory-pools") {
+            base_useMemoryPools = false;
+        }
+        else if (arg == "--no-async-transfer") {
+            base_asyncTransfer = false;
+        }
+        else if (arg == "--texture-budget") {
+            base_textureStreamer.memoryBudget = std::stoull(nextValue()) * 1024 * 1024;
+        }
+        else if (arg == "--separate-ui-pass") {
+            base_uiInSceneRenderPass = false;
+        }
+        else if (arg == "--threads") {
+            base_workerThreadCount = std::stoul(nextValue());
+        }
+        else if (arg == "--timeline-semaphore") {
+            base_useTimelineSemaphore = true;
+        }
+        else if (arg == "--benchmark") {
+            base_benchmark.enabled = true;
+        }
+        else if (arg == "--benchmark-frames") {
+            base_benchmark.enabled = true;
+            base_benchmark.frames = std::stoul(nextValue());
+        }
+        else if (arg == "--benchmark-seconds") {
+            base_benchmark.enabled = true;
+            base_benchmark.seconds = std::stod(nextValue());
+        }
+        else if (arg == "--benchmark-warmup") {
+            base_benchmark.enabled = true;
+            base_benchmark.warmupFrames = std::stoul(nextValue());
+        }
+        else if (arg == "--benchmark-output") {
+            base_benchmark.enabled = true;
+            base_benchmark.outputFilePath = nextValue();
+        }
+        else {
+            std::cerr << "Warning: Unknown command line argument " << arg << "\n";
+        }
+    }
+    if (base_headlessExtent.width == 0 || base_headlessExtent.height == 0) {
+        throw MakeErrorInfo("Offscreen image size can't be zero!");
+    }
+    if (base_maxFramesInFlight < 1 || base_maxFramesInFlight > BASE_MAX_FRAMES_IN_FLIGHT_LIMIT) {
+        base_maxFramesInFlight = std::clamp(base_maxFramesInFlight, 1u, (uint32_t)BASE_MAX_FRAMES_IN_FLIGHT_LIMIT);
+        std::cerr << "Warning: The number of frames in flight is clamped to " << base_maxFramesInFlight << "\n";
+    }
+    if (base_benchmark.enabled && base_benchmark.frames == 0 && base_benchmark.seconds <= 0.0) {
+        throw MakeErrorInfo("Benchmark needs a non-zero number of frames or seconds!");
+    }
+}
+
 void BaseSample::initVulkan()
 {
-    initGlfw();
-    createWindow();
+    if (!base_headless) {
+        initGlfw();
+        createWindow();
+    }
+    else {
+        // There is no window, samples use the window size to set up the camera
+        base_windowWidth = (int)base_headlessExtent.width;
+        base_windowHeight = (int)base_headlessExtent.height;
+    }
+    // The callbacks are used from the instance creation to its destruction
+    if (base_trackHostAllocations) {
+        hostAllocationTracker.enable(base_pooledHostAllocations);
+    }
     createInstance();
     if (ValidationLayers::enabled) {
         setupDebugMessenger();
     }
-    createSurface();
+    if (!base_headless) {
+        createSurface();
+    }
     prepareDevice();
     initVma();
 }
@@ -140,12 +274,53 @@ void BaseSample::initVulkan()
 void BaseSample::prepare()
 {
     createSwapChain();
-    createDepthImage();
+    createDepthImages();
     createRenderPass();
     createFramebuffers();
     createCommandPoolGraphics();
     createCommandBuffersGraphics();
     createSyncObjects();
+    base_gpuProfiler.init(base_vulkanDevice, base_maxFramesInFlight);
+    base_jobSystem.start(base_workerThreadCount);
+    uint32_t graphicsQueueFamilyIndex = base_vulkanDevice->queueFamilyIndices.graphics.value();
+    // The staging ring takes one block of the staging pool
+    VkDeviceSize stagingRingSize = 64 * 1024 * 1024;
+    VmaPool stagingPool = base_memoryPools.getPool(MemoryPools::Category::Staging);
+    // Compute fallback of the mipmap generation for formats that can't be blitted with linear filter
+    std::string mipmapShaderPath = ASSETS_DATA_SHADERS_PATH + "Base/mipmapdownsample.comp.spv";
+    if (base_asyncTransfer && base_transferQueue && base_vulkanDevice->queueFamilyIndices.transfer.value() != graphicsQueueFamilyIndex) {
+        // Copies on the transfer queue, the ownership is transferred to the graphics queue
+        base_uploadManager.init(
+            base_vulkanDevice,
+            base_vmaAllocator,
+            base_transferQueue,
+            base_vulkanDevice->queueFamilyIndices.transfer.value(),
+            base_graphicsQueue,
+            graphicsQueueFamilyIndex,
+            stagingRingSize,
+            stagingPool,
+            mipmapShaderPath
+        );
+    }
+    else {
+        base_uploadManager.init(base_vulkanDevice, base_vmaAllocator, base_graphicsQueue, graphicsQueueFamilyIndex, VK_NULL_HANDLE, VK_QUEUE_FAMILY_IGNORED, stagingRingSize, stagingPool, mipmapShaderPath);
+    }
+    base_assetStreamer.init(base_vulkanDevice, base_vmaAllocator, &base_uploadManager, &base_jobSystem, base_useMemoryPools ? &base_memoryPools : nullptr);
+    base_textureStreamer.init(
+        base_vulkanDevice,
+        base_vmaAllocator,
+        &base_uploadManager,
+        &base_jobSystem,
+        &base_deferredReleases,
+        base_useMemoryPools ? base_memoryPools.getPool(MemoryPools::Category::Textures) : nullptr
+    );
+    // Moved resources are used on the graphics queue, the copies are submitted to it
+    base_defragmenter.init(base_vulkanDevice, base_vmaAllocator, base_graphicsQueue, graphicsQueueFamilyIndex);
+    if (base_useMemoryPools) {
+        // Linear pools(per-frame, staging) can't be defragmented
+        base_defragmenter.addPool(base_memoryPools.getPool(MemoryPools::Category::StaticGeometry));
+        base_defragmenter.addPool(base_memoryPools.getPool(MemoryPools::Category::Textures));
+    }
     imguiUI.initImGui(
         base_instance,
         base_vulkanDevice,
@@ -154,20 +329,149 @@ void BaseSample::prepare()
         base_vulkanSwapChain->images.size(),
         base_vulkanSwapChain,
         base_window,
-        BASE_MAX_FRAMES_IN_FLIGHT
+        base_maxFramesInFlight,
+        &base_gpuProfiler,
+        base_uiInSceneRenderPass ? base_renderPass : VK_NULL_HANDLE
     );
 }
 
 void BaseSample::renderLoop()
 {
+    // Assets loaded during the preparation are drawn from the first frame
+    base_uploadManager.waitIdle();
+
+    if (base_benchmark.enabled) {
+        runBenchmark();
+        return;
+    }
+    if (base_headless) {
+        std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+        while (base_headlessFrameCount == 0 || base_frameNumber < base_headlessFrameCount) {
+            CPU_PROFILE_SCOPE(base_cpuProfiler, "Frame");
+            nextFrame();
+        }
+        vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
+        std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+        double totalTime = std::chrono::duration<double, std::chrono::milliseconds::period>(endTime - startTime).count();
+        std::cout << "Headless: " << base_frameNumber << " frames in " << totalTime << " ms, "
+            << totalTime / base_frameNumber << " ms per frame, " << base_frameNumber * 1000.0 / totalTime << " FPS\n";
+        for (const auto& [name, statistics] : base_gpuProfiler.getStatistics()) {
+            std::cout << "GPU " << name << ": min " << statistics.min << " ms, avg " << statistics.avg << " ms, p99 " << statistics.p99 << " ms\n";
+        }
+        if (base_writeTraceAtExit) {
+            writeTrace();
+        }
+        if (base_writeMemoryStatisticsAtExit) {
+            writeMemoryStatistics();
+        }
+        return;
+    }
     while (!glfwWindowShouldClose(base_window)) {
+        CPU_PROFILE_SCOPE(base_cpuProfiler, "Frame");
         std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+        base_cpuProfiler.beginScope("Poll events");
         glfwPollEvents();
+        base_cpuProfiler.endScope();
         std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
         base_lastEventsPoolTime = std::chrono::duration<double, std::chrono::milliseconds::period>(endTime - startTime).count();
 
         nextFrame();
     }
+    if (base_writeTraceAtExit) {
+        writeTrace();
+    }
+    if (base_writeMemoryStatisticsAtExit) {
+        writeMemoryStatistics();
+    }
+}
+
+void BaseSample::runBenchmark()
+{
+    std::cout << "Benchmark: " << base_benchmark.warmupFrames << " warmup frames, then ";
+    if (base_benchmark.seconds > 0.0) {
+        std::cout << base_benchmark.seconds << " seconds\n";
+    }
+    else {
+        std::cout << base_benchmark.frames << " frames\n";
+    }
+    // Every measured frame draws the complete scene
+    base_assetStreamer.waitIdle();
+    base_benchmark.begin();
+    while (!base_benchmark.isFinished()) {
+        // The window can still be closed, the results of the measured frames are written anyway
+        if (!base_headless && glfwWindowShouldClose(base_window)) {
+            break;
+        }
+        CPU_PROFILE_SCOPE(base_cpuProfiler, "Frame");
+        std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+        if (!base_headless) {
+            base_cpuProfiler.beginScope("Poll events");
+            glfwPollEvents();
+            base_cpuProfiler.endScope();
+        }
+        updateBenchmarkCamera();
+        nextFrame();
+        std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+        base_benchmark.addFrame(std::chrono::duration<double, std::chrono::milliseconds::period>(endTime - startTime).count(), base_lastFenceWaitTime);
+    }
+    vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
+
+    VkExtent2D extent = base_vulkanSwapChain->surfaceExtent;
+    base_benchmark.writeResults(
+        base_title,
+        base_vulkanDevice,
+        base_gpuProfiler,
+        base_vmaAllocator,
+        {
+            { "headless", base_headless ? "true" : "false" },
+            { "width", std::to_string(extent.width) },
+            { "height", std::to_string(extent.height) },
+            { "framesInFlight", std::to_string(base_maxFramesInFlight) },
+            { "perFrameDepthImages", base_perFrameDepthImages ? "true" : "false" },
+            { "fixedFrameTimeMs", std::to_string(base_benchmark.fixedFrameTime) }
+        }
+    );
+    if (base_writeTraceAtExit) {
+        writeTrace();
+    }
+    if (base_writeMemoryStatisticsAtExit) {
+        writeMemoryStatistics();
+    }
+}
+
+void BaseSample::updateBenchmarkCamera()
+{
+    // The position on the path depends only on the frame index, so every run sees the same frames
+    double t = double(base_benchmark.getFrameIndex() % base_benchmark.getPathLength()) / base_benchmark.getPathLength();
+    float angle = float(t * 2.0 * glm::pi<double>());
+    if (base_camera.type == Camera::CameraType::lookat) {
+        // Full orbit around the model with a small vertical swing
+        base_camera.setRotation(glm::vec3(15.0f * glm::sin(angle * 2.0f), glm::degrees(angle), 0.0f));
+    }
+    else {
+        // First person samples look at the scene in front of the camera, the camera pans left and right
+        base_camera.setRotation(glm::vec3(5.0f * glm::sin(angle * 2.0f), 20.0f * glm::sin(angle), 0.0f));
+    }
+}
+
+void BaseSample::writeTrace()
+{
+    if (base_cpuProfiler.writeChromeTrace(base_traceFilePath)) {
+        std::cout << "CPU trace written to " << base_traceFilePath << "\n";
+    }
+    else {
+        std::cerr << "Warning: Failed to write CPU trace to " << base_traceFilePath << "\n";
+    }
+}
+
+void BaseSample::writeMemoryStatistics()
+{
+    if (base_memoryStatistics.writeJson(base_memoryStatisticsFilePath)) {
+        std::cout << "Memory statistics written to " << base_memoryStatisticsFilePath << "\n";
+    }
+    else {
+        std::cerr << "Warning: Failed to write memory statistics to " << base_memoryStatisticsFilePath << "\n";
+    }
 }
 
 void BaseSample::nextFrame()
@@ -177,7 +481,60 @@ void BaseSample::nextFrame()
 
 void BaseSample::prepareFrame()
 {
-    vkWaitForFences(base_vulkanDevice->logicalDevice, 1, &base_inFlightFences[base_currentFrameIndex], VK_TRUE, UINT64_MAX);
+    std::chrono::time_point<std::chrono::steady_clock> fenceWaitStartTime = std::chrono::steady_clock::now();
+    base_cpuProfiler.beginScope("Fence wait");
+    // Only the resources of this frame slot(command buffer, semaphores, query pool) require the wait, the resources
+    // shared between frames are released by frame values(base_deferredReleases) and never wait
+    updateCompletedFrameValue();
+    if (base_completedFrameValue < base_frameTimelineValues[base_currentFrameIndex]) {
+        if (base_useTimelineSemaphore) {
+            base_frameTimeline.wait(base_frameTimelineValues[base_currentFrameIndex]);
+        }
+        else {
+            vkWaitForFences(base_vulkanDevice->logicalDevice, 1, &base_inFlightFences[base_currentFrameIndex], VK_TRUE, UINT64_MAX);
+        }
+        updateCompletedFrameValue();
+    }
+    base_cpuProfiler.endScope();
+    base_lastFenceWaitTime = std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - fenceWaitStartTime).count();
+
+    // The frame has been completed, its timestamps can be read without waiting
+    base_gpuProfiler.collectResults(base_currentFrameIndex);
+
+    // Resources no completed frame uses anymore
+    base_deferredReleases.collect(base_completedFrameValue);
+
+    // Streamed assets whose uploads have been completed become ready, the uploads of newly decoded ones are recorded
+    // VMA refetches the budget from the driver when the frame index changes
+    vmaSetCurrentFrameIndex(base_vmaAllocator, (uint32_t)base_frameNumber);
+    // Budgets are cheap to read, the detailed statistics are recalculated at an interval
+    base_memoryStatistics.update();
+
+    base_cpuProfiler.beginScope("Defragmentation");
+    if (base_autoDefragmentation && !base_defragmenter.isRunning() && base_frameNumber - base_lastDefragmentationFrame >= base_defragmentationInterval) {
+        for (const MemoryStatistics::HeapStatistics& heap : base_memoryStatistics.getHeaps()) {
+            if (heap.fragmentation > base_defragmentationThreshold) {
+                base_defragmenter.start();
+                base_lastDefragmentationFrame = base_frameNumber;
+                break;
+            }
+        }
+    }
+    base_defragmenter.update();
+    base_cpuProfiler.endScope();
+
+    base_cpuProfiler.beginScope("Asset streaming");
+    base_assetStreamer.update();
+    base_cpuProfiler.endScope();
+
+    base_cpuProfiler.beginScope("Texture streaming");
+    // Images with completed uploads replace the old ones, the levels requested by the previous frame are streamed in
+    base_textureStreamer.update(getFrameTimelineValue());
+    base_cpuProfiler.endScope();
+
+    // Uploads recorded since the last frame are submitted before the frame commands
+    // With the transfer queue it also submits the acquire barriers of the completed uploads
+    base_uploadManager.flush();
 
     // Calculating frametime
     std::chrono::time_point<std::chrono::steady_clock> currentTime = std::chrono::steady_clock::now();
@@ -185,9 +542,25 @@ void BaseSample::prepareFrame()
     base_frameTime = std::chrono::duration<double, std::chrono::milliseconds::period>(currentTime - prevTime).count();
     base_frameTime -= base_lastEventsPoolTime;
     prevTime = currentTime;
+    if (base_benchmark.enabled) {
+        // Animations advance by the same step in every run
+        base_frameTime = base_benchmark.fixedFrameTime;
+    }
+
+    if (base_headless) {
+        // Offscreen images are used in turn, the image used by this frame
+        // was used base_maxFramesInFlight + 1 frames ago and has already been rendered
+        base_currentImageIndex = base_frameNumber % base_vulkanSwapChain->images.size();
+        if (!base_useTimelineSemaphore) {
+            vkResetFences(base_vulkanDevice->logicalDevice, 1, &base_inFlightFences[base_currentFrameIndex]);
+        }
+        return;
+    }
 
     VkResult result;
+    base_cpuProfiler.beginScope("Acquire");
     result = vkAcquireNextImageKHR(base_vulkanDevice->logicalDevice, base_vulkanSwapChain->swapChain, UINT64_MAX, base_imageAvailableSemaphores[base_currentFrameIndex], VK_NULL_HANDLE, &base_currentImageIndex);
+    base_cpuProfiler.endScope();
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         recreateSwapChain();
     }
@@ -195,14 +568,69 @@ void BaseSample::prepareFrame()
         throw MakeErrorInfo("Failed to acquire swap chain image!");
     }
 
-    vkResetFences(base_vulkanDevice->logicalDevice, 1, &base_inFlightFences[base_currentFrameIndex]);
+    if (!base_useTimelineSemaphore) {
+        vkResetFences(base_vulkanDevice->logicalDevice, 1, &base_inFlightFences[base_currentFrameIndex]);
+    }
 }
 
 void BaseSample::draw() { }
 
+void BaseSample::buildUI()
+{
+    base_cpuProfiler.beginScope("ImGui build");
+    imguiUI.beginFrame();
+    drawUI();
+    if (base_showMemoryStatistics) {
+        UIOverlay::windowBegin("Memory", nullptr, { 0, (float)base_vulkanSwapChain->surfaceExtent.height - 380.0f }, { 420, 380 });
+        UIOverlay::printMemoryStatistics(base_memoryStatistics);
+        if (base_useMemoryPools) {
+            UIOverlay::printMemoryPools(base_memoryPools);
+        }
+        if (hostAllocationTracker.isEnabled()) {
+            UIOverlay::printHostAllocations(hostAllocationTracker);
+        }
+        UIOverlay::windowEnd();
+    }
+    imguiUI.endFrame();
+    base_cpuProfiler.endScope();
+}
+
+void BaseSample::recordUI(VkCommandBuffer commandBuffer)
+{
+    if (base_uiInSceneRenderPass) {
+        imguiUI.recordInRenderPass(commandBuffer);
+    }
+}
+
+void BaseSample::submitFrameCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    VkCommandBuffer submittableCommandBuffers[2] = { commandBuffer, VK_NULL_HANDLE };
+    base_submitInfo.commandBufferCount = 1;
+    if (!base_uiInSceneRenderPass) {
+        base_cpuProfiler.beginScope("ImGui record");
+        submittableCommandBuffers[1] = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
+        base_cpuProfiler.endScope();
+        base_submitInfo.commandBufferCount = 2;
+    }
+    base_submitInfo.pCommandBuffers = submittableCommandBuffers;
+    setupSubmitInfo(base_currentFrameIndex);
+    base_cpuProfiler.beginScope("Submit");
+    if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, getFrameFence()) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to submit command buffers!");
+    }
+    base_cpuProfiler.endScope();
+}
+
 
 void BaseSample::submitFrame()
 {
+    if (base_headless) {
+        // Nothing to present
+        base_frameNumber++;
+        base_currentFrameIndex = (base_currentFrameIndex + 1) % base_maxFramesInFlight;
+        return;
+    }
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
@@ -212,7 +640,10 @@ void BaseSample::submitFrame()
     presentInfo.pSwapchains = &base_vulkanSwapChain->swapChain;
     presentInfo.pImageIndices = &base_currentImageIndex;
     VkResult result;
+    base_cpuProfiler.beginScope("Present");
     result = vkQueuePresentKHR(base_presentQueue, &presentInfo);
+    base_cpuProfiler.endScope();
+    base_frameNumber++;
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || base_framebufferResized) {
         base_framebufferResized = false;
         recreateSwapChain();
@@ -221,7 +652,7 @@ void BaseSample::submitFrame()
     else if (result != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to present swap chain image!");
     }
-    base_currentFrameIndex = (base_currentFrameIndex + 1) % BASE_MAX_FRAMES_IN_FLIGHT;
+    base_currentFrameIndex = (base_currentFrameIndex + 1) % base_maxFramesInFlight;
 }
 
 void BaseSample::recreateSwapChain()
@@ -244,18 +675,13 @@ void BaseSample::recreateSwapChain()
     // ImGui resources must be recreated
     imguiUI.resize(base_vulkanSwapChain);
 
-    // Depth image
-    if (base_depthImageView) {
-        vkDestroyImageView(base_vulkanDevice->logicalDevice, base_depthImageView, nullptr);
-    }
-    if (base_depthImage) {
-        vmaDestroyImage(base_vmaAllocator, base_depthImage, base_depthImageAllocation);
-    }
-    createDepthImage();
+    // Depth images
+    destroyDepthImages();
+    createDepthImages();
 
     // Framebuffer
     for (auto& swapChainFramebuffer : base_swapChainFramebuffers) {
-        vkDestroyFramebuffer(base_vulkanDevice->logicalDevice, swapChainFramebuffer, nullptr);
+        vkDestroyFramebuffer(base_vulkanDevice->logicalDevice, swapChainFramebuffer, getHostAllocationCallbacks());
     }
     createFramebuffers();
 }
@@ -264,42 +690,54 @@ void BaseSample::finishVulkan()
 {
     vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
+    // Streamed assets not ready yet, waits for the decoding jobs
+    base_assetStreamer.destroy();
+    // Streamed textures, waits for the file loading jobs
+    base_textureStreamer.destroy();
+    // Running defragmentation
+    base_defragmenter.destroy();
+    // Resources released by the last frames, the device is idle
+    base_deferredReleases.flush();
+    // Worker threads
+    base_jobSystem.finish();
     // ImGuiUI resources
     imguiUI.cleanupImGui();
+    // GPU profiler query pools
+    base_gpuProfiler.destroy();
+    // Staging ring and upload command buffers
+    base_uploadManager.destroy();
     // Synchronization objects
     for (auto& imageAvailableSemaphore : base_imageAvailableSemaphores) {
-        vkDestroySemaphore(base_vulkanDevice->logicalDevice, imageAvailableSemaphore, nullptr);
+        vkDestroySemaphore(base_vulkanDevice->logicalDevice, imageAvailableSemaphore, getHostAllocationCallbacks());
     }
     for (auto& renderFinishedSemaphore : base_renderFinishedSemaphores) {
-        vkDestroySemaphore(base_vulkanDevice->logicalDevice, renderFinishedSemaphore, nullptr);
+        vkDestroySemaphore(base_vulkanDevice->logicalDevice, renderFinishedSemaphore, getHostAllocationCallbacks());
     }
     for (auto& inFlightFence : base_inFlightFences) {
-        vkDestroyFence(base_vulkanDevice->logicalDevice, inFlightFence, nullptr);
+        vkDestroyFence(base_vulkanDevice->logicalDevice, inFlightFence, getHostAllocationCallbacks());
     }
+    base_frameTimeline.destroy();
     // Graphics command pool
     if (base_commandPoolGraphics) {
-        vkDestroyCommandPool(base_vulkanDevice->logicalDevice, base_commandPoolGraphics, nullptr);
+        vkDestroyCommandPool(base_vulkanDevice->logicalDevice, base_commandPoolGraphics, getHostAllocationCallbacks());
     }
     // Framebuffers
     for (auto& swapChainFramebuffer : base_swapChainFramebuffers) {
-        vkDestroyFramebuffer(base_vulkanDevice->logicalDevice, swapChainFramebuffer, nullptr);
+        vkDestroyFramebuffer(base_vulkanDevice->logicalDevice, swapChainFramebuffer, getHostAllocationCallbacks());
     }
     // Renderpass
     if (base_renderPass) {
-        vkDestroyRenderPass(base_vulkanDevice->logicalDevice, base_renderPass, nullptr);
-    }
-    // Depth image
-    if (base_depthImageView) {
-        vkDestroyImageView(base_vulkanDevice->logicalDevice, base_depthImageView, nullptr);
-    }
-    if (base_depthImage) {
-        vmaDestroyImage(base_vmaAllocator, base_depthImage, base_depthImageAllocation);
+        vkDestroyRenderPass(base_vulkanDevice->logicalDevice, base_renderPass, getHostAllocationCallbacks());
     }
+    // Depth images
+    destroyDepthImages();
     // Swap chain
     if (base_vulkanSwapChain) {
         delete base_vulkanSwapChain;
     }
 
+    // Memory pools, all their allocations have been freed
+    base_memoryPools.destroy();
     if (base_vmaAllocator) {
         vmaDestroyAllocator(base_vmaAllocator);
     }
@@ -309,15 +747,19 @@ void BaseSample::finishVulkan()
         delete base_vulkanDevice;
     }
     // Surface
-    vkDestroySurfaceKHR(base_instance, base_surface, nullptr);
+    if (base_surface) {
+        vkDestroySurfaceKHR(base_instance, base_surface, getHostAllocationCallbacks());
+    }
     // Debug messenger
     if (ValidationLayers::enabled) {
-        ValidationLayers::DestroyDebugUtilsMessengerEXT(base_instance, base_debugMessenger, nullptr);
+        ValidationLayers::DestroyDebugUtilsMessengerEXT(base_instance, base_debugMessenger, getHostAllocationCallbacks());
     }
     // Instance
-    vkDestroyInstance(base_instance, nullptr);
-    glfwDestroyWindow(base_window);
-    glfwTerminate();
+    vkDestroyInstance(base_instance, getHostAllocationCallbacks());
+    if (!base_headless) {
+        glfwDestroyWindow(base_window);
+        glfwTerminate();
+    }
 }
 
 void BaseSample::initGlfw()
@@ -408,7 +850,7 @@ void BaseSample::createInstance()
     vkEnumerateInstanceExtensionProperties(nullptr, &instanceSupportedExtensionsCount, base_instanceSupportedExtensions.data());
 
     //Create instance
-    VkResult result = vkCreateInstance(&createInfo, nullptr, &base_instance);
+    VkResult result = vkCreateInstance(&createInfo, getHostAllocationCallbacks(), &base_instance);
     if (result != VK_SUCCESS && result != VK_ERROR_EXTENSION_NOT_PRESENT) {
         throw MakeErrorInfo("Instance creation failed!");
     }
@@ -434,7 +876,10 @@ std::vector<const char*> BaseSample::getBaseRequiredInstanceExtensionsNames()
     const char** glfwExtensionsNames = nullptr;
     
     //Requesting the necessary GLFW extensions to create an instance
-    glfwExtensionsNames = glfwGetRequiredInstanceExtensions(&glfwExtensionsCount);
+    //Headless mode doesn't need surface extensions
+    if (!base_headless) {
+        glfwExtensionsNames = glfwGetRequiredInstanceExtensions(&glfwExtensionsCount);
+    }
     std::vector<const char*> requiredExtensions(glfwExtensionsCount);
     for (size_t i = 0; i < glfwExtensionsCount; ++i) {
         requiredExtensions[i] = glfwExtensionsNames[i];
@@ -482,14 +927,14 @@ void BaseSample::setupDebugMessenger()
     createInfo.pfnUserCallback = ValidationLayers::debugCallback;
     createInfo.pUserData = nullptr; // Optional
     
-    if (ValidationLayers::CreateDebugUtilsMessengerEXT(base_instance, &createInfo, nullptr, &base_debugMessenger) != VK_SUCCESS) {
+    if (ValidationLayers::CreateDebugUtilsMessengerEXT(base_instance, &createInfo, getHostAllocationCallbacks(), &base_debugMessenger) != VK_SUCCESS) {
         throw MakeErrorInfo("Debug messenger creation failed!");
     }
 }
 
 void BaseSample::createSurface()
 {
-    if (glfwCreateWindowSurface(base_instance, base_window, nullptr, &base_surface) != VK_SUCCESS) {
+    if (glfwCreateWindowSurface(base_instance, base_window, getHostAllocationCallbacks(), &base_surface) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create window surface!");
     }
 }
@@ -535,10 +980,47 @@ void BaseSample::prepareDevice()
     //LOGICAL DEVICE
 
     // Find and save required queue families indices 
+    // The transfer queue family is used for asynchronous uploads, a dedicated one is preferred
+    if (base_asyncTransfer) {
+        base_sampleDeviceRequirements.base_deviceRequiredQueueFamilyTypes |= VK_QUEUE_TRANSFER_BIT;
+    }
     base_vulkanDevice->findQueueFamilyIndices(base_sampleDeviceRequirements.base_deviceRequiredQueueFamilyTypes, base_surface);
 
+    // Timeline semaphore feature(core in Vulkan 1.2, otherwise VK_KHR_timeline_semaphore)
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    if (base_useTimelineSemaphore) {
+        bool extensionRequired = false;
+        if (TimelineSemaphore::isSupported(base_vulkanDevice->physicalDevice, base_sampleInstanceRequirements.base_instanceApiVersion, extensionRequired)) {
+            timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+            if (extensionRequired) {
+                base_sampleDeviceRequirements.base_deviceEnabledExtensionsNames.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            }
+        }
+        else {
+            std::cerr << "Warning: Timeline semaphores are not supported, fences are used for frame pacing\n";
+            base_useTimelineSemaphore = false;
+        }
+    }
+
+    // Memory budget(VK_KHR_get_physical_device_properties2 is core in Vulkan 1.1)
+    if (base_sampleInstanceRequirements.base_instanceApiVersion >= VK_API_VERSION_1_1 && base_vulkanDevice->checkExtensionsSupport({ VK_EXT_MEMORY_BUDGET_EXTENSION_NAME })) {
+        base_sampleDeviceRequirements.base_deviceEnabledExtensionsNames.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        base_memoryBudgetEnabled = true;
+    }
+
+    // Block compressed formats the KTX2 Basis Universal textures are transcoded to, enabled if supported
+    VkPhysicalDeviceFeatures& enabledFeatures = base_sampleDeviceRequirements.base_deviceEnabledFeatures;
+    enabledFeatures.textureCompressionBC |= base_vulkanDevice->supportedFeatures.textureCompressionBC;
+    enabledFeatures.textureCompressionASTC_LDR |= base_vulkanDevice->supportedFeatures.textureCompressionASTC_LDR;
+    enabledFeatures.textureCompressionETC2 |= base_vulkanDevice->supportedFeatures.textureCompressionETC2;
+
     // Create and save logical device
-    base_vulkanDevice->createLogicalDevice(base_sampleDeviceRequirements.base_deviceEnabledFeatures, base_sampleDeviceRequirements.base_deviceEnabledExtensionsNames);
+    base_vulkanDevice->createLogicalDevice(
+        base_sampleDeviceRequirements.base_deviceEnabledFeatures,
+        base_sampleDeviceRequirements.base_deviceEnabledExtensionsNames,
+        base_useTimelineSemaphore ? &timelineSemaphoreFeatures : nullptr
+    );
 
     // Get device queues
     // Get graphics queue
@@ -566,14 +1048,31 @@ void BaseSample::initVma()
     allocatorCreateInfo.device = base_vulkanDevice->logicalDevice;
     allocatorCreateInfo.instance = base_instance;
     allocatorCreateInfo.vulkanApiVersion = base_sampleInstanceRequirements.base_instanceApiVersion;
+    // Used for the memory, buffer and image objects and VMA's own allocations
+    allocatorCreateInfo.pAllocationCallbacks = getHostAllocationCallbacks();
+    // Real heap usage and budget from the driver instead of the estimate by VMA's own allocations
+    if (base_memoryBudgetEnabled) {
+        allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
 
     vmaCreateAllocator(&allocatorCreateInfo, &base_vmaAllocator);
+    if (base_useMemoryPools) {
+        base_memoryPools.init(base_vmaAllocator);
+    }
+    base_memoryStatistics.init(base_vulkanDevice, base_vmaAllocator, base_memoryBudgetEnabled);
 }
 
 bool BaseSample::getEnabledFeatures(VkPhysicalDevice physicalDevice) { return false; }
 
 void BaseSample::createSwapChain()
 {
+    if (base_headless) {
+        // Ring of offscreen images, one more than frames in flight so that the CPU never waits for the image
+        base_vulkanSwapChain = new VulkanSwapChain(base_vulkanDevice, base_vmaAllocator);
+        base_vulkanSwapChain->createOffscreenImages(base_sampleSwapChainRequirements.base_swapChainPrefferedFormat.format, base_headlessExtent, base_maxFramesInFlight + 1);
+        return;
+    }
+
     // Create swap chain object
     base_vulkanSwapChain = new VulkanSwapChain(base_vulkanDevice, base_surface, base_window);
     
@@ -581,11 +1080,17 @@ void BaseSample::createSwapChain()
     base_vulkanSwapChain->createSwapChain(base_sampleSwapChainRequirements.base_swapChainPrefferedFormat, base_sampleSwapChainRequirements.base_swapChainPrefferedPresentMode);
 }
 
-void BaseSample::createDepthImage()
+void BaseSample::createDepthImages()
 {
     if (!vulkanTools::getSupportedDepthFormat(this->base_vulkanDevice->physicalDevice, &base_depthFormat)) {
         throw MakeErrorInfo("Failed to find supported depth format!");
     }
+    const uint32_t depthImagesCount = base_perFrameDepthImages ? base_maxFramesInFlight : 1;
+    base_depthImages.resize(depthImagesCount);
+    base_depthImagesAllocations.resize(depthImagesCount);
+    base_depthImagesAllocationsInfos.resize(depthImagesCount);
+    base_depthImagesViews.resize(depthImagesCount);
+
     // Fill image info
     VkImageCreateInfo imageCreateInfo{};
     imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -607,25 +1112,43 @@ void BaseSample::createDepthImage()
     allocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
     allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    if(vmaCreateImage(base_vmaAllocator, &imageCreateInfo, &allocationCreateInfo, &base_depthImage, &base_depthImageAllocation, &base_depthImageAllocationInfo) != VK_SUCCESS) {
-        throw MakeErrorInfo("Failed to create depth image");
-    }
+    for (uint32_t i = 0; i < depthImagesCount; i++) {
+        if (vmaCreateImage(base_vmaAllocator, &imageCreateInfo, &allocationCreateInfo, &base_depthImages[i], &base_depthImagesAllocations[i], &base_depthImagesAllocationsInfos[i]) != VK_SUCCESS) {
+            throw MakeErrorInfo("Failed to create depth image");
+        }
 
-    // Create image view
-    VkImageViewCreateInfo imageViewCreateInfo{};
-    imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    imageViewCreateInfo.image = base_depthImage;
-    imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    imageViewCreateInfo.format = base_depthFormat;
-    imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-    imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
-    imageViewCreateInfo.subresourceRange.levelCount = 1;
-    imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
-    imageViewCreateInfo.subresourceRange.layerCount = 1;
+        // Create image view
+        VkImageViewCreateInfo imageViewCreateInfo{};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = base_depthImages[i];
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = base_depthFormat;
+        imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+        imageViewCreateInfo.subresourceRange.levelCount = 1;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(base_vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &base_depthImagesViews[i]) != VK_SUCCESS) {
+            throw MakeErrorInfo("Failed to create depth image view!");
+        }
+    }
+}
 
-    if (vkCreateImageView(base_vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &base_depthImageView) != VK_SUCCESS) {
-        throw MakeErrorInfo("Failed to create depth image view!");
+void BaseSample::destroyDepthImages()
+{
+    for (size_t i = 0; i < base_depthImages.size(); i++) {
+        if (base_depthImagesViews[i]) {
+            vkDestroyImageView(base_vulkanDevice->logicalDevice, base_depthImagesViews[i], getHostAllocationCallbacks());
+        }
+        if (base_depthImages[i]) {
+            vmaDestroyImage(base_vmaAllocator, base_depthImages[i], base_depthImagesAllocations[i]);
+        }
     }
+    base_depthImages.clear();
+    base_depthImagesAllocations.clear();
+    base_depthImagesAllocationsInfos.clear();
+    base_depthImagesViews.clear();
 }
 
 void BaseSample::createRenderPass()
@@ -641,7 +1164,15 @@ void BaseSample::createRenderPass()
     attachmentsDescriptions.back().stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachmentsDescriptions.back().stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     attachmentsDescriptions.back().initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachmentsDescriptions.back().finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    if (base_uiInSceneRenderPass) {
+        // The frame is complete after this render pass
+        // Offscreen images are not presented, they can only be copied somewhere
+        attachmentsDescriptions.back().finalLayout = base_vulkanSwapChain->offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    }
+    else {
+        // The UI render pass loads the image and transitions it to the present layout
+        attachmentsDescriptions.back().finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
     // attachment description [1] - depth image
     attachmentsDescriptions.push_back({ });
     attachmentsDescriptions.back().format = base_depthFormat;
@@ -699,13 +1230,17 @@ void BaseSample::createRenderPass()
     // Depth attachment image subpass depencency
     // We have to wait until another frame (rendered in parallel and using the same depth image)
     // finishes its operations with the depth image
-    subpassDependencies.push_back({ });
-    subpassDependencies.back().srcSubpass = VK_SUBPASS_EXTERNAL;
-    subpassDependencies.back().dstSubpass = 0;
-    subpassDependencies.back().srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-    subpassDependencies.back().srcAccessMask = 0;
-    subpassDependencies.back().dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-    subpassDependencies.back().dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    // With per-frame depth images it is not needed: the depth image of this frame was last used
+    // base_maxFramesInFlight frames ago and its in flight fence has already been waited
+    if (!base_perFrameDepthImages) {
+        subpassDependencies.push_back({ });
+        subpassDependencies.back().srcSubpass = VK_SUBPASS_EXTERNAL;
+        subpassDependencies.back().dstSubpass = 0;
+        subpassDependencies.back().srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        subpassDependencies.back().srcAccessMask = 0;
+        subpassDependencies.back().dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        subpassDependencies.back().dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
 
     // Create renderpass
     VkRenderPassCreateInfo renderpassCreateInfo{};
@@ -718,7 +1253,7 @@ void BaseSample::createRenderPass()
     renderpassCreateInfo.pDependencies = subpassDependencies.data();
 
     VkResult result;
-    result = vkCreateRenderPass(base_vulkanDevice->logicalDevice, &renderpassCreateInfo, nullptr, &base_renderPass);
+    result = vkCreateRenderPass(base_vulkanDevice->logicalDevice, &renderpassCreateInfo, getHostAllocationCallbacks(), &base_renderPass);
     if (result != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create renderpass!");
     }
@@ -726,29 +1261,39 @@ void BaseSample::createRenderPass()
 
 void BaseSample::createFramebuffers()
 {
-    base_swapChainFramebuffers.resize(base_vulkanSwapChain->imagesViews.size());
-
-    for (size_t i = 0; i < base_vulkanSwapChain->imagesViews.size(); i++) {
-        std::vector<VkImageView> attachments = {
-            base_vulkanSwapChain->imagesViews[i],
-            base_depthImageView
-        };
-
-        VkFramebufferCreateInfo framebufferCreateInfo{};
-        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferCreateInfo.renderPass = base_renderPass;
-        framebufferCreateInfo.attachmentCount = attachments.size();
-        framebufferCreateInfo.pAttachments = attachments.data();
-        framebufferCreateInfo.width = base_vulkanSwapChain->surfaceExtent.width;
-        framebufferCreateInfo.height = base_vulkanSwapChain->surfaceExtent.height;
-        framebufferCreateInfo.layers = 1;
-
-        if (vkCreateFramebuffer(base_vulkanDevice->logicalDevice, &framebufferCreateInfo, nullptr, &base_swapChainFramebuffers[i]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to create framebuffers!");
+    // Framebuffers are stored as [depth image index][swap chain image index]
+    const size_t imagesCount = base_vulkanSwapChain->imagesViews.size();
+    base_swapChainFramebuffers.resize(base_depthImagesViews.size() * imagesCount);
+
+    for (size_t depthIndex = 0; depthIndex < base_depthImagesViews.size(); depthIndex++) {
+        for (size_t i = 0; i < imagesCount; i++) {
+            std::vector<VkImageView> attachments = {
+                base_vulkanSwapChain->imagesViews[i],
+                base_depthImagesViews[depthIndex]
+            };
+
+            VkFramebufferCreateInfo framebufferCreateInfo{};
+            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferCreateInfo.renderPass = base_renderPass;
+            framebufferCreateInfo.attachmentCount = attachments.size();
+            framebufferCreateInfo.pAttachments = attachments.data();
+            framebufferCreateInfo.width = base_vulkanSwapChain->surfaceExtent.width;
+            framebufferCreateInfo.height = base_vulkanSwapChain->surfaceExtent.height;
+            framebufferCreateInfo.layers = 1;
+
+            if (vkCreateFramebuffer(base_vulkanDevice->logicalDevice, &framebufferCreateInfo, getHostAllocationCallbacks(), &base_swapChainFramebuffers[depthIndex * imagesCount + i]) != VK_SUCCESS) {
+                throw MakeErrorInfo("Failed to create framebuffers!");
+            }
         }
     }
 }
 
+VkFramebuffer BaseSample::getFramebuffer(uint32_t frameIndex, uint32_t imageIndex)
+{
+    const uint32_t depthIndex = base_perFrameDepthImages ? frameIndex : 0;
+    return base_swapChainFramebuffers[depthIndex * base_vulkanSwapChain->imagesViews.size() + imageIndex];
+}
+
 void BaseSample::createCommandPoolGraphics()
 {
     VkCommandPoolCreateInfo commandPoolCreateInfo{};
@@ -756,14 +1301,14 @@ void BaseSample::createCommandPoolGraphics()
     commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     commandPoolCreateInfo.queueFamilyIndex = base_vulkanDevice->queueFamilyIndices.graphics.value();
 
-    if (vkCreateCommandPool(base_vulkanDevice->logicalDevice, &commandPoolCreateInfo, nullptr, &base_commandPoolGraphics) != VK_SUCCESS) {
+    if (vkCreateCommandPool(base_vulkanDevice->logicalDevice, &commandPoolCreateInfo, getHostAllocationCallbacks(), &base_commandPoolGraphics) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create graphics command pool!");
     }
 }
 
 void BaseSample::createCommandBuffersGraphics()
 {
-    base_commandBuffersGraphics.resize(BASE_MAX_FRAMES_IN_FLIGHT);
+    base_commandBuffersGraphics.resize(base_maxFramesInFlight);
 
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -779,9 +1324,17 @@ void BaseSample::createCommandBuffersGraphics()
 
 void BaseSample::createSyncObjects()
 {
-    base_imageAvailableSemaphores.resize(BASE_MAX_FRAMES_IN_FLIGHT);
-    base_renderFinishedSemaphores.resize(BASE_MAX_FRAMES_IN_FLIGHT);
-    base_inFlightFences.resize(BASE_MAX_FRAMES_IN_FLIGHT);
+    base_imageAvailableSemaphores.resize(base_maxFramesInFlight);
+    base_renderFinishedSemaphores.resize(base_maxFramesInFlight);
+    if (base_useTimelineSemaphore) {
+        // Value 0 is already reached, the first frames don't wait
+        base_frameTimeline.create(base_vulkanDevice, 0);
+    }
+    else {
+        base_inFlightFences.resize(base_maxFramesInFlight);
+    }
+    base_frameTimelineValues.assign(base_maxFramesInFlight, 0);
+    base_completedFrameValue = 0;
 
     VkSemaphoreCreateInfo semaphoreCreateInfo{};
     semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -790,10 +1343,10 @@ void BaseSample::createSyncObjects()
     fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (uint32_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; i++) {
-        if (vkCreateSemaphore(base_vulkanDevice->logicalDevice, &semaphoreCreateInfo, nullptr, &base_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(base_vulkanDevice->logicalDevice, &semaphoreCreateInfo, nullptr, &base_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(base_vulkanDevice->logicalDevice, &fenceCreateInfo, nullptr, &base_inFlightFences[i]) != VK_SUCCESS) {
+    for (uint32_t i = 0; i < base_maxFramesInFlight; i++) {
+        if (vkCreateSemaphore(base_vulkanDevice->logicalDevice, &semaphoreCreateInfo, getHostAllocationCallbacks(), &base_imageAvailableSemaphores[i]) != VK_SUCCESS ||
+            vkCreateSemaphore(base_vulkanDevice->logicalDevice, &semaphoreCreateInfo, getHostAllocationCallbacks(), &base_renderFinishedSemaphores[i]) != VK_SUCCESS ||
+            (!base_useTimelineSemaphore && vkCreateFence(base_vulkanDevice->logicalDevice, &fenceCreateInfo, getHostAllocationCallbacks(), &base_inFlightFences[i]) != VK_SUCCESS)) {
             throw MakeErrorInfo("Failed to create synchronization objects for a frame!");
         }
     }
@@ -802,11 +1355,69 @@ void BaseSample::createSyncObjects()
 void BaseSample::setupSubmitInfo(uint32_t currentFrameIndex)
 {
     base_submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    base_submitInfo.pNext = nullptr;
     base_submitInfo.pWaitDstStageMask = base_submittingWaitStages.data();
-    base_submitInfo.waitSemaphoreCount = 1;
-    base_submitInfo.pWaitSemaphores = &base_imageAvailableSemaphores[currentFrameIndex];
-    base_submitInfo.signalSemaphoreCount = 1;
-    base_submitInfo.pSignalSemaphores = &base_renderFinishedSemaphores[currentFrameIndex];
+    base_submitWaitSemaphores.clear();
+    base_submitSignalSemaphores.clear();
+    // In headless mode there is no acquire and no present, nothing to wait and nothing to signal
+    if (!base_headless) {
+        base_submitWaitSemaphores.push_back(base_imageAvailableSemaphores[currentFrameIndex]);
+        base_submitSignalSemaphores.push_back(base_renderFinishedSemaphores[currentFrameIndex]);
+    }
+    base_frameTimelineValues[currentFrameIndex] = getFrameTimelineValue();
+    if (base_useTimelineSemaphore) {
+        base_submitSignalSemaphores.push_back(base_frameTimeline.semaphore);
+        // Values for binary semaphores are ignored
+        base_submitWaitValues.assign(base_submitWaitSemaphores.size(), 0);
+        base_submitSignalValues.assign(base_submitSignalSemaphores.size(), 0);
+        base_submitSignalValues.back() = base_frameTimelineValues[currentFrameIndex];
+
+        base_timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        base_timelineSubmitInfo.waitSemaphoreValueCount = base_submitWaitValues.size();
+        base_timelineSubmitInfo.pWaitSemaphoreValues = base_submitWaitValues.data();
+        base_timelineSubmitInfo.signalSemaphoreValueCount = base_submitSignalValues.size();
+        base_timelineSubmitInfo.pSignalSemaphoreValues = base_submitSignalValues.data();
+        base_submitInfo.pNext = &base_timelineSubmitInfo;
+    }
+    base_submitInfo.waitSemaphoreCount = base_submitWaitSemaphores.size();
+    base_submitInfo.pWaitSemaphores = base_submitWaitSemaphores.data();
+    base_submitInfo.signalSemaphoreCount = base_submitSignalSemaphores.size();
+    base_submitInfo.pSignalSemaphores = base_submitSignalSemaphores.data();
+}
+
+VkFence BaseSample::getFrameFence()
+{
+    if (base_useTimelineSemaphore) {
+        return VK_NULL_HANDLE;
+    }
+    return base_inFlightFences[base_currentFrameIndex];
+}
+
+uint64_t BaseSample::getFrameTimelineValue()
+{
+    // base_frameNumber is incremented after the frame is submitted, so the values grow with every frame
+    return base_frameNumber + 1;
+}
+
+uint64_t BaseSample::getCompletedFrameValue()
+{
+    return base_completedFrameValue;
+}
+
+void BaseSample::updateCompletedFrameValue()
+{
+    if (base_useTimelineSemaphore) {
+        base_completedFrameValue = base_frameTimeline.getCompletedValue();
+        return;
+    }
+    // The frames are completed in submission order, the biggest value of a signaled fence is the completed value
+    // The fence of a slot is reset only right before its submission, so an unsignaled fence always belongs to a frame in flight
+    for (uint32_t i = 0; i < base_maxFramesInFlight; i++) {
+        if (base_frameTimelineValues[i] > base_completedFrameValue &&
+            vkGetFenceStatus(base_vulkanDevice->logicalDevice, base_inFlightFences[i]) == VK_SUCCESS) {
+            base_completedFrameValue = base_frameTimelineValues[i];
+        }
+    }
 }
 
 void BaseSample::drawUI() {};
@@ -23,6 +23,20 @@
 #include "Helpers/VulkanglTFModel.h"
 #include "Helpers/ImGuiUI.h"
 #include "Helpers/UIOverlay.hpp"
+#include "Helpers/FrameResourceRing.hpp"
+#include "Helpers/GpuProfiler.h"
+#include "Helpers/CpuProfiler.h"
+#include "Helpers/Benchmark.h"
+#include "Helpers/TimelineSemaphore.h"
+#include "Helpers/DeferredReleaseQueue.h"
+#include "Helpers/JobSystem.h"
+#include "Helpers/SecondaryCommandRecorder.h"
+#include "Helpers/UploadManager.h"
+#include "Helpers/AssetStreamer.h"
+#include "Helpers/TextureStreamer.h"
+#include "Helpers/MemoryStatistics.h"
+#include "Helpers/Defragmenter.h"
+#include "Helpers/MemoryPools.h"
 
 const std::string ASSETS_DATA_PATH = "../../data/";
 const std::string ASSETS_DATA_SHADERS_PATH = "../../data/shaders/";
@@ -43,6 +57,8 @@ public:
     double                              base_frameTime = 0;
     // Time it took to get glfw events(glfwPoolEvents()), is used to fix for increased frametime
     double                              base_lastEventsPoolTime = 0;
+    // Time the CPU waited for the fence of the current frame(in milliseconds)
+    double                              base_lastFenceWaitTime = 0;
 
     Camera                              base_camera;
     glm::vec2                           base_cursorPos{};
@@ -50,6 +66,16 @@ public:
     glm::vec2                           base_mouseSensitivity{ 1.0f / 6, 1.0f / 6 };
     float                               base_mouseScrollSensitivity = 0.25f;
 
+    // Headless mode(--headless): no window, no surface and no presentation
+    // Frames are rendered into a ring of offscreen images instead of swap chain images
+    bool                                base_headless = false;
+    // Size of offscreen images in headless mode(--width, --height)
+    VkExtent2D                          base_headlessExtent{ 1280, 720 };
+    // Number of frames rendered in headless mode before the render loop ends(--frames), 0 - endless
+    uint64_t                            base_headlessFrameCount = 1000;
+    // Number of frames submitted since the start
+    uint64_t                            base_frameNumber = 0;
+
     // Sample should set its requirements
 
     // App title (setting up by sample)
@@ -115,17 +141,23 @@ public:
     VkRenderPass                        base_renderPass = VK_NULL_HANDLE;
 
     // Framebuffers for swap chain images
+    // With per-frame depth images there is a framebuffer for each (frame, swap chain image) pair, use getFramebuffer()
     std::vector<VkFramebuffer>          base_swapChainFramebuffers;
 
     // Vulkan Memory Allocator
     VmaAllocator                        base_vmaAllocator;
 
-    // Depth image and VMA allocation data
+    // Use one depth image per frame in flight(setting up by sample or --per-frame-depth)
+    // A single depth image is shared by all frames, so the next frame can't start its depth tests until the previous one finished them
+    // Separate depth images remove this dependency and consecutive frames can overlap on the GPU
+    bool                                base_perFrameDepthImages = false;
+
+    // Depth images(one or base_maxFramesInFlight) and VMA allocation data
     VkFormat                            base_depthFormat = VK_FORMAT_UNDEFINED;
-    VkImage                             base_depthImage = VK_NULL_HANDLE;
-    VmaAllocation                       base_depthImageAllocation = 0;
-    VmaAllocationInfo                   base_depthImageAllocationInfo{};
-    VkImageView                         base_depthImageView = VK_NULL_HANDLE;
+    std::vector<VkImage>                base_depthImages;
+    std::vector<VmaAllocation>          base_depthImagesAllocations;
+    std::vector<VmaAllocationInfo>      base_depthImagesAllocationsInfos;
+    std::vector<VkImageView>            base_depthImagesViews;
 
     // Command pool for graphics commands(use graphical queue family)
     // Spec says: All command buffers allocated from this command pool must be submitted on queues from the same queue family
@@ -134,8 +166,10 @@ public:
     // Command buffers for graphics operation allocated from graphics command pool
     std::vector<VkCommandBuffer>        base_commandBuffersGraphics;
 
-    // The number of frames that can be rendered in parallel
-    #define BASE_MAX_FRAMES_IN_FLIGHT 2
+    // The number of frames that can be rendered in parallel(setting up by sample or --frames-in-flight)
+    // More frames - the CPU waits less for the GPU, but the latency is higher
+    #define BASE_MAX_FRAMES_IN_FLIGHT_LIMIT 4
+    uint32_t base_maxFramesInFlight = 2;
 
     // Current frame index(NOT CURRENT SWAP CHAIN IMAGE INDEX)
     uint32_t base_currentFrameIndex = 0;
@@ -150,20 +184,114 @@ public:
     std::vector<VkSemaphore> base_renderFinishedSemaphores;
 
     // We can start rendering the frame(and record to command buffer)
+    // Not created if the timeline semaphore is used
     std::vector<VkFence> base_inFlightFences;
 
+    // Track frame completion with a single timeline semaphore instead of fences(setting up by sample or --timeline-semaphore)
+    // Requires Vulkan 1.2 or VK_KHR_timeline_semaphore, if not supported the fences are used
+    // Each frame signals getFrameTimelineValue(), so a resource used by a frame can be reused
+    // when base_frameTimeline.isCompleted(value) without blocking, and other queues can wait for an exact frame
+    bool base_useTimelineSemaphore = false;
+    TimelineSemaphore base_frameTimeline;
+    // Frame value(getFrameTimelineValue()) of the last submission of each frame in flight, set with fences too
+    std::vector<uint64_t> base_frameTimelineValues;
+    // All frames up to this value have been completed, updated without blocking at the start of each frame
+    // (the timeline counter or the signaled fences of the frames in flight)
+    uint64_t base_completedFrameValue = 0;
+
+    // Releases of resources used by the frames in flight(old images, descriptor sets, etc.), pushed with the frame value
+    // of the last frame that may use them and called at the start of the frame after that frame has been completed
+    DeferredReleaseQueue base_deferredReleases;
+
     // Submit info struct for graphics command buffers submitting
     VkSubmitInfo base_submitInfo{};
+    // Semaphores and timeline values referenced by base_submitInfo
+    VkTimelineSemaphoreSubmitInfo base_timelineSubmitInfo{};
+    std::vector<VkSemaphore> base_submitWaitSemaphores;
+    std::vector<VkSemaphore> base_submitSignalSemaphores;
+    std::vector<uint64_t> base_submitWaitValues;
+    std::vector<uint64_t> base_submitSignalValues;
 
     // Specify which stages to wait on before command buffer execution begins
     std::vector<VkPipelineStageFlags> base_submittingWaitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
+    // GPU timestamp profiler
+    // Samples wrap their passes into named scopes, the results are available base_maxFramesInFlight frames later
+    GpuProfiler base_gpuProfiler;
+
+    // CPU profiler of frame phases(fence wait, acquire, recording, submit, present, etc.)
+    CpuProfiler base_cpuProfiler;
+    // Chrome trace file, it is written by F12 key or at exit if --trace is set
+    std::string base_traceFilePath = "trace.json";
+    bool base_writeTraceAtExit = false;
+
+    // Benchmark mode(--benchmark), replaces the usual render loop
+    Benchmark base_benchmark;
+
+    // Work-stealing job system for samples(parallel loading, command buffers recording, etc.)
+    JobSystem base_jobSystem;
+    // Number of worker threads(--threads), 0 - one per hardware thread except the main one
+    uint32_t base_workerThreadCount = 0;
+
+    // Batched staging uploads of buffers and images(textures, models)
+    // The recorded uploads are submitted at the start of each frame, before the frame commands
+    UploadManager base_uploadManager;
+    // Submit uploads to the dedicated transfer queue(if the device has one) with the ownership transfer
+    // to the graphics queue, rendering doesn't wait for them(--no-async-transfer disables)
+    // Uploads recorded during the preparation are waited before the first frame
+    bool base_asyncTransfer = true;
+
+    // Background loading of models and textures, the loaded assets are swapped in at the start of a frame
+    // Samples draw placeholders until the assets are ready, so the first frame doesn't wait for loading
+    AssetStreamer base_assetStreamer;
+
+    // Mip level streaming of KTX textures under a device memory budget(--texture-budget <MB>, memoryBudget can be changed at any time)
+    // A sample requests the levels it needs every frame(see TextureMapping), the images are replaced at the start of a frame
+    // and the old ones are released through base_deferredReleases
+    TextureStreamer base_textureStreamer;
+
+    // Per-category VMA pools(static geometry, textures, per-frame, staging), the settings can be changed before initVulkan()
+    // Used by the upload manager, the asset streamer and the samples(--no-memory-pools disables, default pools are used)
+    MemoryPools base_memoryPools;
+    bool base_useMemoryPools = true;
+
+    // Count the host memory allocated by the Vulkan implementation per allocation scope(--host-allocations),
+    // --pooled-host-allocations also serves the small allocations from free lists
+    bool base_trackHostAllocations = false;
+    bool base_pooledHostAllocations = false;
+
+    // VMA allocator is created with VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT(VK_EXT_memory_budget is supported)
+    bool base_memoryBudgetEnabled = false;
+    // Memory heaps usage, budget and fragmentation, updated every frame
+    MemoryStatistics base_memoryStatistics;
+    // Memory statistics window(F10 key toggles)
+    bool base_showMemoryStatistics = false;
+    // Detailed VMA statistics JSON file, it is written by F11 key or at exit if --memory-stats is set
+    std::string base_memoryStatisticsFilePath = "memory_stats.json";
+    bool base_writeMemoryStatisticsAtExit = false;
+
+    // Incremental defragmentation of the registered resources(e.g. glTF models), one pass of moves per few frames
+    // Started by F9 key or automatically if --defragment is set and a heap is fragmented more than the threshold
+    Defragmenter base_defragmenter;
+    bool base_autoDefragmentation = false;
+    float base_defragmentationThreshold = 0.25f;
+    // Minimum number of frames between the automatic starts, not movable allocations may keep the heap fragmented
+    uint64_t base_defragmentationInterval = 300;
+    uint64_t base_lastDefragmentationFrame = 0;
+
     // ImGuiUI object
     ImGuiUI imguiUI;
+    // Draw the UI at the end of the scene render pass(setting up by sample, --separate-ui-pass disables)
+    // Saves a render pass that loads and stores the whole color image again and a command buffer per frame
+    // Otherwise the UI is drawn in its own render pass and submitted in a second command buffer
+    bool base_uiInSceneRenderPass = true;
 public:
     BaseSample();
     virtual ~BaseSample();
 
+    // Parse base command line arguments, is called before initVulkan()
+    void parseCommandLineArgs(int argc, char* argv[]);
+
     void initVulkan();
 
     // Always redefined by the sample
@@ -171,15 +299,36 @@ public:
 
     void renderLoop();
 
+    // Render loop of the benchmark mode, writes the results at the end
+    void runBenchmark();
+
+    // Moves the camera along the fixed benchmark path
+    void updateBenchmarkCamera();
+
+    // Write CPU profiler scopes to base_traceFilePath
+    void writeTrace();
+    // Write vmaBuildStatsString() JSON to base_memoryStatisticsFilePath
+    void writeMemoryStatistics();
+
     void nextFrame();
 
-    // Acquire image
+    // Acquire image(in headless mode takes the next offscreen image)
     void prepareFrame();
 
     // Always redefined by the sample
     virtual void draw();
 
-    // Present image to the swap chain
+    // Builds the UI of the frame(drawUI()), must be called before recordUI()
+    void buildUI();
+
+    // Records the UI into the command buffer inside the scene render pass
+    // Does nothing if the UI has its own render pass
+    void recordUI(VkCommandBuffer commandBuffer);
+
+    // Submits the scene command buffer of the frame(and the UI command buffer if the UI has its own render pass)
+    void submitFrameCommandBuffer(VkCommandBuffer commandBuffer);
+
+    // Present image to the swap chain(in headless mode nothing is presented)
     void submitFrame();
 
     // Recreate swapchain(window resize)
@@ -220,8 +369,10 @@ public:
     // Create image views
     void createSwapChain();
 
-    // Create depth image
-    void createDepthImage();
+    // Create depth images
+    void createDepthImages();
+
+    void destroyDepthImages();
 
     // Create general render pass
     void createRenderPass();
@@ -229,6 +380,9 @@ public:
     // Create framebuffers
     void createFramebuffers();
 
+    // Returns the framebuffer for the frame in flight and the swap chain image
+    VkFramebuffer getFramebuffer(uint32_t frameIndex, uint32_t imageIndex);
+
     // Create command pool for graphics command pool
     void createCommandPoolGraphics();
 
@@ -243,6 +397,16 @@ public:
     // Command buffer submission info is set by each example
     void setupSubmitInfo(uint32_t currentFrameIndex);
 
+    // Fence to pass to vkQueueSubmit() for the current frame, VK_NULL_HANDLE if the timeline semaphore is used
+    VkFence getFrameFence();
+
+    // Timeline value signaled when the current frame has been completed
+    uint64_t getFrameTimelineValue();
+    // base_completedFrameValue, non-blocking
+    uint64_t getCompletedFrameValue();
+    // Updates base_completedFrameValue from the timeline counter or the fences of the frames in flight
+    void updateCompletedFrameValue();
+
     virtual void drawUI();
 
     void finishVulkan();
@@ -254,6 +418,7 @@ int main(int argc, char* argv[])                                            \
     try                                                                     \
     {                                                                       \
         class_name* sample = new class_name();                              \
+        sample->parseCommandLineArgs(argc, argv);                           \
         sample->initVulkan();                                               \
         sample->prepare();                                                  \
         sample->renderLoop();                                               \
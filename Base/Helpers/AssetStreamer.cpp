@@ -0,0 +1,306 @@
+#include "AssetStreamer.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+StreamedAsset::State StreamedAsset::getState() const
+{
+    return state.load();
+}
+
+bool StreamedAsset::isReady() const
+{
+    return state.load() == State::Ready;
+}
+
+bool StreamedAsset::isFailed() const
+{
+    return state.load() == State::Failed;
+}
+
+const std::string& StreamedAsset::getError() const
+{
+    return error;
+}
+
+uint32_t StreamedAsset::getDecodePartCount() const
+{
+    return 0;
+}
+
+void StreamedAsset::decodePart(uint32_t /*partIndex*/)
+{
+}
+
+vulkanglTF::Model* StreamedModel::get() const
+{
+    return isReady() ? model.get() : nullptr;
+}
+
+void StreamedModel::decode()
+{
+    vulkanglTF::Model::parseglTFFile(filePath, gltfModel, encodedImages);
+    if (fileLoadingFlags & vulkanglTF::FileLoadingFlags::DontLoadImages) {
+        encodedImages.clear();
+    }
+}
+
+uint32_t StreamedModel::getDecodePartCount() const
+{
+    return static_cast<uint32_t>(encodedImages.size());
+}
+
+void StreamedModel::decodePart(uint32_t partIndex)
+{
+    vulkanglTF::Model::decodeImage(gltfModel, encodedImages[partIndex]);
+}
+
+void StreamedModel::createResources(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager& uploadManager, const MemoryPools* memoryPools)
+{
+    model = std::make_unique<vulkanglTF::Model>(vulkanDevice, &uploadManager, vmaAllocator);
+    model->memoryPools = memoryPools;
+    model->loadFromglTFModel(gltfModel, fileLoadingFlags, globalScale);
+    // The data has been copied to the staging memory
+    gltfModel = tinygltf::Model();
+    encodedImages.clear();
+}
+
+StreamedTexture::~StreamedTexture()
+{
+    if (loadedKTXTexture) {
+        ktxTexture_Destroy(loadedKTXTexture);
+    }
+    texture.destroy();
+}
+
+VulkanTexture2D* StreamedTexture::get()
+{
+    return isReady() ? &texture : nullptr;
+}
+
+void StreamedTexture::decode()
+{
+    loadedKTXTexture = VulkanTexture2D::loadKTXFile(filePath, vulkanDevice);
+}
+
+void StreamedTexture::createResources(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager& uploadManager, const MemoryPools* memoryPools)
+{
+    texture.setDeviceAndAllocator(vulkanDevice, vmaAllocator);
+    VmaPool texturesPool = memoryPools ? memoryPools->getPool(MemoryPools::Category::Textures) : nullptr;
+    texture.createTextureFromKTX(uploadManager, loadedKTXTexture, filter, imageUsageFlags, imageLayout, texturesPool);
+    // The data has been copied to the staging memory
+    ktxTexture_Destroy(loadedKTXTexture);
+    loadedKTXTexture = nullptr;
+}
+
+void AssetStreamer::init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager* uploadManager, JobSystem* jobSystem, const MemoryPools* memoryPools)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->uploadManager = uploadManager;
+    this->jobSystem = jobSystem;
+    this->memoryPools = memoryPools;
+    stopping = false;
+}
+
+void AssetStreamer::destroy()
+{
+    if (!jobSystem) {
+        return;
+    }
+    // A file being decoded can't be interrupted, the queued ones are skipped
+    stopping = true;
+    jobSystem->wait(decodeTaskGroup);
+    decodedAssets.clear();
+    uploadingAssets.clear();
+    pendingAssets = 0;
+    jobSystem = nullptr;
+}
+
+std::shared_ptr<StreamedModel> AssetStreamer::loadModel(std::string filePath, uint32_t fileLoadingFlags, float globalScale, std::function<void()> finishedCallback)
+{
+    std::shared_ptr<StreamedModel> model = std::make_shared<StreamedModel>();
+    model->filePath = filePath;
+    model->fileLoadingFlags = fileLoadingFlags;
+    model->globalScale = globalScale;
+    model->finishedCallback = std::move(finishedCallback);
+    startDecoding(model);
+    return model;
+}
+
+std::shared_ptr<StreamedTexture> AssetStreamer::loadTextureKTX(std::string filePath, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout, std::function<void()> finishedCallback)
+{
+    std::shared_ptr<StreamedTexture> texture = std::make_shared<StreamedTexture>();
+    texture->filePath = filePath;
+    texture->vulkanDevice = vulkanDevice;
+    texture->filter = filter;
+    texture->imageUsageFlags = imageUsageFlags;
+    texture->imageLayout = imageLayout;
+    texture->finishedCallback = std::move(finishedCallback);
+    startDecoding(texture);
+    return texture;
+}
+
+void AssetStreamer::update()
+{
+    // Uploads checked first, so an asset created this frame is never ready before its batch has been submitted
+    finishUploadedAssets();
+    createDecodedAssets(maxAssetsCreatedPerFrame);
+}
+
+void AssetStreamer::waitIdle()
+{
+    // Callbacks may start loading other assets
+    while (!isIdle()) {
+        jobSystem->wait(decodeTaskGroup);
+        createDecodedAssets(UINT32_MAX);
+        uploadManager->waitIdle();
+        finishUploadedAssets();
+    }
+}
+
+bool AssetStreamer::isIdle() const
+{
+    return pendingAssets == 0;
+}
+
+uint32_t AssetStreamer::getPendingAssetCount() const
+{
+    return pendingAssets;
+}
+
+void AssetStreamer::startDecoding(std::shared_ptr<StreamedAsset> asset)
+{
+    if (!jobSystem) {
+        throw MakeErrorInfo("AssetStreamer: not initialized!");
+    }
+    pendingAssets++;
+    // The job holds a reference, the asset outlives the decoding even if the caller releases the handle
+    jobSystem->runBackground(decodeTaskGroup, [this, asset](uint32_t) {
+        if (stopping) {
+            return;
+        }
+        runDecodeStep(*asset, [&asset]() { asset->decode(); });
+        if (asset->state != StreamedAsset::State::Failed && asset->getDecodePartCount() > 0) {
+            startDecodingParts(asset);
+        }
+        else {
+            finishDecoding(asset);
+        }
+    });
+}
+
+void AssetStreamer::startDecodingParts(std::shared_ptr<StreamedAsset> asset)
+{
+    uint32_t partCount = asset->getDecodePartCount();
+    asset->remainingDecodeParts = partCount;
+    // Background jobs can't wait, so the last finished part passes the asset on
+    for (uint32_t i = 0; i < partCount; i++) {
+        jobSystem->runBackground(decodeTaskGroup, [this, asset, i](uint32_t) {
+            // The remaining parts are skipped if a part has failed
+            if (!stopping && asset->state != StreamedAsset::State::Failed) {
+                runDecodeStep(*asset, [&asset, i]() { asset->decodePart(i); });
+            }
+            if (asset->remainingDecodeParts.fetch_sub(1) == 1) {
+                finishDecoding(asset);
+            }
+        });
+    }
+}
+
+void AssetStreamer::runDecodeStep(StreamedAsset& asset, const std::function<void()>& step)
+{
+    std::string error;
+    try {
+        step();
+        return;
+    }
+    catch (const ErrorInfo& errorInfo) {
+        error = errorInfo.what;
+    }
+    catch (const std::exception& exception) {
+        error = exception.what();
+    }
+    // Parts may fail at the same time
+    std::lock_guard<std::mutex> lock(decodedAssetsMutex);
+    if (asset.state != StreamedAsset::State::Failed) {
+        asset.error = error;
+        asset.state = StreamedAsset::State::Failed;
+    }
+}
+
+void AssetStreamer::finishDecoding(std::shared_ptr<StreamedAsset> asset)
+{
+    std::lock_guard<std::mutex> lock(decodedAssetsMutex);
+    if (asset->state != StreamedAsset::State::Failed) {
+        asset->state = StreamedAsset::State::Decoded;
+    }
+    decodedAssets.push_back(std::move(asset));
+}
+
+void AssetStreamer::createDecodedAssets(uint32_t maxCount)
+{
+    for (uint32_t i = 0; i < maxCount; i++) {
+        std::shared_ptr<StreamedAsset> asset;
+        {
+            std::lock_guard<std::mutex> lock(decodedAssetsMutex);
+            if (decodedAssets.empty()) {
+                return;
+            }
+            asset = std::move(decodedAssets.front());
+            decodedAssets.pop_front();
+        }
+        if (asset->state == StreamedAsset::State::Failed) {
+            finish(*asset, StreamedAsset::State::Failed);
+            continue;
+        }
+        std::string error;
+        try {
+            asset->createResources(vulkanDevice, vmaAllocator, *uploadManager, memoryPools);
+        }
+        catch (const ErrorInfo& errorInfo) {
+            error = errorInfo.what;
+        }
+        catch (const std::exception& exception) {
+            error = exception.what();
+        }
+        // The uploads are submitted by the next flush of the upload manager
+        asset->uploadValue = uploadManager->getRecordingValue();
+        if (!error.empty()) {
+            asset->error = error;
+            finish(*asset, StreamedAsset::State::Failed);
+        }
+        else {
+            asset->state = StreamedAsset::State::Uploading;
+        }
+        // The copies of the resources created before the failure are recorded too, the asset is kept until they have been completed
+        uploadingAssets.push_back(std::move(asset));
+    }
+}
+
+void AssetStreamer::finishUploadedAssets()
+{
+    for (size_t i = 0; i < uploadingAssets.size();) {
+        if (uploadManager->isCompleted(uploadingAssets[i]->uploadValue)) {
+            std::shared_ptr<StreamedAsset> asset = std::move(uploadingAssets[i]);
+            uploadingAssets.erase(uploadingAssets.begin() + i);
+            // Failed assets have already been finished
+            if (asset->state != StreamedAsset::State::Failed) {
+                finish(*asset, StreamedAsset::State::Ready);
+            }
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void AssetStreamer::finish(StreamedAsset& asset, StreamedAsset::State state)
+{
+    asset.state = state;
+    pendingAssets--;
+    // The callback usually captures the handle, it is released here
+    std::function<void()> finishedCallback = std::move(asset.finishedCallback);
+    asset.finishedCallback = nullptr;
+    if (finishedCallback) {
+        finishedCallback();
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+#include "VulkanTexture.h"
+#include "VulkanglTFModel.h"
+#include "UploadManager.h"
+#include "MemoryPools.h"
+#include "JobSystem.h"
+#include "vk_mem_alloc.h"
+
+// Asset loaded by AssetStreamer, the handle is returned at once and becomes ready later
+// Decoding state -> Decoded -> Uploading -> Ready(or Failed if the file can't be loaded or its resources can't be created)
+class StreamedAsset
+{
+public:
+    enum class State { Decoding, Decoded, Uploading, Ready, Failed };
+
+private:
+    friend class AssetStreamer;
+
+    std::atomic<State>      state = State::Decoding;
+    std::string             error;
+    // Upload batch of the resources
+    uint64_t                uploadValue = 0;
+    // Called on the main thread when the asset becomes ready or fails
+    std::function<void()>   finishedCallback;
+    // Parts left to decode, the asset is decoded when the last one has been finished
+    std::atomic<uint32_t>   remainingDecodeParts = 0;
+
+public:
+    virtual ~StreamedAsset() = default;
+
+    State getState() const;
+    // The resources can be used by the commands recorded from now on
+    bool isReady() const;
+    bool isFailed() const;
+    // Error message of the failed asset
+    const std::string& getError() const;
+
+protected:
+    // Reads and decodes the file on a worker thread, doesn't use Vulkan
+    virtual void decode() = 0;
+    // Number of independent parts decoded by decodePart() after decode(), they are decoded in parallel
+    virtual uint32_t getDecodePartCount() const;
+    virtual void decodePart(uint32_t partIndex);
+    // Creates the Vulkan resources and records their uploads on the main thread
+    // The resources are allocated from memoryPools if it isn't nullptr
+    virtual void createResources(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager& uploadManager, const MemoryPools* memoryPools) = 0;
+};
+
+class StreamedModel : public StreamedAsset
+{
+private:
+    friend class AssetStreamer;
+
+    std::string                         filePath;
+    uint32_t                            fileLoadingFlags = 0;
+    float                               globalScale = 1.0f;
+    // Parsed file with decoded images, released after the resources have been created
+    tinygltf::Model                     gltfModel;
+    // Encoded images of the parsed file, an image is a decoding part
+    std::vector<vulkanglTF::EncodedImage> encodedImages;
+    std::unique_ptr<vulkanglTF::Model>  model;
+
+public:
+    // nullptr until the model is ready
+    vulkanglTF::Model* get() const;
+
+protected:
+    void decode() override;
+    uint32_t getDecodePartCount() const override;
+    void decodePart(uint32_t partIndex) override;
+    void createResources(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager& uploadManager, const MemoryPools* memoryPools) override;
+};
+
+class StreamedTexture : public StreamedAsset
+{
+private:
+    friend class AssetStreamer;
+
+    std::string         filePath;
+    // Basis Universal textures are transcoded for its enabled features while decoding
+    const VulkanDevice* vulkanDevice = nullptr;
+    VkFilter            filter = VK_FILTER_LINEAR;
+    VkImageUsageFlags   imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImageLayout       imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    ktxTexture*         loadedKTXTexture = nullptr;
+    VulkanTexture2D     texture;
+
+public:
+    ~StreamedTexture();
+
+    // nullptr until the texture is ready
+    VulkanTexture2D* get();
+
+protected:
+    void decode() override;
+    void createResources(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager& uploadManager, const MemoryPools* memoryPools) override;
+};
+
+// Loads models and textures in the background while the render loop runs
+// Files are read and decoded by the job system workers(background jobs, frames never wait for them),
+// the parts of an asset(e.g. the images of a model) are decoded by separate jobs in parallel,
+// Vulkan resources are created and their uploads recorded at the frame boundary by update() on the main thread,
+// the copies are executed asynchronously by the upload manager. An asset becomes ready at the frame boundary after
+// its upload batch has been completed, so a frame uses either the placeholder or the complete asset
+// The handles can be released at any time, the resources are destroyed with the last handle(the GPU must not use them)
+class AssetStreamer
+{
+private:
+    VulkanDevice*                               vulkanDevice = nullptr;
+    VmaAllocator                                vmaAllocator = nullptr;
+    UploadManager*                              uploadManager = nullptr;
+    JobSystem*                                  jobSystem = nullptr;
+    const MemoryPools*                          memoryPools = nullptr;
+
+    JobSystem::TaskGroup                        decodeTaskGroup;
+    // Workers skip the decoding of the queued assets after destroy() has been called
+    std::atomic<bool>                           stopping = false;
+    // Decoded(or failed) assets waiting for update()
+    std::mutex                                  decodedAssetsMutex;
+    std::deque<std::shared_ptr<StreamedAsset>>  decodedAssets;
+    // Assets whose uploads have been recorded
+    std::vector<std::shared_ptr<StreamedAsset>> uploadingAssets;
+    // Assets that are not ready or failed yet
+    uint32_t                                    pendingAssets = 0;
+
+public:
+    // Limits the main thread work per frame, the rest of the decoded assets wait for the next frames
+    uint32_t maxAssetsCreatedPerFrame = 2;
+
+    // memoryPools - pools the geometry and textures are allocated from, nullptr - default pools
+    void init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager* uploadManager, JobSystem* jobSystem, const MemoryPools* memoryPools = nullptr);
+    // Waits for the decoding jobs, the assets not ready yet are released
+    void destroy();
+
+    // Starts loading, finishedCallback is called on the main thread by update() when the asset is ready or has failed
+    std::shared_ptr<StreamedModel> loadModel(
+        std::string filePath,
+        uint32_t fileLoadingFlags,
+        float globalScale = 1.0f,
+        std::function<void()> finishedCallback = nullptr
+    );
+    std::shared_ptr<StreamedTexture> loadTextureKTX(
+        std::string filePath,
+        VkFilter filter = VK_FILTER_LINEAR,
+        VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        std::function<void()> finishedCallback = nullptr
+    );
+
+    // Called at the frame boundary before the upload manager flush
+    // Marks the assets with completed uploads as ready, creates the resources of up to maxAssetsCreatedPerFrame decoded assets
+    void update();
+    // Blocks until all started assets are ready or have failed
+    void waitIdle();
+    bool isIdle() const;
+    uint32_t getPendingAssetCount() const;
+
+private:
+    void startDecoding(std::shared_ptr<StreamedAsset> asset);
+    void startDecodingParts(std::shared_ptr<StreamedAsset> asset);
+    // Calls the decoding step, if it throws, the asset fails with the first error
+    void runDecodeStep(StreamedAsset& asset, const std::function<void()>& step);
+    // Passes the decoded(or failed) asset to update()
+    void finishDecoding(std::shared_ptr<StreamedAsset> asset);
+    void createDecodedAssets(uint32_t maxCount);
+    void finishUploadedAssets();
+    void finish(StreamedAsset& asset, StreamedAsset::State state);
+};
@@ -0,0 +1,145 @@
+#include "Benchmark.h"
+#include "../ErrorInfo/ErrorInfo.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void Benchmark::begin()
+{
+    frameIndex = 0;
+    measurementTime = 0.0;
+    frameTimes.clear();
+    cpuTimes.clear();
+    fenceWaitTimes.clear();
+    measurementStartTime = std::chrono::steady_clock::now();
+}
+
+void Benchmark::addFrame(double frameTime, double fenceWaitTime)
+{
+    frameIndex++;
+    if (frameIndex <= warmupFrames) {
+        // The measurement starts after the last warmup frame
+        measurementStartTime = std::chrono::steady_clock::now();
+        return;
+    }
+    frameTimes.push_back(frameTime);
+    cpuTimes.push_back(frameTime - fenceWaitTime);
+    fenceWaitTimes.push_back(fenceWaitTime);
+    measurementTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - measurementStartTime).count();
+}
+
+bool Benchmark::isFinished() const
+{
+    if (frameIndex <= warmupFrames) {
+        return false;
+    }
+    if (seconds > 0.0) {
+        return measurementTime >= seconds;
+    }
+    return frameTimes.size() >= frames;
+}
+
+uint64_t Benchmark::getFrameIndex() const
+{
+    return frameIndex;
+}
+
+uint64_t Benchmark::getPathLength() const
+{
+    // With a time limit the number of frames is unknown, the path is repeated every 1000 frames
+    return warmupFrames + (seconds > 0.0 ? 1000 : frames);
+}
+
+void Benchmark::writeResults(
+    const std::string& sampleName,
+    VulkanDevice* vulkanDevice,
+    const GpuProfiler& gpuProfiler,
+    VmaAllocator vmaAllocator,
+    const std::vector<std::pair<std::string, std::string>>& configuration)
+{
+    if (frameTimes.empty()) {
+        std::cerr << "Warning: Benchmark has no measured frames\n";
+        return;
+    }
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "    \"sample\": \"" << sampleName << "\",\n";
+    json << "    \"device\": \"" << vulkanDevice->properties.deviceName << "\",\n";
+    json << "    \"driverVersion\": " << vulkanDevice->properties.driverVersion << ",\n";
+    json << "    \"configuration\": {";
+    for (size_t i = 0; i < configuration.size(); i++) {
+        json << (i == 0 ? "\n" : ",\n") << "        \"" << configuration[i].first << "\": " << configuration[i].second;
+    }
+    json << "\n    },\n";
+    json << "    \"warmupFrames\": " << warmupFrames << ",\n";
+    json << "    \"measuredFrames\": " << frameTimes.size() << ",\n";
+    json << "    \"measuredTimeSeconds\": " << measurementTime << ",\n";
+    json << "    \"averageFPS\": " << frameTimes.size() / measurementTime << ",\n";
+    json << "    \"frameTimeMs\": " << statisticsToJson(calculateStatistics(frameTimes)) << ",\n";
+    json << "    \"cpuTimeMs\": " << statisticsToJson(calculateStatistics(cpuTimes)) << ",\n";
+    json << "    \"fenceWaitTimeMs\": " << statisticsToJson(calculateStatistics(fenceWaitTimes)) << ",\n";
+
+    // GPU scopes(rolling statistics of the last GpuProfiler::HISTORY_SIZE frames)
+    json << "    \"gpuTimeMs\": {";
+    bool firstScope = true;
+    for (const auto& [name, statistics] : gpuProfiler.getStatistics()) {
+        json << (firstScope ? "\n" : ",\n") << "        \"" << name << "\": { \"min\": " << statistics.min << ", \"avg\": " << statistics.avg << ", \"p99\": " << statistics.p99 << ", \"depth\": " << statistics.depth << " }";
+        firstScope = false;
+    }
+    json << "\n    },\n";
+
+    // Memory usage
+    std::vector<VmaBudget> budgets(vulkanDevice->memoryProperties.memoryHeapCount);
+    vmaGetHeapBudgets(vmaAllocator, budgets.data());
+    VmaTotalStatistics totalStatistics{};
+    vmaCalculateStatistics(vmaAllocator, &totalStatistics);
+    json << "    \"memory\": {\n";
+    json << "        \"allocationCount\": " << totalStatistics.total.statistics.allocationCount << ",\n";
+    json << "        \"allocationBytes\": " << totalStatistics.total.statistics.allocationBytes << ",\n";
+    json << "        \"blockCount\": " << totalStatistics.total.statistics.blockCount << ",\n";
+    json << "        \"blockBytes\": " << totalStatistics.total.statistics.blockBytes << ",\n";
+    json << "        \"heaps\": [";
+    for (uint32_t i = 0; i < budgets.size(); i++) {
+        json << (i == 0 ? "\n" : ",\n") << "            { \"deviceLocal\": " << ((vulkanDevice->memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "true" : "false")
+            << ", \"usage\": " << budgets[i].usage << ", \"budget\": " << budgets[i].budget << " }";
+    }
+    json << "\n        ]\n";
+    json << "    }\n";
+    json << "}\n";
+
+    std::ofstream file(outputFilePath);
+    if (!file.is_open()) {
+        throw MakeErrorInfo(("Failed to open benchmark output file " + outputFilePath).c_str());
+    }
+    file << json.str();
+    std::cout << "Benchmark results written to " << outputFilePath << "\n";
+}
+
+Benchmark::Statistics Benchmark::calculateStatistics(std::vector<double> values)
+{
+    Statistics statistics;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    auto percentile = [&](uint32_t percent) { return values[(values.size() - 1) * percent / 100]; };
+    statistics.min = values.front();
+    statistics.avg = sum / values.size();
+    statistics.p50 = percentile(50);
+    statistics.p90 = percentile(90);
+    statistics.p95 = percentile(95);
+    statistics.p99 = percentile(99);
+    statistics.max = values.back();
+    return statistics;
+}
+
+std::string Benchmark::statisticsToJson(const Statistics& statistics)
+{
+    std::ostringstream json;
+    json << "{ \"min\": " << statistics.min << ", \"avg\": " << statistics.avg << ", \"p50\": " << statistics.p50 << ", \"p90\": " << statistics.p90
+        << ", \"p95\": " << statistics.p95 << ", \"p99\": " << statistics.p99 << ", \"max\": " << statistics.max << " }";
+    return json.str();
+}
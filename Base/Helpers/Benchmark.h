@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include "VulkanDevice.h"
+#include "GpuProfiler.h"
+#include "vk_mem_alloc.h"
+
+// Benchmark mode(--benchmark)
+// The sample renders warmupFrames frames, then measures frames frames(or seconds seconds),
+// the camera follows a fixed path and the animation uses a fixed time step, so the runs are reproducible
+// The results(frame time percentiles, CPU/GPU split, memory usage) are written to a JSON file
+class Benchmark
+{
+public:
+    bool            enabled = false;
+    uint32_t        warmupFrames = 100;
+    uint32_t        frames = 1000;
+    // If not 0, the measurement lasts for this number of seconds instead of the number of frames
+    double          seconds = 0.0;
+    std::string     outputFilePath = "benchmark.json";
+    // Time step(in milliseconds) used for animation and camera instead of the real frame time
+    double          fixedFrameTime = 1000.0 / 60.0;
+
+private:
+    // Percentiles and average in milliseconds
+    class Statistics
+    {
+    public:
+        double min = 0, avg = 0, p50 = 0, p90 = 0, p95 = 0, p99 = 0, max = 0;
+    };
+
+    uint64_t                                            frameIndex = 0;
+    std::chrono::time_point<std::chrono::steady_clock>  measurementStartTime;
+    double                                              measurementTime = 0.0;
+    // Wall time of the frames
+    std::vector<double>                                 frameTimes;
+    // Time the CPU was busy(frame time without waiting for the GPU)
+    std::vector<double>                                 cpuTimes;
+    // Time the CPU waited for the frame fence
+    std::vector<double>                                 fenceWaitTimes;
+
+public:
+    // Must be called before the first frame
+    void begin();
+
+    // Adds a frame, frameTime and fenceWaitTime in milliseconds
+    void addFrame(double frameTime, double fenceWaitTime);
+
+    bool isFinished() const;
+
+    // Index of the current frame including warmup frames, used for the camera path
+    uint64_t getFrameIndex() const;
+
+    // Number of frames in the camera path
+    uint64_t getPathLength() const;
+
+    // Writes the results to outputFilePath
+    // configuration - additional "name": "value" pairs describing the run
+    void writeResults(
+        const std::string& sampleName,
+        VulkanDevice* vulkanDevice,
+        const GpuProfiler& gpuProfiler,
+        VmaAllocator vmaAllocator,
+        const std::vector<std::pair<std::string, std::string>>& configuration
+    );
+
+private:
+    static Statistics calculateStatistics(std::vector<double> values);
+    static std::string statisticsToJson(const Statistics& statistics);
+};
@@ -0,0 +1,111 @@
+#include "BufferArena.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+VkDescriptorBufferInfo BufferArena::Allocation::getDescriptor() const
+{
+    return { buffer, offset, size };
+}
+
+void BufferArena::init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, VkDeviceSize blockSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags requiredMemoryFlags, VmaAllocationCreateFlags vmaAllocationCreateFlags)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->blockSize = blockSize;
+    this->usageFlags = usageFlags;
+    this->requiredMemoryFlags = requiredMemoryFlags;
+    this->vmaAllocationCreateFlags = vmaAllocationCreateFlags;
+    if (requiredMemoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        this->vmaAllocationCreateFlags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    }
+
+    // Offsets must satisfy the alignment of every usage of the buffer
+    const VkPhysicalDeviceLimits& limits = vulkanDevice->properties.limits;
+    minAlignment = 1;
+    if ((usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) && limits.minUniformBufferOffsetAlignment > minAlignment) {
+        minAlignment = limits.minUniformBufferOffsetAlignment;
+    }
+    if ((usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) && limits.minStorageBufferOffsetAlignment > minAlignment) {
+        minAlignment = limits.minStorageBufferOffsetAlignment;
+    }
+    if ((usageFlags & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) && limits.minTexelBufferOffsetAlignment > minAlignment) {
+        minAlignment = limits.minTexelBufferOffsetAlignment;
+    }
+    // Flushes of non coherent memory work on whole atoms
+    if ((requiredMemoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(requiredMemoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) && limits.nonCoherentAtomSize > minAlignment) {
+        minAlignment = limits.nonCoherentAtomSize;
+    }
+}
+
+void BufferArena::destroy()
+{
+    for (auto& block : blocks) {
+        block.vulkanBuffer.destroy();
+    }
+    blocks.clear();
+    currentBlock = 0;
+    currentOffset = 0;
+}
+
+BufferArena::Allocation BufferArena::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (alignment < minAlignment) {
+        alignment = minAlignment;
+    }
+    while (true) {
+        if (currentBlock < blocks.size()) {
+            Block& block = blocks[currentBlock];
+            // All limits are powers of two
+            VkDeviceSize offset = (currentOffset + alignment - 1) & ~(alignment - 1);
+            if (offset + size <= block.vulkanBuffer.vmaAllocationInfo.size) {
+                currentOffset = offset + size;
+                Allocation allocation;
+                allocation.buffer = block.vulkanBuffer.buffer;
+                allocation.offset = offset;
+                allocation.size = size;
+                allocation.data = block.data ? block.data + offset : nullptr;
+                allocation.blockIndex = currentBlock;
+                return allocation;
+            }
+            // Doesn't fit, try the next block
+            currentBlock++;
+            currentOffset = 0;
+            continue;
+        }
+        Block block;
+        block.vulkanBuffer.setDeviceAndAllocator(vulkanDevice, vmaAllocator);
+        block.vulkanBuffer.createBuffer(
+            size > blockSize ? size : blockSize,
+            usageFlags,
+            requiredMemoryFlags,
+            vmaAllocationCreateFlags
+        );
+        block.data = static_cast<uint8_t*>(block.vulkanBuffer.vmaAllocationInfo.pMappedData);
+        blocks.push_back(block);
+    }
+}
+
+void BufferArena::reset()
+{
+    currentBlock = 0;
+    currentOffset = 0;
+}
+
+void BufferArena::flush(const Allocation& allocation)
+{
+    blocks[allocation.blockIndex].vulkanBuffer.flush(allocation.offset, allocation.size);
+}
+
+VkDeviceSize BufferArena::getAlignedSize(VkDeviceSize size) const
+{
+    return (size + minAlignment - 1) & ~(minAlignment - 1);
+}
+
+VkDeviceSize BufferArena::getMinAlignment() const
+{
+    return minAlignment;
+}
+
+uint32_t BufferArena::getBlockCount() const
+{
+    return (uint32_t)blocks.size();
+}
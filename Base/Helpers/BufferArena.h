@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "vk_mem_alloc.h"
+
+// Linear allocator of sub-ranges of big buffers(blocks) for many small buffers(e.g. per-mesh uniform buffers)
+// Offsets respect the min offset alignment of the buffer usage(uniform, storage, texel), so a range can be bound
+// with a dynamic offset or used as a descriptor range. A new block is created when the current one is full
+// Host visible blocks are persistently mapped. Ranges are freed all together by reset() or destroy()
+class BufferArena
+{
+public:
+    class Allocation
+    {
+    public:
+        VkBuffer        buffer = VK_NULL_HANDLE;
+        VkDeviceSize    offset = 0;
+        VkDeviceSize    size = 0;
+        // Mapped memory of the range, nullptr if the block is not host visible
+        void*           data = nullptr;
+        uint32_t        blockIndex = 0;
+
+        VkDescriptorBufferInfo getDescriptor() const;
+    };
+
+private:
+    class Block
+    {
+    public:
+        VulkanBuffer    vulkanBuffer;
+        uint8_t*        data = nullptr;
+    };
+
+    VulkanDevice*               vulkanDevice = nullptr;
+    VmaAllocator                vmaAllocator = nullptr;
+    VkDeviceSize                blockSize = 0;
+    VkBufferUsageFlags          usageFlags = 0;
+    VkMemoryPropertyFlags       requiredMemoryFlags = 0;
+    VmaAllocationCreateFlags    vmaAllocationCreateFlags = 0;
+    VkDeviceSize                minAlignment = 1;
+
+    std::vector<Block>          blocks;
+    uint32_t                    currentBlock = 0;
+    VkDeviceSize                currentOffset = 0;
+
+public:
+    // blockSize - size of each block(a bigger allocation gets a block of its size)
+    // For host visible memory pass VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT or RANDOM_BIT in vmaAllocationCreateFlags
+    void init(
+        VulkanDevice* vulkanDevice,
+        VmaAllocator vmaAllocator,
+        VkDeviceSize blockSize,
+        VkBufferUsageFlags usageFlags,
+        VkMemoryPropertyFlags requiredMemoryFlags,
+        VmaAllocationCreateFlags vmaAllocationCreateFlags = 0
+    );
+    void destroy();
+
+    // Returns a range of at least size bytes aligned to max(alignment, min offset alignment of the usage)
+    Allocation allocate(VkDeviceSize size, VkDeviceSize alignment = 1);
+    // All ranges become free, the blocks are kept for reuse
+    void reset();
+    // Flushes the range written by the host(needed only for non coherent memory)
+    void flush(const Allocation& allocation);
+
+    // Size of an element of an array of ranges with the given size, e.g. the stride of per-draw dynamic offsets
+    VkDeviceSize getAlignedSize(VkDeviceSize size) const;
+    VkDeviceSize getMinAlignment() const;
+    uint32_t getBlockCount() const;
+};
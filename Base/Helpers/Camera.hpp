@@ -71,6 +71,11 @@ public:
         return zfar;
     }
 
+    // Vertical field of view in degrees
+    float getFov() {
+        return fov;
+    }
+
     void setPerspective(float fov, float aspect, float znear, float zfar)
     {
         this->fov = fov;
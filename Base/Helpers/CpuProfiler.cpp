@@ -0,0 +1,93 @@
+#include "CpuProfiler.h"
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+
+namespace
+{
+    // Opened scopes of the current thread(name, start time)
+    thread_local std::vector<std::pair<const char*, double>> openedScopes;
+    std::atomic<uint32_t> nextThreadId{ 0 };
+}
+
+CpuProfiler::ScopedTimer::ScopedTimer(CpuProfiler& cpuProfiler, const char* name) : cpuProfiler(cpuProfiler)
+{
+    cpuProfiler.beginScope(name);
+}
+
+CpuProfiler::ScopedTimer::~ScopedTimer()
+{
+    cpuProfiler.endScope();
+}
+
+CpuProfiler::CpuProfiler()
+{
+    events.reserve(EVENTS_CAPACITY);
+}
+
+void CpuProfiler::beginScope(const char* name)
+{
+    openedScopes.push_back({ name, now() });
+}
+
+void CpuProfiler::endScope()
+{
+    if (openedScopes.empty()) {
+        return;
+    }
+    Event event;
+    event.name = openedScopes.back().first;
+    event.start = openedScopes.back().second;
+    event.duration = now() - event.start;
+    event.threadId = getThreadId();
+    openedScopes.pop_back();
+
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    if (events.size() < EVENTS_CAPACITY) {
+        events.push_back(event);
+    }
+    else {
+        events[nextEvent] = event;
+    }
+    nextEvent = (nextEvent + 1) % EVENTS_CAPACITY;
+}
+
+bool CpuProfiler::writeChromeTrace(const std::string& filePath)
+{
+    std::vector<Event> sortedEvents;
+    {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        sortedEvents = events;
+    }
+    std::sort(sortedEvents.begin(), sortedEvents.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        return false;
+    }
+    // Complete events("ph":"X"), time in microseconds
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t i = 0; i < sortedEvents.size(); i++) {
+        const Event& event = sortedEvents[i];
+        file << "{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.threadId
+            << ",\"ts\":" << std::fixed << event.start << ",\"dur\":" << event.duration << "}";
+        if (i + 1 != sortedEvents.size()) {
+            file << ",";
+        }
+        file << "\n";
+    }
+    file << "]}\n";
+    return file.good();
+}
+
+double CpuProfiler::now() const
+{
+    return std::chrono::duration<double, std::chrono::microseconds::period>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint32_t CpuProfiler::getThreadId()
+{
+    // Small sequential ids are easier to read in the trace viewer than std::thread::id
+    thread_local uint32_t threadId = nextThreadId++;
+    return threadId;
+}
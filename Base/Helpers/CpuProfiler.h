@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// CPU profiler of frame phases
+// Keeps the last EVENTS_CAPACITY timed scopes and can export them to a Chrome trace JSON file
+// (chrome://tracing or https://ui.perfetto.dev)
+// Scopes can be opened on any thread, nested scopes must be closed in reverse order
+class CpuProfiler
+{
+public:
+    // Closes the scope when goes out of C++ scope
+    class ScopedTimer
+    {
+    private:
+        CpuProfiler& cpuProfiler;
+    public:
+        ScopedTimer(CpuProfiler& cpuProfiler, const char* name);
+        ~ScopedTimer();
+    };
+
+    // Maximum number of stored scopes, the oldest are overwritten
+    static const uint32_t EVENTS_CAPACITY = 1 << 16;
+
+private:
+    class Event
+    {
+    public:
+        const char* name = nullptr;
+        uint32_t    threadId = 0;
+        // Microseconds since the profiler creation
+        double      start = 0;
+        double      duration = 0;
+    };
+
+    std::chrono::time_point<std::chrono::steady_clock>  startTime = std::chrono::steady_clock::now();
+    std::mutex                                          eventsMutex;
+    std::vector<Event>                                  events;
+    // Position of the next event in the ring
+    size_t                                              nextEvent = 0;
+
+public:
+    CpuProfiler();
+
+    // name must be a string literal(or live as long as the profiler)
+    void beginScope(const char* name);
+    void endScope();
+
+    // Writes the stored scopes to the file in the Chrome trace event format
+    // Returns false if the file can't be written
+    bool writeChromeTrace(const std::string& filePath);
+
+private:
+    double now() const;
+    uint32_t getThreadId();
+};
+
+#define CPU_PROFILER_CONCAT_IMPL(a, b) a##b
+#define CPU_PROFILER_CONCAT(a, b) CPU_PROFILER_CONCAT_IMPL(a, b)
+// Times the rest of the current C++ scope
+#define CPU_PROFILE_SCOPE(cpuProfiler, name) CpuProfiler::ScopedTimer CPU_PROFILER_CONCAT(cpuProfilerScopedTimer, __LINE__)(cpuProfiler, name)
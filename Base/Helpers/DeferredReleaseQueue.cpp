@@ -0,0 +1,30 @@
+#include "DeferredReleaseQueue.h"
+
+void DeferredReleaseQueue::push(uint64_t frameValue, Release release)
+{
+    // A smaller value is completed not later than the last pushed one
+    if (!entries.empty() && frameValue < entries.back().frameValue) {
+        frameValue = entries.back().frameValue;
+    }
+    entries.push_back({ frameValue, std::move(release) });
+}
+
+void DeferredReleaseQueue::collect(uint64_t completedFrameValue)
+{
+    while (!entries.empty() && entries.front().frameValue <= completedFrameValue) {
+        // The release may push new entries
+        Release release = std::move(entries.front().release);
+        entries.pop_front();
+        release();
+    }
+}
+
+void DeferredReleaseQueue::flush()
+{
+    collect(UINT64_MAX);
+}
+
+size_t DeferredReleaseQueue::size() const
+{
+    return entries.size();
+}
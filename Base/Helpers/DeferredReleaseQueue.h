@@ -0,0 +1,33 @@
+#pragma once
+
+#include <deque>
+#include <cstdint>
+#include <functional>
+
+// Releases(handle destruction, descriptor set reuse, etc.) deferred until the frames that used the resources have been completed
+// A release is pushed with the frame value(BaseSample::getFrameTimelineValue()) of the last frame that may use the resources
+// and called by collect() once the completed frame value reaches it, the host never waits for the GPU for it
+class DeferredReleaseQueue
+{
+public:
+    using Release = std::function<void()>;
+
+private:
+    class Entry
+    {
+    public:
+        uint64_t    frameValue = 0;
+        Release     release;
+    };
+
+    // In push order, frame values don't decrease
+    std::deque<Entry>   entries;
+
+public:
+    void push(uint64_t frameValue, Release release);
+    // Calls the releases of the frames up to completedFrameValue
+    void collect(uint64_t completedFrameValue);
+    // Calls all releases, the device must be idle
+    void flush();
+    size_t size() const;
+};
@@ -0,0 +1,402 @@
+#include "Defragmenter.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+void Defragmenter::init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, VkQueue queue, uint32_t queueFamilyIndex)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->queue = queue;
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+    VK_CHECK_RESULT(vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, getHostAllocationCallbacks(), &commandPool));
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.commandPool = commandPool;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount = 1;
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(vulkanDevice->logicalDevice, &commandBufferAllocateInfo, &commandBuffer));
+
+    VkFenceCreateInfo fenceCreateInfo{};
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VK_CHECK_RESULT(vkCreateFence(vulkanDevice->logicalDevice, &fenceCreateInfo, getHostAllocationCallbacks(), &fence));
+}
+
+void Defragmenter::destroy()
+{
+    if (!commandPool) {
+        return;
+    }
+    // The pools not started yet are skipped
+    nextPoolIndex = pools.size();
+    if (state == State::WaitingCopies) {
+        // Completes the pass, so the new handles are not leaked
+        vkWaitForFences(vulkanDevice->logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+        endPass();
+    }
+    if (state != State::Idle) {
+        finish();
+    }
+    resources.clear();
+    pools.clear();
+    vkDestroyFence(vulkanDevice->logicalDevice, fence, getHostAllocationCallbacks());
+    vkDestroyCommandPool(vulkanDevice->logicalDevice, commandPool, getHostAllocationCallbacks());
+    fence = VK_NULL_HANDLE;
+    commandPool = VK_NULL_HANDLE;
+}
+
+void Defragmenter::registerBuffer(VulkanBuffer* vulkanBuffer, MovedCallback movedCallback)
+{
+    if (!(vulkanBuffer->usageFlags & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) || vulkanBuffer->mapped) {
+        throw MakeErrorInfo("Defragmenter: the buffer must have the transfer source usage and must not be persistently mapped!");
+    }
+    Resource& resource = resources[vulkanBuffer->vmaAllocation];
+    resource.vulkanBuffer = vulkanBuffer;
+    resource.movedCallback = std::move(movedCallback);
+}
+
+void Defragmenter::registerTexture(VulkanTexture* vulkanTexture, MovedCallback movedCallback)
+{
+    if (!(vulkanTexture->imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+        throw MakeErrorInfo("Defragmenter: the image must have the transfer source usage!");
+    }
+    Resource& resource = resources[vulkanTexture->vmaImageAllocation];
+    resource.vulkanTexture = vulkanTexture;
+    resource.movedCallback = std::move(movedCallback);
+}
+
+void Defragmenter::unregisterBuffer(VulkanBuffer* vulkanBuffer)
+{
+    unregister(vulkanBuffer->vmaAllocation);
+}
+
+void Defragmenter::unregisterTexture(VulkanTexture* vulkanTexture)
+{
+    unregister(vulkanTexture->vmaImageAllocation);
+}
+
+void Defragmenter::addPool(VmaPool pool)
+{
+    pools.push_back(pool);
+}
+
+void Defragmenter::start()
+{
+    if (state != State::Idle || !commandPool) {
+        return;
+    }
+    lastStatistics = VmaDefragmentationStats{};
+    nextPoolIndex = 0;
+    // Default pools
+    beginDefragmentation(nullptr);
+}
+
+void Defragmenter::update()
+{
+    if (state == State::WaitingCopies) {
+        // Non-blocking, the pass is ended at one of the next frames
+        if (vkGetFenceStatus(vulkanDevice->logicalDevice, fence) != VK_SUCCESS) {
+            return;
+        }
+        endPass();
+    }
+    else if (state == State::BeginPass) {
+        beginPass();
+    }
+}
+
+bool Defragmenter::isRunning() const
+{
+    return state != State::Idle;
+}
+
+const VmaDefragmentationStats& Defragmenter::getLastStatistics() const
+{
+    return lastStatistics;
+}
+
+void Defragmenter::unregister(VmaAllocation allocation)
+{
+    auto resourceIt = resources.find(allocation);
+    if (resourceIt == resources.end()) {
+        return;
+    }
+    // The resource is being moved, the move is cancelled
+    // VMA reads the source allocation when the pass ends and the caller frees it right after this call,
+    // so the pass is ended here(the copies are waited) instead of at one of the next frames
+    bool cancelled = false;
+    if (state == State::WaitingCopies) {
+        for (uint32_t i = 0; i < passInfo.moveCount; i++) {
+            VmaDefragmentationMove& move = passInfo.pMoves[i];
+            if (move.srcAllocation != allocation || move.operation == VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE) {
+                continue;
+            }
+            vkWaitForFences(vulkanDevice->logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+            for (auto moveIt = moves.begin(); moveIt != moves.end(); ++moveIt) {
+                if (moveIt->resource == &resourceIt->second) {
+                    vkDestroyBuffer(vulkanDevice->logicalDevice, moveIt->newBuffer, getHostAllocationCallbacks());
+                    vkDestroyImage(vulkanDevice->logicalDevice, moveIt->newImage, getHostAllocationCallbacks());
+                    moves.erase(moveIt);
+                    break;
+                }
+            }
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            cancelled = true;
+        }
+    }
+    // Erased first, the moved callbacks of the other resources of the pass are called by endPass()
+    resources.erase(resourceIt);
+    if (cancelled) {
+        endPass();
+    }
+}
+
+bool Defragmenter::recordMove(VmaDefragmentationMove& move)
+{
+    auto resourceIt = resources.find(move.srcAllocation);
+    if (resourceIt == resources.end()) {
+        return false;
+    }
+    Resource& resource = resourceIt->second;
+    Move newMove;
+    newMove.resource = &resource;
+
+    if (resource.vulkanBuffer) {
+        VulkanBuffer& vulkanBuffer = *resource.vulkanBuffer;
+        VkBufferCreateInfo bufferCreateInfo{};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = vulkanBuffer.bufferSize;
+        bufferCreateInfo.usage = vulkanBuffer.usageFlags;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VK_CHECK_RESULT(vkCreateBuffer(vulkanDevice->logicalDevice, &bufferCreateInfo, getHostAllocationCallbacks(), &newMove.newBuffer));
+        VK_CHECK_RESULT(vmaBindBufferMemory(vmaAllocator, move.dstTmpAllocation, newMove.newBuffer));
+
+        VkBufferCopy bufferCopy{};
+        bufferCopy.size = vulkanBuffer.bufferSize;
+        vkCmdCopyBuffer(commandBuffer, vulkanBuffer.buffer, newMove.newBuffer, 1, &bufferCopy);
+    }
+    else {
+        VulkanTexture& vulkanTexture = *resource.vulkanTexture;
+        VkImageCreateInfo imageCreateInfo{};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.flags = vulkanTexture.imageFlags;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = vulkanTexture.textureFormat;
+        imageCreateInfo.extent = { vulkanTexture.width, vulkanTexture.height, 1 };
+        imageCreateInfo.mipLevels = vulkanTexture.mipLevels;
+        imageCreateInfo.arrayLayers = vulkanTexture.layerCount;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = vulkanTexture.imageUsage;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VK_CHECK_RESULT(vkCreateImage(vulkanDevice->logicalDevice, &imageCreateInfo, getHostAllocationCallbacks(), &newMove.newImage));
+        VK_CHECK_RESULT(vmaBindImageMemory(vmaAllocator, move.dstTmpAllocation, newMove.newImage));
+
+        VkImageSubresourceRange subresourceRange{};
+        subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        subresourceRange.levelCount = vulkanTexture.mipLevels;
+        subresourceRange.layerCount = vulkanTexture.layerCount;
+
+        // The frames until the end of the pass still sample the old image, it returns to its layout after the copy
+        VkImageMemoryBarrier imageMemoryBarriers[2]{};
+        imageMemoryBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageMemoryBarriers[0].srcAccessMask = 0;
+        imageMemoryBarriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageMemoryBarriers[0].oldLayout = vulkanTexture.imageLayout;
+        imageMemoryBarriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageMemoryBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarriers[0].image = vulkanTexture.image;
+        imageMemoryBarriers[0].subresourceRange = subresourceRange;
+        imageMemoryBarriers[1] = imageMemoryBarriers[0];
+        imageMemoryBarriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageMemoryBarriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarriers[1].image = newMove.newImage;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, imageMemoryBarriers);
+
+        std::vector<VkImageCopy> imageCopies(vulkanTexture.mipLevels);
+        for (uint32_t mipLevel = 0; mipLevel < vulkanTexture.mipLevels; mipLevel++) {
+            VkImageCopy& imageCopy = imageCopies[mipLevel];
+            imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageCopy.srcSubresource.mipLevel = mipLevel;
+            imageCopy.srcSubresource.baseArrayLayer = 0;
+            imageCopy.srcSubresource.layerCount = vulkanTexture.layerCount;
+            imageCopy.dstSubresource = imageCopy.srcSubresource;
+            imageCopy.extent.width = vulkanTexture.width >> mipLevel ? vulkanTexture.width >> mipLevel : 1;
+            imageCopy.extent.height = vulkanTexture.height >> mipLevel ? vulkanTexture.height >> mipLevel : 1;
+            imageCopy.extent.depth = 1;
+        }
+        vkCmdCopyImage(
+            commandBuffer,
+            vulkanTexture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            newMove.newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            (uint32_t)imageCopies.size(), imageCopies.data()
+        );
+
+        imageMemoryBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageMemoryBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        imageMemoryBarriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageMemoryBarriers[0].newLayout = vulkanTexture.imageLayout;
+        imageMemoryBarriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        imageMemoryBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarriers[1].newLayout = vulkanTexture.imageLayout;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 2, imageMemoryBarriers);
+    }
+    moves.push_back(newMove);
+    return true;
+}
+
+void Defragmenter::beginDefragmentation(VmaPool pool)
+{
+    VmaDefragmentationInfo defragmentationInfo{};
+    defragmentationInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+    defragmentationInfo.pool = pool;
+    defragmentationInfo.maxBytesPerPass = maxBytesPerPass;
+    defragmentationInfo.maxAllocationsPerPass = maxAllocationsPerPass;
+    VK_CHECK_RESULT(vmaBeginDefragmentation(vmaAllocator, &defragmentationInfo, &context));
+    state = State::BeginPass;
+}
+
+void Defragmenter::beginPass()
+{
+    VkResult result = vmaBeginDefragmentationPass(vmaAllocator, context, &passInfo);
+    if (result == VK_SUCCESS) {
+        // Nothing to move
+        finish();
+        return;
+    }
+    if (result != VK_INCOMPLETE) {
+        throw MakeErrorInfo("Failed to begin defragmentation pass!");
+    }
+
+    VK_CHECK_RESULT(vkResetCommandBuffer(commandBuffer, 0));
+    VkCommandBufferBeginInfo commandBufferBeginInfo{};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
+    moves.clear();
+    for (uint32_t i = 0; i < passInfo.moveCount; i++) {
+        if (!recordMove(passInfo.pMoves[i])) {
+            passInfo.pMoves[i].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+        }
+    }
+    // Buffer copies must be visible to the commands submitted after the pass(vertex input, index reads, etc.)
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
+
+    if (moves.empty()) {
+        // Only not registered allocations, the pass is ended without copies
+        endPass();
+        return;
+    }
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    VK_CHECK_RESULT(vkResetFences(vulkanDevice->logicalDevice, 1, &fence));
+    VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+    state = State::WaitingCopies;
+}
+
+void Defragmenter::endPass()
+{
+    if (!moves.empty()) {
+        // Descriptor sets that reference the old handles may still be used by the frames in flight,
+        // they are rewritten only when the queue is idle(one short stall per pass)
+        VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+    }
+    std::vector<VkBuffer> oldBuffers;
+    std::vector<VkImage> oldImages;
+    std::vector<VkImageView> oldImageViews;
+    for (Move& move : moves) {
+        if (move.resource->vulkanBuffer) {
+            VulkanBuffer& vulkanBuffer = *move.resource->vulkanBuffer;
+            oldBuffers.push_back(vulkanBuffer.buffer);
+            vulkanBuffer.buffer = move.newBuffer;
+            vulkanBuffer.descriptor.buffer = move.newBuffer;
+        }
+        else {
+            VulkanTexture& vulkanTexture = *move.resource->vulkanTexture;
+            oldImages.push_back(vulkanTexture.image);
+            oldImageViews.push_back(vulkanTexture.imageView);
+            vulkanTexture.image = move.newImage;
+
+            VkImageViewUsageCreateInfo imageViewUsageCreateInfo{};
+            imageViewUsageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+            imageViewUsageCreateInfo.usage = vulkanTexture.getViewUsage();
+            VkImageViewCreateInfo imageViewCreateInfo{};
+            imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            imageViewCreateInfo.pNext = imageViewUsageCreateInfo.usage != vulkanTexture.imageUsage ? &imageViewUsageCreateInfo : nullptr;
+            imageViewCreateInfo.image = vulkanTexture.image;
+            imageViewCreateInfo.viewType = vulkanTexture.layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            imageViewCreateInfo.format = vulkanTexture.textureFormat;
+            imageViewCreateInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+            imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+            imageViewCreateInfo.subresourceRange.levelCount = vulkanTexture.mipLevels;
+            imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+            imageViewCreateInfo.subresourceRange.layerCount = vulkanTexture.layerCount;
+            if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &vulkanTexture.imageView) != VK_SUCCESS) {
+                throw MakeErrorInfo("Failed to create image view!");
+            }
+            vulkanTexture.updateDescriptor();
+        }
+    }
+    for (VkBuffer oldBuffer : oldBuffers) {
+        vkDestroyBuffer(vulkanDevice->logicalDevice, oldBuffer, getHostAllocationCallbacks());
+    }
+    for (VkImageView oldImageView : oldImageViews) {
+        vkDestroyImageView(vulkanDevice->logicalDevice, oldImageView, getHostAllocationCallbacks());
+    }
+    for (VkImage oldImage : oldImages) {
+        vkDestroyImage(vulkanDevice->logicalDevice, oldImage, getHostAllocationCallbacks());
+    }
+
+    // The source allocations take the new places
+    VkResult result = vmaEndDefragmentationPass(vmaAllocator, context, &passInfo);
+    for (Move& move : moves) {
+        if (move.resource->vulkanBuffer) {
+            vmaGetAllocationInfo(vmaAllocator, move.resource->vulkanBuffer->vmaAllocation, &move.resource->vulkanBuffer->vmaAllocationInfo);
+        }
+        else {
+            vmaGetAllocationInfo(vmaAllocator, move.resource->vulkanTexture->vmaImageAllocation, &move.resource->vulkanTexture->vmaImageAllocationInfo);
+        }
+        if (move.resource->movedCallback) {
+            move.resource->movedCallback();
+        }
+    }
+    moves.clear();
+
+    if (result == VK_SUCCESS) {
+        finish();
+    }
+    else {
+        state = State::BeginPass;
+    }
+}
+
+void Defragmenter::finish()
+{
+    VmaDefragmentationStats statistics{};
+    vmaEndDefragmentation(vmaAllocator, context, &statistics);
+    context = nullptr;
+    lastStatistics.bytesMoved += statistics.bytesMoved;
+    lastStatistics.bytesFreed += statistics.bytesFreed;
+    lastStatistics.allocationsMoved += statistics.allocationsMoved;
+    lastStatistics.deviceMemoryBlocksFreed += statistics.deviceMemoryBlocksFreed;
+    state = State::Idle;
+    // The next custom pool
+    if (nextPoolIndex < pools.size()) {
+        beginDefragmentation(pools[nextPoolIndex++]);
+    }
+}
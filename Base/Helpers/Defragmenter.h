@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "VulkanTexture.h"
+#include "vk_mem_alloc.h"
+
+// Incremental VMA defragmentation, one pass of moves is executed over several frames:
+// - update() begins a pass, creates new buffers/images in the new places and submits the copies
+// - a later update() finds the copies completed, waits for the frames in flight(they may still use the old handles),
+//   replaces the handles in the registered VulkanBuffer/VulkanTexture objects, calls their moved callbacks
+//   to rewrite descriptors and destroys the old handles
+// Only registered resources are moved, the moves of other allocations are ignored
+// The resources must be created with the transfer source usage and must not be in use by other queues
+class Defragmenter
+{
+public:
+    // Called after the handles of the resource have been replaced, e.g. to rewrite descriptor sets
+    using MovedCallback = std::function<void()>;
+
+    // The pass size limits, the copies of one pass are executed within one frame
+    VkDeviceSize    maxBytesPerPass = 32 * 1024 * 1024;
+    uint32_t        maxAllocationsPerPass = 64;
+
+private:
+    enum class State { Idle, BeginPass, WaitingCopies };
+
+    class Resource
+    {
+    public:
+        VulkanBuffer*   vulkanBuffer = nullptr;
+        VulkanTexture*  vulkanTexture = nullptr;
+        MovedCallback   movedCallback;
+    };
+
+    // Resource moved in the current pass with its new handles
+    class Move
+    {
+    public:
+        Resource*       resource = nullptr;
+        VkBuffer        newBuffer = VK_NULL_HANDLE;
+        VkImage         newImage = VK_NULL_HANDLE;
+    };
+
+    VulkanDevice*                                   vulkanDevice = nullptr;
+    VmaAllocator                                    vmaAllocator = nullptr;
+    // Queue the resources are used on, the copies are submitted to it
+    VkQueue                                         queue = VK_NULL_HANDLE;
+    VkCommandPool                                   commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer                                 commandBuffer = VK_NULL_HANDLE;
+    VkFence                                         fence = VK_NULL_HANDLE;
+
+    std::unordered_map<VmaAllocation, Resource>     resources;
+    State                                           state = State::Idle;
+    VmaDefragmentationContext                       context = nullptr;
+    VmaDefragmentationPassMoveInfo                  passInfo{};
+    std::vector<Move>                               moves;
+    VmaDefragmentationStats                         lastStatistics{};
+    // Custom pools defragmented one after another after the default pools
+    std::vector<VmaPool>                            pools;
+    size_t                                          nextPoolIndex = 0;
+
+public:
+    // queue - the queue the resources are used on, queueFamilyIndex - its family
+    void init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, VkQueue queue, uint32_t queueFamilyIndex);
+    // Finishes the running defragmentation
+    void destroy();
+
+    // The object must stay at the same address until it is unregistered
+    void registerBuffer(VulkanBuffer* vulkanBuffer, MovedCallback movedCallback = nullptr);
+    void registerTexture(VulkanTexture* vulkanTexture, MovedCallback movedCallback = nullptr);
+    // Must be called before the resource is destroyed
+    // If the resource is moved by the running pass, the pass is ended at once(waits for its copies)
+    void unregisterBuffer(VulkanBuffer* vulkanBuffer);
+    void unregisterTexture(VulkanTexture* vulkanTexture);
+
+    // Adds a custom pool(see MemoryPools) to the defragmented ones, linear algorithm pools can't be defragmented
+    void addPool(VmaPool pool);
+    // Starts the defragmentation of the default pools and the added ones if it isn't running
+    void start();
+    // Called at the frame boundary after the frame fence has been waited, advances the running defragmentation
+    void update();
+    bool isRunning() const;
+    // Moved bytes and allocations of the last finished defragmentation(all pools)
+    const VmaDefragmentationStats& getLastStatistics() const;
+
+private:
+    void unregister(VmaAllocation allocation);
+    // Creates the new handle bound to the move destination and records the copy, false if the move is ignored
+    bool recordMove(VmaDefragmentationMove& move);
+    void beginDefragmentation(VmaPool pool);
+    void beginPass();
+    void endPass();
+    void finish();
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Ring of per-frame resources(uniform buffers, descriptor sets, etc.), one resource per frame in flight
+// Frame with index N uses only resources[N], the resources of other frames may still be in use by the GPU
+template <typename T>
+class FrameResourceRing
+{
+public:
+    std::vector<T> resources;
+
+    // Creates framesInFlight resources
+    // createResource(frameIndex) must return a new resource
+    template <typename CreateFunction>
+    void create(uint32_t framesInFlight, CreateFunction createResource)
+    {
+        resources.clear();
+        resources.reserve(framesInFlight);
+        for (uint32_t i = 0; i < framesInFlight; ++i) {
+            resources.push_back(createResource(i));
+        }
+    }
+
+    // Calls destroyResource(resource) for each resource and clears the ring
+    template <typename DestroyFunction>
+    void destroy(DestroyFunction destroyResource)
+    {
+        for (auto& resource : resources) {
+            destroyResource(resource);
+        }
+        resources.clear();
+    }
+
+    T& operator[](uint32_t frameIndex)
+    {
+        return resources[frameIndex];
+    }
+
+    const T& operator[](uint32_t frameIndex) const
+    {
+        return resources[frameIndex];
+    }
+
+    uint32_t size() const
+    {
+        return (uint32_t)resources.size();
+    }
+
+    typename std::vector<T>::iterator begin() { return resources.begin(); }
+    typename std::vector<T>::iterator end() { return resources.end(); }
+};
@@ -0,0 +1,166 @@
+#include "GpuProfiler.h"
+#include "../ErrorInfo/ErrorInfo.h"
+#include <algorithm>
+#include <iostream>
+
+void GpuProfiler::init(VulkanDevice* vulkanDevice, uint32_t framesInFlight, uint32_t maxScopes)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->maxScopes = maxScopes;
+
+    // Spec says: timestampValidBits is the unsigned integer count of meaningful bits in the timestamps written via vkCmdWriteTimestamp
+    // The valid range for the count is 36..64 bits, or a value of 0, indicating no support for timestamps
+    uint32_t timestampValidBits = vulkanDevice->queueFamilyProperties[vulkanDevice->queueFamilyIndices.graphics.value()].timestampValidBits;
+    supported = timestampValidBits != 0 && vulkanDevice->properties.limits.timestampPeriod > 0.0f;
+    if (!supported) {
+        std::cerr << "Warning: Timestamp queries are not supported by the graphics queue, GPU profiler disabled\n";
+        return;
+    }
+    timestampPeriod = vulkanDevice->properties.limits.timestampPeriod;
+    timestampMask = timestampValidBits == 64 ? ~0ull : ((1ull << timestampValidBits) - 1);
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo{};
+    queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    // Two timestamps per scope
+    queryPoolCreateInfo.queryCount = maxScopes * 2;
+
+    frames.resize(framesInFlight);
+    for (auto& frame : frames) {
+        if (vkCreateQueryPool(vulkanDevice->logicalDevice, &queryPoolCreateInfo, getHostAllocationCallbacks(), &frame.queryPool) != VK_SUCCESS) {
+            throw MakeErrorInfo("Failed to create timestamp query pool!");
+        }
+    }
+}
+
+void GpuProfiler::destroy()
+{
+    for (auto& frame : frames) {
+        if (frame.queryPool) {
+            vkDestroyQueryPool(vulkanDevice->logicalDevice, frame.queryPool, getHostAllocationCallbacks());
+        }
+    }
+    frames.clear();
+}
+
+void GpuProfiler::collectResults(uint32_t frameIndex)
+{
+    currentFrameIndex = frameIndex;
+    frameStarted = false;
+    if (!supported) {
+        return;
+    }
+
+    FrameQueries& frame = frames[frameIndex];
+    if (frame.usedQueries != 0) {
+        // Pairs of (timestamp, availability), the frame has been completed so all written queries are available
+        // We don't wait: a query that was never written(e.g. the scope was not ended) is just skipped
+        std::vector<uint64_t> results(frame.usedQueries * 2);
+        VkResult result = vkGetQueryPoolResults(
+            vulkanDevice->logicalDevice,
+            frame.queryPool,
+            0,
+            frame.usedQueries,
+            results.size() * sizeof(uint64_t),
+            results.data(),
+            sizeof(uint64_t) * 2,
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+        );
+        if (result == VK_SUCCESS || result == VK_NOT_READY) {
+            for (const auto& scope : frame.scopes) {
+                if (!scope.ended || results[scope.beginQuery * 2 + 1] == 0 || results[scope.endQuery * 2 + 1] == 0) {
+                    continue;
+                }
+                uint64_t begin = results[scope.beginQuery * 2] & timestampMask;
+                uint64_t end = results[scope.endQuery * 2] & timestampMask;
+                float timeInMS = float((end - begin) & timestampMask) * timestampPeriod / 1000000.0f;
+                addSample(scope.name, timeInMS, scope.depth);
+            }
+        }
+    }
+    frame.scopes.clear();
+    frame.usedQueries = 0;
+    frame.openScopes = 0;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer)
+{
+    if (!supported) {
+        return;
+    }
+    vkCmdResetQueryPool(commandBuffer, frames[currentFrameIndex].queryPool, 0, maxScopes * 2);
+    frameStarted = true;
+}
+
+void GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name)
+{
+    if (!supported || !frameStarted) {
+        return;
+    }
+    FrameQueries& frame = frames[currentFrameIndex];
+    if (frame.usedQueries + 2 > maxScopes * 2) {
+        return;
+    }
+    Scope scope;
+    scope.name = name;
+    scope.beginQuery = frame.usedQueries++;
+    scope.endQuery = frame.usedQueries++;
+    scope.depth = frame.openScopes++;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, scope.beginQuery);
+    frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, const std::string& name)
+{
+    if (!supported || !frameStarted) {
+        return;
+    }
+    FrameQueries& frame = frames[currentFrameIndex];
+    // The last opened scope with this name
+    for (auto scope = frame.scopes.rbegin(); scope != frame.scopes.rend(); ++scope) {
+        if (scope->name == name && !scope->ended) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, scope->endQuery);
+            scope->ended = true;
+            frame.openScopes--;
+            return;
+        }
+    }
+}
+
+bool GpuProfiler::isSupported() const
+{
+    return supported;
+}
+
+const std::map<std::string, GpuProfiler::ScopeStatistics>& GpuProfiler::getStatistics() const
+{
+    return statistics;
+}
+
+void GpuProfiler::addSample(const std::string& name, float timeInMS, uint32_t depth)
+{
+    // Ring of the last HISTORY_SIZE samples
+    std::vector<float>& samples = history[name];
+    uint32_t& position = historyPositions[name];
+    if (samples.size() < HISTORY_SIZE) {
+        samples.push_back(timeInMS);
+    }
+    else {
+        samples[position] = timeInMS;
+    }
+    position = (position + 1) % HISTORY_SIZE;
+
+    std::vector<float> sortedSamples = samples;
+    std::sort(sortedSamples.begin(), sortedSamples.end());
+    float sum = 0.0f;
+    for (float sample : sortedSamples) {
+        sum += sample;
+    }
+
+    ScopeStatistics& scopeStatistics = statistics[name];
+    scopeStatistics.depth = depth;
+    scopeStatistics.last = timeInMS;
+    scopeStatistics.min = sortedSamples.front();
+    scopeStatistics.avg = sum / sortedSamples.size();
+    scopeStatistics.p99 = sortedSamples[(sortedSamples.size() - 1) * 99 / 100];
+}
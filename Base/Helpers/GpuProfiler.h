@@ -0,0 +1,90 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+
+// GPU profiler based on timestamp queries
+// Each frame in flight has its own query pool, the results of a frame are read when its fence has been waited
+// (base_maxFramesInFlight frames later), so reading never stalls the CPU
+class GpuProfiler
+{
+public:
+    // Rolling statistics of a scope in milliseconds over the last HISTORY_SIZE frames
+    class ScopeStatistics
+    {
+    public:
+        float last = 0.0f;
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p99 = 0.0f;
+        // Number of scopes open when the scope began(0 - top level), nested scopes are included in the time of their parents
+        uint32_t depth = 0;
+    };
+
+    // Number of frames used to compute statistics
+    static const uint32_t HISTORY_SIZE = 256;
+
+private:
+    class Scope
+    {
+    public:
+        std::string name;
+        uint32_t    beginQuery = 0;
+        uint32_t    endQuery = 0;
+        uint32_t    depth = 0;
+        bool        ended = false;
+    };
+
+    class FrameQueries
+    {
+    public:
+        VkQueryPool         queryPool = VK_NULL_HANDLE;
+        std::vector<Scope>  scopes;
+        uint32_t            usedQueries = 0;
+        // Scopes begun and not ended yet(in recording order)
+        uint32_t            openScopes = 0;
+    };
+
+    VulkanDevice*                               vulkanDevice = nullptr;
+    bool                                        supported = false;
+    uint32_t                                    maxScopes = 0;
+    // Nanoseconds per timestamp tick
+    float                                       timestampPeriod = 1.0f;
+    uint64_t                                    timestampMask = ~0ull;
+    std::vector<FrameQueries>                   frames;
+    uint32_t                                    currentFrameIndex = 0;
+    // Queries of the current frame have been reset and can be written
+    bool                                        frameStarted = false;
+    std::map<std::string, std::vector<float>>   history;
+    std::map<std::string, uint32_t>             historyPositions;
+    std::map<std::string, ScopeStatistics>      statistics;
+
+public:
+    // Creates a query pool per frame in flight
+    // If the graphics queue family doesn't support timestamps, the profiler does nothing
+    void init(VulkanDevice* vulkanDevice, uint32_t framesInFlight, uint32_t maxScopes = 32);
+    void destroy();
+
+    // Reads the results written the last time this frame index was used
+    // Must be called after the frame fence has been waited
+    void collectResults(uint32_t frameIndex);
+
+    // Resets the queries of the current frame, must be recorded outside of a render pass
+    // before any scope of the frame and in a command buffer that is submitted first
+    void beginFrame(VkCommandBuffer commandBuffer);
+
+    // Writes timestamps around the commands recorded between beginScope() and endScope()
+    // Scopes can be placed in different command buffers of the same frame
+    void beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+    void endScope(VkCommandBuffer commandBuffer, const std::string& name);
+
+    bool isSupported() const;
+
+    const std::map<std::string, ScopeStatistics>& getStatistics() const;
+
+private:
+    void addSample(const std::string& name, float timeInMS, uint32_t depth);
+};
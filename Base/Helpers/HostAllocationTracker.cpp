@@ -0,0 +1,223 @@
+#include "HostAllocationTracker.h"
+#include <cstdlib>
+#include <cstring>
+
+HostAllocationTracker hostAllocationTracker;
+
+const VkAllocationCallbacks* getHostAllocationCallbacks()
+{
+    return hostAllocationTracker.getCallbacks();
+}
+
+HostAllocationTracker::~HostAllocationTracker()
+{
+    // Called at exit, the Vulkan objects have already been destroyed
+    for (SizeClass& sizeClass : sizeClasses) {
+        for (void* chunk : sizeClass.chunks) {
+            std::free(chunk);
+        }
+        sizeClass.chunks.clear();
+        sizeClass.freeList = nullptr;
+    }
+}
+
+void HostAllocationTracker::enable(bool pooled)
+{
+    if (enabled) {
+        return;
+    }
+    this->pooled = pooled;
+    for (size_t i = 0; i < sizeClassCount; i++) {
+        sizeClasses[i].blockSize = minBlockSize << i;
+    }
+    callbacks.pUserData = this;
+    callbacks.pfnAllocation = allocation;
+    callbacks.pfnReallocation = reallocation;
+    callbacks.pfnFree = free;
+    callbacks.pfnInternalAllocation = internalAllocation;
+    callbacks.pfnInternalFree = internalFree;
+    enabled = true;
+}
+
+bool HostAllocationTracker::isEnabled() const
+{
+    return enabled;
+}
+
+bool HostAllocationTracker::isPooled() const
+{
+    return pooled;
+}
+
+const VkAllocationCallbacks* HostAllocationTracker::getCallbacks() const
+{
+    return enabled ? &callbacks : nullptr;
+}
+
+HostAllocationTracker::ScopeStatistics HostAllocationTracker::getStatistics(VkSystemAllocationScope allocationScope) const
+{
+    const Counters& scopeCounters = counters[allocationScope];
+    ScopeStatistics statistics;
+    statistics.bytes = scopeCounters.bytes.load();
+    statistics.allocationCount = scopeCounters.allocationCount.load();
+    statistics.peakBytes = scopeCounters.peakBytes.load();
+    statistics.totalAllocationCount = scopeCounters.totalAllocationCount.load();
+    statistics.internalBytes = scopeCounters.internalBytes.load();
+    return statistics;
+}
+
+const char* HostAllocationTracker::getScopeName(VkSystemAllocationScope allocationScope)
+{
+    switch (allocationScope) {
+    case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+        return "Command";
+    case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+        return "Object";
+    case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+        return "Cache";
+    case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+        return "Device";
+    case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+        return "Instance";
+    default:
+        return "Unknown";
+    }
+}
+
+void* VKAPI_PTR HostAllocationTracker::allocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+    return static_cast<HostAllocationTracker*>(pUserData)->allocate(size, alignment, allocationScope);
+}
+
+void* VKAPI_PTR HostAllocationTracker::reallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+    HostAllocationTracker* tracker = static_cast<HostAllocationTracker*>(pUserData);
+    if (!pOriginal) {
+        return tracker->allocate(size, alignment, allocationScope);
+    }
+    if (size == 0) {
+        tracker->deallocate(pOriginal);
+        return nullptr;
+    }
+    // The original memory stays valid if the allocation fails
+    void* pMemory = tracker->allocate(size, alignment, allocationScope);
+    if (!pMemory) {
+        return nullptr;
+    }
+    const Header* header = reinterpret_cast<const Header*>(pOriginal) - 1;
+    memcpy(pMemory, pOriginal, header->size < size ? header->size : size);
+    tracker->deallocate(pOriginal);
+    return pMemory;
+}
+
+void VKAPI_PTR HostAllocationTracker::free(void* pUserData, void* pMemory)
+{
+    if (pMemory) {
+        static_cast<HostAllocationTracker*>(pUserData)->deallocate(pMemory);
+    }
+}
+
+void VKAPI_PTR HostAllocationTracker::internalAllocation(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
+{
+    static_cast<HostAllocationTracker*>(pUserData)->counters[allocationScope].internalBytes += (int64_t)size;
+}
+
+void VKAPI_PTR HostAllocationTracker::internalFree(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
+{
+    static_cast<HostAllocationTracker*>(pUserData)->counters[allocationScope].internalBytes -= (int64_t)size;
+}
+
+void* HostAllocationTracker::allocate(size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+    if (size == 0) {
+        return nullptr;
+    }
+    // The header is placed right before the returned pointer
+    if (alignment < alignof(Header)) {
+        alignment = alignof(Header);
+    }
+
+    uint8_t* pMemory = nullptr;
+    Header header{};
+    header.size = size;
+    header.scope = (uint8_t)allocationScope;
+    header.sizeClass = noSizeClass;
+    if (pooled && alignment == alignof(Header)) {
+        for (uint8_t i = 0; i < sizeClassCount; i++) {
+            if (sizeof(Header) + size <= sizeClasses[i].blockSize) {
+                header.sizeClass = i;
+                break;
+            }
+        }
+    }
+    if (header.sizeClass != noSizeClass) {
+        uint8_t* pBlock = static_cast<uint8_t*>(allocateBlock(header.sizeClass));
+        if (!pBlock) {
+            return nullptr;
+        }
+        header.offset = sizeof(Header);
+        pMemory = pBlock + sizeof(Header);
+    }
+    else {
+        uint8_t* pRaw = static_cast<uint8_t*>(std::malloc(sizeof(Header) + size + alignment));
+        if (!pRaw) {
+            return nullptr;
+        }
+        uintptr_t address = reinterpret_cast<uintptr_t>(pRaw) + sizeof(Header);
+        address = (address + alignment - 1) / alignment * alignment;
+        pMemory = reinterpret_cast<uint8_t*>(address);
+        header.offset = (uint32_t)(pMemory - pRaw);
+    }
+    memcpy(pMemory - sizeof(Header), &header, sizeof(Header));
+
+    Counters& scopeCounters = counters[allocationScope];
+    int64_t bytes = scopeCounters.bytes += (int64_t)size;
+    scopeCounters.allocationCount++;
+    scopeCounters.totalAllocationCount++;
+    int64_t peakBytes = scopeCounters.peakBytes.load();
+    while (bytes > peakBytes && !scopeCounters.peakBytes.compare_exchange_weak(peakBytes, bytes)) { }
+    return pMemory;
+}
+
+void HostAllocationTracker::deallocate(void* pMemory)
+{
+    uint8_t* pBytes = static_cast<uint8_t*>(pMemory);
+    Header header;
+    memcpy(&header, pBytes - sizeof(Header), sizeof(Header));
+
+    Counters& scopeCounters = counters[header.scope];
+    scopeCounters.bytes -= (int64_t)header.size;
+    scopeCounters.allocationCount--;
+
+    uint8_t* pRaw = pBytes - header.offset;
+    if (header.sizeClass == noSizeClass) {
+        std::free(pRaw);
+        return;
+    }
+    // The first bytes of a free block are the next free block
+    SizeClass& sizeClass = sizeClasses[header.sizeClass];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    *reinterpret_cast<void**>(pRaw) = sizeClass.freeList;
+    sizeClass.freeList = pRaw;
+}
+
+void* HostAllocationTracker::allocateBlock(uint8_t sizeClassIndex)
+{
+    SizeClass& sizeClass = sizeClasses[sizeClassIndex];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    if (!sizeClass.freeList) {
+        // malloc alignment is enough for the 16 bytes aligned header
+        uint8_t* pChunk = static_cast<uint8_t*>(std::malloc(chunkSize));
+        if (!pChunk) {
+            return nullptr;
+        }
+        sizeClass.chunks.push_back(pChunk);
+        for (size_t offset = 0; offset + sizeClass.blockSize <= chunkSize; offset += sizeClass.blockSize) {
+            *reinterpret_cast<void**>(pChunk + offset) = sizeClass.freeList;
+            sizeClass.freeList = pChunk + offset;
+        }
+    }
+    void* pBlock = sizeClass.freeList;
+    sizeClass.freeList = *reinterpret_cast<void**>(pBlock);
+    return pBlock;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+// VkAllocationCallbacks that count the host memory allocated by the Vulkan implementation(and VMA) per allocation scope
+// The callbacks are passed to all vkCreate*/vkDestroy* calls of the base and the samples through getHostAllocationCallbacks(),
+// it returns nullptr until the tracking is enabled, so by default the implementation uses its own allocator
+// Optionally small allocations are served from size class free lists instead of malloc(pooled mode)
+class HostAllocationTracker
+{
+public:
+    static const uint32_t scopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    class ScopeStatistics
+    {
+    public:
+        // Currently allocated by the callbacks
+        int64_t     bytes = 0;
+        int64_t     allocationCount = 0;
+        int64_t     peakBytes = 0;
+        // All allocations since enable(), the allocation rate shows the per-frame driver allocations
+        uint64_t    totalAllocationCount = 0;
+        // Reported by the implementation through pfnInternalAllocation(e.g. executable memory)
+        int64_t     internalBytes = 0;
+    };
+
+private:
+    class Counters
+    {
+    public:
+        std::atomic<int64_t>    bytes = 0;
+        std::atomic<int64_t>    allocationCount = 0;
+        std::atomic<int64_t>    peakBytes = 0;
+        std::atomic<uint64_t>   totalAllocationCount = 0;
+        std::atomic<int64_t>    internalBytes = 0;
+    };
+
+    // Stored before every returned pointer
+    class alignas(16) Header
+    {
+    public:
+        size_t      size;
+        // From the malloc'ed pointer to the returned one
+        uint32_t    offset;
+        uint8_t     scope;
+        // Index of the size class, noSizeClass - allocated by malloc
+        uint8_t     sizeClass;
+    };
+    static const uint8_t noSizeClass = 0xFF;
+
+    // Free list of the blocks of one size(header included)
+    class SizeClass
+    {
+    public:
+        std::mutex          mutex;
+        size_t              blockSize = 0;
+        void*               freeList = nullptr;
+        std::vector<void*>  chunks;
+    };
+    static const size_t sizeClassCount = 6;
+    // 64 - 2048 bytes blocks
+    static const size_t minBlockSize = 64;
+    static const size_t chunkSize = 64 * 1024;
+
+    VkAllocationCallbacks   callbacks{};
+    bool                    enabled = false;
+    bool                    pooled = false;
+    Counters                counters[scopeCount];
+    SizeClass               sizeClasses[sizeClassCount];
+
+    static void* VKAPI_PTR allocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+    static void* VKAPI_PTR reallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+    static void VKAPI_PTR free(void* pUserData, void* pMemory);
+    static void VKAPI_PTR internalAllocation(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
+    static void VKAPI_PTR internalFree(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
+
+    void* allocate(size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+    void deallocate(void* pMemory);
+    // The block of the size class, a new chunk is allocated if the free list is empty
+    void* allocateBlock(uint8_t sizeClassIndex);
+
+public:
+    ~HostAllocationTracker();
+
+    // Must be called before the instance is created and can't be disabled, all objects must be destroyed with the same callbacks
+    // pooled - allocations up to 2 KB with up to 16 bytes alignment are served from the size class free lists
+    void enable(bool pooled);
+    bool isEnabled() const;
+    bool isPooled() const;
+    // nullptr if the tracking isn't enabled
+    const VkAllocationCallbacks* getCallbacks() const;
+
+    ScopeStatistics getStatistics(VkSystemAllocationScope allocationScope) const;
+    static const char* getScopeName(VkSystemAllocationScope allocationScope);
+};
+
+extern HostAllocationTracker hostAllocationTracker;
+
+// pAllocator for the vkCreate*/vkDestroy* calls
+const VkAllocationCallbacks* getHostAllocationCallbacks();
@@ -3,23 +3,35 @@
 #include "VulkanSwapChain.h"
 #include "VulkanInitializers.hpp"
 
-void ImGuiUI::initImGui(VkInstance instance, VulkanDevice* vulkanDevice, VkQueue graphicsQueue, int minImageCount, int imageCount, VulkanSwapChain* vulkanSwapChain, GLFWwindow* window, int maxFramesInFlight)
+void ImGuiUI::initImGui(VkInstance instance, VulkanDevice* vulkanDevice, VkQueue graphicsQueue, int minImageCount, int imageCount, VulkanSwapChain* vulkanSwapChain, GLFWwindow* window, int maxFramesInFlight, GpuProfiler* gpuProfiler, VkRenderPass sceneRenderPass)
 {
     this->instance = instance;
     this->vulkanDevice = vulkanDevice;
     this->vulkanSwapChain = vulkanSwapChain;
+    this->window = window;
+    this->gpuProfiler = gpuProfiler;
     this->maxFramesInFlight = maxFramesInFlight;
+    this->sceneRenderPass = sceneRenderPass;
     this->createDescriptorPool();
+    // The command pool is also used to upload the fonts
     this->createCommandPool();
-    this->allocateCommandBuffers();
-    this->createRenderPass();
-    this->createFramebuffers();
+    if (!sceneRenderPass) {
+        this->allocateCommandBuffers();
+        this->createRenderPass();
+        this->createFramebuffers();
+    }
 
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     // Disable imgui.ini file
     io.IniFilename = nullptr;
-    ImGui_ImplGlfw_InitForVulkan(window, true);
+    if (window) {
+        ImGui_ImplGlfw_InitForVulkan(window, true);
+    }
+    else {
+        // There is no window, the display size is the size of the offscreen images
+        io.DisplaySize = ImVec2((float)vulkanSwapChain->surfaceExtent.width, (float)vulkanSwapChain->surfaceExtent.height);
+    }
     ImGui_ImplVulkan_InitInfo implVulkanInitInfo{};
     implVulkanInitInfo.Instance = instance;
     implVulkanInitInfo.PhysicalDevice = vulkanDevice->physicalDevice;
@@ -32,9 +44,10 @@ void ImGuiUI::initImGui(VkInstance instance, VulkanDevice* vulkanDevice, VkQueue
     implVulkanInitInfo.MinImageCount = minImageCount;
     implVulkanInitInfo.ImageCount = imageCount;
     implVulkanInitInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-    implVulkanInitInfo.Allocator = nullptr;
+    implVulkanInitInfo.Allocator = getHostAllocationCallbacks();
     implVulkanInitInfo.CheckVkResultFn = nullptr;
-    ImGui_ImplVulkan_Init(&implVulkanInitInfo, imguiRenderPass);
+    // The pipeline is created for the render pass the UI is drawn in
+    ImGui_ImplVulkan_Init(&implVulkanInitInfo, sceneRenderPass ? sceneRenderPass : imguiRenderPass);
 
     // Upload font textures to the GPU
     VkCommandBuffer uploadCommandBuffer = vulkanDevice->beginSingleTimeCommands(imguiCommandPool);
@@ -47,19 +60,23 @@ void ImGuiUI::cleanupImGui()
     vkDeviceWaitIdle(vulkanDevice->logicalDevice);
 
     ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if (window) {
+        ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
 
     // Framebuffers
     for (auto& framebuffer : imguiFramebuffers) {
-        vkDestroyFramebuffer(vulkanDevice->logicalDevice, framebuffer, nullptr);
+        vkDestroyFramebuffer(vulkanDevice->logicalDevice, framebuffer, getHostAllocationCallbacks());
     }
     // Renderpass
-    vkDestroyRenderPass(vulkanDevice->logicalDevice, imguiRenderPass, nullptr);
+    if (imguiRenderPass) {
+        vkDestroyRenderPass(vulkanDevice->logicalDevice, imguiRenderPass, getHostAllocationCallbacks());
+    }
     // Command pool
-    vkDestroyCommandPool(vulkanDevice->logicalDevice, imguiCommandPool, nullptr);
+    vkDestroyCommandPool(vulkanDevice->logicalDevice, imguiCommandPool, getHostAllocationCallbacks());
     // Descriptor pool
-    vkDestroyDescriptorPool(vulkanDevice->logicalDevice, imguiDescriptorPool, nullptr);
+    vkDestroyDescriptorPool(vulkanDevice->logicalDevice, imguiDescriptorPool, getHostAllocationCallbacks());
 }
 
 void ImGuiUI::resize(VulkanSwapChain* vulkanSwapChain)
@@ -68,10 +85,12 @@ void ImGuiUI::resize(VulkanSwapChain* vulkanSwapChain)
 
     // Delete old framebuffers
     for (auto& framebuffer : imguiFramebuffers) {
-        vkDestroyFramebuffer(vulkanDevice->logicalDevice, framebuffer, nullptr);
+        vkDestroyFramebuffer(vulkanDevice->logicalDevice, framebuffer, getHostAllocationCallbacks());
     }
 
-    this->createFramebuffers();
+    if (!sceneRenderPass) {
+        this->createFramebuffers();
+    }
 
     ImGui_ImplVulkan_SetMinImageCount(vulkanSwapChain->surfaceSupportDetails.capabilities.minImageCount);
 }
@@ -79,7 +98,15 @@ void ImGuiUI::resize(VulkanSwapChain* vulkanSwapChain)
 void ImGuiUI::beginFrame()
 {
     ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
+    if (window) {
+        ImGui_ImplGlfw_NewFrame();
+    }
+    else {
+        // Headless, no input and fixed time step
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2((float)vulkanSwapChain->surfaceExtent.width, (float)vulkanSwapChain->surfaceExtent.height);
+        io.DeltaTime = 1.0f / 60.0f;
+    }
     ImGui::NewFrame();
 }
 
@@ -104,11 +131,17 @@ VkCommandBuffer ImGuiUI::recordAndGetCommandBuffer(int currentFrameIndex, int cu
     renderPassBeginInfo.framebuffer = imguiFramebuffers[currentImageIndex];
     renderPassBeginInfo.renderArea.offset = { 0, 0 };
     renderPassBeginInfo.renderArea.extent = vulkanSwapChain->surfaceExtent;
+    if (gpuProfiler) {
+        gpuProfiler->beginScope(commandBuffer, "ImGui");
+    }
     vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
     
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), imguiCommandBuffers[currentFrameIndex]);
 
     vkCmdEndRenderPass(commandBuffer);
+    if (gpuProfiler) {
+        gpuProfiler->endScope(commandBuffer, "ImGui");
+    }
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to record imgui command buffer!");
     }
@@ -116,6 +149,17 @@ VkCommandBuffer ImGuiUI::recordAndGetCommandBuffer(int currentFrameIndex, int cu
     return commandBuffer;
 }
 
+void ImGuiUI::recordInRenderPass(VkCommandBuffer commandBuffer)
+{
+    if (gpuProfiler) {
+        gpuProfiler->beginScope(commandBuffer, "ImGui");
+    }
+    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+    if (gpuProfiler) {
+        gpuProfiler->endScope(commandBuffer, "ImGui");
+    }
+}
+
 void ImGuiUI::createDescriptorPool()
 {
     const std::vector<VkDescriptorPoolSize> poolSizes =
@@ -135,7 +179,7 @@ void ImGuiUI::createDescriptorPool()
 
     VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = vulkanInitializers::descriptorPoolCreateInfo(poolSizes, 1000);
 
-    if (vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &imguiDescriptorPool) != VK_SUCCESS) {
+    if (vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &imguiDescriptorPool) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create imgui descriptor pool!");
     }
 }
@@ -146,7 +190,7 @@ void ImGuiUI::createCommandPool()
     commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     commandPoolCreateInfo.queueFamilyIndex = vulkanDevice->queueFamilyIndices.graphics.value();
 
-    if (vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, nullptr, &imguiCommandPool) != VK_SUCCESS) {
+    if (vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, getHostAllocationCallbacks(), &imguiCommandPool) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create imgui command pool!");
     }
 }
@@ -174,7 +218,8 @@ void ImGuiUI::createRenderPass()
     attachmentsDescriptions.back().stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachmentsDescriptions.back().stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     attachmentsDescriptions.back().initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    attachmentsDescriptions.back().finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // Offscreen images are not presented, they can only be copied somewhere
+    attachmentsDescriptions.back().finalLayout = vulkanSwapChain->offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     // Attachments references
     std::vector<VkAttachmentReference> attachmentsReferences;
@@ -211,7 +256,7 @@ void ImGuiUI::createRenderPass()
     renderpassCreateInfo.dependencyCount = subpassDependencies.size();
     renderpassCreateInfo.pDependencies = subpassDependencies.data();
 
-    if (vkCreateRenderPass(vulkanDevice->logicalDevice, &renderpassCreateInfo, nullptr, &imguiRenderPass) != VK_SUCCESS) {
+    if (vkCreateRenderPass(vulkanDevice->logicalDevice, &renderpassCreateInfo, getHostAllocationCallbacks(), &imguiRenderPass) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create imgui renderpass!");
     }
 }
@@ -234,7 +279,7 @@ void ImGuiUI::createFramebuffers()
         framebufferCreateInfo.height = vulkanSwapChain->surfaceExtent.height;
         framebufferCreateInfo.layers = 1;
 
-        if (vkCreateFramebuffer(vulkanDevice->logicalDevice, &framebufferCreateInfo, nullptr, &imguiFramebuffers[i]) != VK_SUCCESS) {
+        if (vkCreateFramebuffer(vulkanDevice->logicalDevice, &framebufferCreateInfo, getHostAllocationCallbacks(), &imguiFramebuffers[i]) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create imgui framebuffers!");
         }
     }
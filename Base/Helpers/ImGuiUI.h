@@ -10,6 +10,7 @@
 #include <../imgui/imgui_impl_vulkan.h>
 #include "VulkanDevice.h"
 #include "VulkanSwapChain.h"
+#include "GpuProfiler.h"
 
 class ImGuiUI
 {
@@ -17,24 +18,36 @@ private:
     VkInstance instance;
     VulkanDevice* vulkanDevice = nullptr;
     VulkanSwapChain* vulkanSwapChain = nullptr;
+    // nullptr in headless mode, the GLFW backend is not used then
+    GLFWwindow* window = nullptr;
+    // UI rendering is measured in the "ImGui" scope, can be nullptr
+    GpuProfiler* gpuProfiler = nullptr;
     int maxFramesInFlight;
-    VkDescriptorPool imguiDescriptorPool;
-    VkCommandPool imguiCommandPool;
+    VkDescriptorPool imguiDescriptorPool = VK_NULL_HANDLE;
+    VkCommandPool imguiCommandPool = VK_NULL_HANDLE;
+    // Own command buffers, render pass and framebuffers are not created if the UI is drawn in the scene render pass
     std::vector<VkCommandBuffer> imguiCommandBuffers;
     std::vector<VkFramebuffer> imguiFramebuffers;
-    VkRenderPass imguiRenderPass;
+    VkRenderPass imguiRenderPass = VK_NULL_HANDLE;
+    // Scene render pass(subpass 0) the UI is drawn in, VK_NULL_HANDLE if the UI has its own render pass
+    VkRenderPass sceneRenderPass = VK_NULL_HANDLE;
 public:
     // Creating descriptor pool
     // Creating command pool
     // Allocating command buffers
     // Creating renderpass
     // Creating framebuffers
-    void initImGui(VkInstance instance, VulkanDevice* vulkanDevice, VkQueue graphicsQueue, int minImageCount, int imageCount, VulkanSwapChain* vulkanSwapChain, GLFWwindow* window, int maxFramesInFlight);
+    // sceneRenderPass - if not VK_NULL_HANDLE, the UI is recorded into this render pass by recordInRenderPass()
+    // instead of its own render pass that loads the rendered frame again
+    void initImGui(VkInstance instance, VulkanDevice* vulkanDevice, VkQueue graphicsQueue, int minImageCount, int imageCount, VulkanSwapChain* vulkanSwapChain, GLFWwindow* window, int maxFramesInFlight, GpuProfiler* gpuProfiler = nullptr, VkRenderPass sceneRenderPass = VK_NULL_HANDLE);
     void cleanupImGui();
     void resize(VulkanSwapChain* vulkanSwapChain);
     void beginFrame();
     void endFrame();
+    // Records the UI in its own render pass into its own command buffer
     VkCommandBuffer recordAndGetCommandBuffer(int currentFrameIndex, int currentImageIndex);
+    // Records the UI into the scene render pass, the command buffer must be inside subpass 0 of sceneRenderPass
+    void recordInRenderPass(VkCommandBuffer commandBuffer);
 private:
     void createDescriptorPool();
     void createCommandPool();
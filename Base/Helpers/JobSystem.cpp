@@ -0,0 +1,230 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+// Index of the current thread in the job system, non-worker threads use the main thread index
+static thread_local uint32_t workerThreadIndex = UINT32_MAX;
+
+bool JobSystem::TaskGroup::isFinished() const
+{
+    return pendingJobs.load() == 0;
+}
+
+void* JobSystem::ScratchArena::allocate(size_t size, size_t alignment)
+{
+    while (true) {
+        if (currentBlock < blocks.size()) {
+            Block& block = blocks[currentBlock];
+            uintptr_t address = reinterpret_cast<uintptr_t>(block.data.get()) + offset;
+            size_t padding = (alignment - address % alignment) % alignment;
+            if (offset + padding + size <= block.size) {
+                offset += padding + size;
+                return reinterpret_cast<void*>(address + padding);
+            }
+            // Doesn't fit, try the next block
+            currentBlock++;
+            offset = 0;
+            continue;
+        }
+        Block block;
+        block.size = std::max(BLOCK_SIZE, size + alignment);
+        block.data.reset(new uint8_t[block.size]);
+        blocks.push_back(std::move(block));
+    }
+}
+
+JobSystem::ScratchArena::Marker JobSystem::ScratchArena::getMarker() const
+{
+    Marker marker;
+    marker.block = currentBlock;
+    marker.offset = offset;
+    return marker;
+}
+
+void JobSystem::ScratchArena::rewind(const Marker& marker)
+{
+    currentBlock = marker.block;
+    offset = marker.offset;
+}
+
+void JobSystem::start(uint32_t workerCount)
+{
+    if (workerCount == 0) {
+        // hardware_concurrency() can return 0 if the value is not computable
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    stop = false;
+    for (uint32_t i = 0; i < workerCount + 1; i++) {
+        queues.push_back(std::make_unique<JobQueue>());
+        scratchArenas.push_back(std::make_unique<ScratchArena>());
+    }
+    threads.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::finish()
+{
+    if (queues.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stop = true;
+    }
+    jobAdded.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    queues.clear();
+    scratchArenas.clear();
+}
+
+JobSystem::~JobSystem()
+{
+    finish();
+}
+
+uint32_t JobSystem::getWorkerCount() const
+{
+    return (uint32_t)threads.size();
+}
+
+uint32_t JobSystem::getThreadCount() const
+{
+    return (uint32_t)queues.size();
+}
+
+uint32_t JobSystem::getCurrentThreadIndex() const
+{
+    return workerThreadIndex == UINT32_MAX ? getWorkerCount() : workerThreadIndex;
+}
+
+void JobSystem::run(TaskGroup& group, Job job)
+{
+    group.pendingJobs++;
+    JobQueue& queue = *queues[getCurrentThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({ std::move(job), &group });
+    }
+    {
+        // Under the mutex, so a worker going to sleep can't miss the job
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs++;
+    }
+    jobAdded.notify_one();
+}
+
+void JobSystem::runBackground(TaskGroup& group, Job job)
+{
+    group.pendingJobs++;
+    {
+        std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+        backgroundQueue.jobs.push_back({ std::move(job), &group });
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs++;
+    }
+    jobAdded.notify_one();
+}
+
+void JobSystem::wait(TaskGroup& group)
+{
+    uint32_t threadIndex = getCurrentThreadIndex();
+    while (!group.isFinished()) {
+        QueuedJob queuedJob;
+        if (takeJob(threadIndex, queuedJob, false)) {
+            execute(queuedJob, threadIndex);
+        }
+        else {
+            // The remaining jobs of the group are being executed by other threads
+            std::this_thread::yield();
+        }
+    }
+    if (group.exception) {
+        std::exception_ptr exception = group.exception;
+        group.exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+JobSystem::ScratchArena& JobSystem::getScratchArena()
+{
+    return *scratchArenas[getCurrentThreadIndex()];
+}
+
+bool JobSystem::takeJob(uint32_t threadIndex, QueuedJob& queuedJob, bool takeBackground)
+{
+    // Own queue: the newest job, its data is likely still in the cache
+    {
+        JobQueue& queue = *queues[threadIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            queuedJob = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            queuedJobs--;
+            return true;
+        }
+    }
+    // Other queues: the oldest job, it is usually the biggest piece of work
+    for (uint32_t i = 1; i < queues.size(); i++) {
+        JobQueue& queue = *queues[(threadIndex + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            queuedJob = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            queuedJobs--;
+            return true;
+        }
+    }
+    if (takeBackground) {
+        std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+        if (!backgroundQueue.jobs.empty()) {
+            queuedJob = std::move(backgroundQueue.jobs.front());
+            backgroundQueue.jobs.pop_front();
+            queuedJobs--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(QueuedJob& queuedJob, uint32_t threadIndex)
+{
+    TaskGroup& group = *queuedJob.group;
+    ScratchArena& scratchArena = *scratchArenas[threadIndex];
+    ScratchArena::Marker marker = scratchArena.getMarker();
+    try {
+        queuedJob.job(threadIndex);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(group.exceptionMutex);
+        if (!group.exception) {
+            group.exception = std::current_exception();
+        }
+    }
+    // Temporary allocations of the job
+    scratchArena.rewind(marker);
+    // The last access to the group, the waiting thread may destroy it right after
+    group.pendingJobs--;
+}
+
+void JobSystem::workerLoop(uint32_t threadIndex)
+{
+    workerThreadIndex = threadIndex;
+    while (true) {
+        QueuedJob queuedJob;
+        if (takeJob(threadIndex, queuedJob, true)) {
+            execute(queuedJob, threadIndex);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        jobAdded.wait(lock, [this] { return stop || queuedJobs > 0; });
+        if (stop) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job scheduler
+// Each thread has its own job queue: a thread takes the newest job of its queue and, if it is empty,
+// steals the oldest job of another queue. The thread that waits for a task group executes jobs too
+// Thread indices: worker threads are [0, getWorkerCount()), the main(any non-worker) thread is getWorkerCount()
+// Only one non-worker thread may use the job system
+// Background jobs(long tasks like asset decoding) are executed only by workers when they have no other jobs,
+// a thread waiting for a task group never picks them up, so a frame never waits for them
+class JobSystem
+{
+public:
+    // job(threadIndex), threadIndex is in [0, getThreadCount())
+    using Job = std::function<void(uint32_t threadIndex)>;
+
+    // Set of jobs that can be waited together
+    class TaskGroup
+    {
+        friend class JobSystem;
+    private:
+        std::atomic<uint32_t>   pendingJobs{ 0 };
+        // The first exception thrown by a job, rethrown by wait()
+        std::exception_ptr      exception;
+        std::mutex              exceptionMutex;
+    public:
+        bool isFinished() const;
+    };
+
+    // Per-thread linear allocator for temporary data of jobs
+    // Memory allocated by a job is released when the job returns(the arena is rewound to its position at the job start),
+    // so jobs executed by a waiting job on the same thread don't release the memory of the waiting one
+    // Outside of jobs the memory is valid until the caller rewinds the arena to a marker taken before
+    class ScratchArena
+    {
+    public:
+        static const size_t BLOCK_SIZE = 1 << 20;
+
+        // Position in the arena
+        class Marker
+        {
+        public:
+            size_t  block = 0;
+            size_t  offset = 0;
+        };
+    private:
+        class Block
+        {
+        public:
+            std::unique_ptr<uint8_t[]>  data;
+            size_t                      size = 0;
+        };
+        std::vector<Block>  blocks;
+        size_t              currentBlock = 0;
+        size_t              offset = 0;
+    public:
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // Memory for count objects of type T(constructors are not called)
+        template <typename T>
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        Marker getMarker() const;
+        // Releases the memory allocated after the marker was taken, keeps the blocks for reuse
+        void rewind(const Marker& marker);
+    };
+
+private:
+    class QueuedJob
+    {
+    public:
+        Job         job;
+        TaskGroup*  group = nullptr;
+    };
+
+    class JobQueue
+    {
+    public:
+        std::mutex              mutex;
+        std::deque<QueuedJob>   jobs;
+    };
+
+    std::vector<std::thread>                    threads;
+    // One queue and one arena per thread, the last ones belong to the main thread
+    std::vector<std::unique_ptr<JobQueue>>      queues;
+    std::vector<std::unique_ptr<ScratchArena>>  scratchArenas;
+    JobQueue                                    backgroundQueue;
+    // Idle workers sleep until a job is added
+    std::mutex                                  sleepMutex;
+    std::condition_variable                     jobAdded;
+    std::atomic<uint32_t>                       queuedJobs{ 0 };
+    std::atomic<bool>                           stop{ false };
+
+public:
+    // workerCount 0 - one worker per hardware thread except the main one
+    void start(uint32_t workerCount = 0);
+    // Joins the workers, all task groups must have been waited
+    void finish();
+    ~JobSystem();
+
+    uint32_t getWorkerCount() const;
+    // Workers and the main thread, the number of per-thread resources(e.g. command pools)
+    uint32_t getThreadCount() const;
+    uint32_t getCurrentThreadIndex() const;
+
+    // Adds a job to the queue of the calling thread
+    void run(TaskGroup& group, Job job);
+
+    // Adds a job to the background queue, the job must not wait for other jobs
+    void runBackground(TaskGroup& group, Job job);
+
+    // Executes jobs until all jobs of the group have been finished
+    // Rethrows the first exception thrown by the jobs of the group
+    void wait(TaskGroup& group);
+
+    // Calls function(first, end, threadIndex) for the ranges of [0, count) of grainSize elements in parallel and waits for them
+    template <typename Function>
+    void parallelFor(uint32_t count, uint32_t grainSize, Function function)
+    {
+        if (grainSize == 0) {
+            grainSize = 1;
+        }
+        TaskGroup group;
+        for (uint32_t first = 0; first < count; first += grainSize) {
+            uint32_t end = count - first > grainSize ? first + grainSize : count;
+            run(group, [first, end, &function](uint32_t threadIndex) { function(first, end, threadIndex); });
+        }
+        wait(group);
+    }
+
+    // Scratch arena of the calling thread
+    ScratchArena& getScratchArena();
+
+private:
+    // Takes the newest job of the own queue or steals the oldest job of another queue
+    // Takes the oldest background job if there are no other jobs and takeBackground is true
+    bool takeJob(uint32_t threadIndex, QueuedJob& queuedJob, bool takeBackground);
+    void execute(QueuedJob& queuedJob, uint32_t threadIndex);
+    void workerLoop(uint32_t threadIndex);
+};
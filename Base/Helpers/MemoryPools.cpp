@@ -0,0 +1,118 @@
+#include "MemoryPools.h"
+#include "VulkanBuffer.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+void MemoryPools::init(VmaAllocator vmaAllocator)
+{
+    this->vmaAllocator = vmaAllocator;
+
+    for (size_t i = 0; i < (size_t)Category::Count; i++) {
+        Category category = (Category)i;
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        uint32_t memoryTypeIndex = 0;
+        VkResult result = VK_SUCCESS;
+        if (category == Category::Textures) {
+            VkImageCreateInfo imageCreateInfo{};
+            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+            imageCreateInfo.extent = { 1024, 1024, 1 };
+            imageCreateInfo.mipLevels = 1;
+            imageCreateInfo.arrayLayers = 1;
+            imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            result = vmaFindMemoryTypeIndexForImageInfo(vmaAllocator, &imageCreateInfo, &allocationCreateInfo, &memoryTypeIndex);
+        }
+        else {
+            VkBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferCreateInfo.size = 0x10000;
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (category == Category::StaticGeometry) {
+                bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+                // The same memory type as VulkanBuffer::createStaticBuffer() chooses
+                if (VulkanBuffer::hasHostVisibleDeviceMemory(vmaAllocator)) {
+                    allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
+                }
+                else {
+                    allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+                }
+            }
+            else if (category == Category::PerFrame) {
+                // The same memory type as VulkanBuffer::createDynamicBuffer() chooses(device local if it is host visible)
+                bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+                allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+                allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+                allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+            }
+            else {
+                bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+                allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+                allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+            }
+            result = vmaFindMemoryTypeIndexForBufferInfo(vmaAllocator, &bufferCreateInfo, &allocationCreateInfo, &memoryTypeIndex);
+        }
+        if (result != VK_SUCCESS) {
+            throw MakeErrorInfo(std::string("Failed to find memory type for the memory pool ") + getName(category) + "!");
+        }
+
+        const PoolSettings& poolSettings = settings[i];
+        VmaPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.memoryTypeIndex = memoryTypeIndex;
+        poolCreateInfo.blockSize = poolSettings.blockSize;
+        poolCreateInfo.maxBlockCount = poolSettings.maxBlockCount;
+        if (poolSettings.linearAlgorithm) {
+            poolCreateInfo.flags |= VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT;
+        }
+        if (vmaCreatePool(vmaAllocator, &poolCreateInfo, &pools[i]) != VK_SUCCESS) {
+            throw MakeErrorInfo(std::string("Failed to create memory pool ") + getName(category) + "!");
+        }
+        // Shown in the statistics JSON
+        vmaSetPoolName(vmaAllocator, pools[i], getName(category));
+    }
+}
+
+void MemoryPools::destroy()
+{
+    for (VmaPool& pool : pools) {
+        if (pool) {
+            vmaDestroyPool(vmaAllocator, pool);
+            pool = nullptr;
+        }
+    }
+}
+
+VmaPool MemoryPools::getPool(Category category) const
+{
+    return pools[(size_t)category];
+}
+
+const char* MemoryPools::getName(Category category)
+{
+    switch (category) {
+    case Category::StaticGeometry:
+        return "Static geometry";
+    case Category::Textures:
+        return "Textures";
+    case Category::PerFrame:
+        return "Per-frame";
+    case Category::Staging:
+        return "Staging";
+    default:
+        return "Unknown";
+    }
+}
+
+VmaStatistics MemoryPools::getStatistics(Category category) const
+{
+    VmaStatistics statistics{};
+    if (pools[(size_t)category]) {
+        vmaGetPoolStatistics(vmaAllocator, pools[(size_t)category], &statistics);
+    }
+    return statistics;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "vk_mem_alloc.h"
+
+// Named VMA pools, one per allocation category, so resources with different lifetimes don't share memory blocks
+// A pool is created for one memory type, it is found by a typical resource of the category
+// Images whose requirements exclude the type of the Textures pool are allocated from the default pools(VulkanTexture::createImage())
+// Blocks are allocated on demand, an unused pool takes no memory
+// Resources are allocated from a pool if it is passed to VulkanBuffer::createBuffer() or the texture creators
+class MemoryPools
+{
+public:
+    enum class Category
+    {
+        // Device local vertex and index buffers(host visible with resizable BAR or UMA)
+        StaticGeometry,
+        // Device local sampled images
+        Textures,
+        // Host visible buffers written every frame(uniform buffers), device local if possible, linear algorithm
+        PerFrame,
+        // Host visible transfer sources, linear algorithm
+        Staging,
+        Count
+    };
+
+    class PoolSettings
+    {
+    public:
+        // 0 - VMA default block size
+        VkDeviceSize    blockSize = 0;
+        // 0 - unlimited
+        size_t          maxBlockCount = 0;
+        // VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT, allocations are placed one after another without a free list search
+        // Freed space is reused when the allocations after it are freed too(stack and ring buffer usage)
+        bool            linearAlgorithm = false;
+    };
+
+    // Used by init(), can be changed before it
+    PoolSettings settings[(size_t)Category::Count] = {
+        { 64 * 1024 * 1024, 0, false },
+        { 128 * 1024 * 1024, 0, false },
+        { 16 * 1024 * 1024, 0, true },
+        // Fits the staging ring of the upload manager
+        { 64 * 1024 * 1024, 0, true },
+    };
+
+private:
+    VmaAllocator    vmaAllocator = nullptr;
+    VmaPool         pools[(size_t)Category::Count]{};
+
+public:
+    void init(VmaAllocator vmaAllocator);
+    void destroy();
+
+    VmaPool getPool(Category category) const;
+    static const char* getName(Category category);
+    // Allocated and block bytes of the pool, cheap(doesn't walk the allocations)
+    VmaStatistics getStatistics(Category category) const;
+};
@@ -0,0 +1,78 @@
+#include "MemoryStatistics.h"
+#include <fstream>
+
+void MemoryStatistics::init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, bool budgetEnabled)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->budgetEnabled = budgetEnabled;
+    heaps.assign(vulkanDevice->memoryProperties.memoryHeapCount, HeapStatistics());
+    for (uint32_t i = 0; i < heaps.size(); i++) {
+        heaps[i].size = vulkanDevice->memoryProperties.memoryHeaps[i].size;
+        heaps[i].deviceLocal = vulkanDevice->memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    }
+    detailedUpdated = false;
+    update();
+}
+
+void MemoryStatistics::update()
+{
+    // Budgets are cached by VMA, this is cheap
+    std::vector<VmaBudget> budgets(heaps.size());
+    vmaGetHeapBudgets(vmaAllocator, budgets.data());
+    for (uint32_t i = 0; i < heaps.size(); i++) {
+        heaps[i].usage = budgets[i].usage;
+        heaps[i].budget = budgets[i].budget;
+        if (heaps[i].usage > heaps[i].peakUsage) {
+            heaps[i].peakUsage = heaps[i].usage;
+        }
+    }
+
+    std::chrono::time_point<std::chrono::steady_clock> currentTime = std::chrono::steady_clock::now();
+    if (detailedUpdated && std::chrono::duration<double, std::chrono::milliseconds::period>(currentTime - lastDetailedUpdateTime).count() < updateInterval) {
+        return;
+    }
+    lastDetailedUpdateTime = currentTime;
+    detailedUpdated = true;
+
+    VmaTotalStatistics totalStatistics{};
+    vmaCalculateStatistics(vmaAllocator, &totalStatistics);
+    for (uint32_t i = 0; i < heaps.size(); i++) {
+        const VmaDetailedStatistics& heapStatistics = totalStatistics.memoryHeap[i];
+        heaps[i].allocationCount = heapStatistics.statistics.allocationCount;
+        heaps[i].allocationBytes = heapStatistics.statistics.allocationBytes;
+        heaps[i].blockCount = heapStatistics.statistics.blockCount;
+        heaps[i].blockBytes = heapStatistics.statistics.blockBytes;
+        // Share of the free memory that is not in the largest free range
+        VkDeviceSize unusedBytes = heapStatistics.statistics.blockBytes - heapStatistics.statistics.allocationBytes;
+        if (unusedBytes > 0 && heapStatistics.unusedRangeCount > 0) {
+            heaps[i].fragmentation = 1.0f - float(double(heapStatistics.unusedRangeSizeMax) / double(unusedBytes));
+        }
+        else {
+            heaps[i].fragmentation = 0.0f;
+        }
+    }
+}
+
+const std::vector<MemoryStatistics::HeapStatistics>& MemoryStatistics::getHeaps() const
+{
+    return heaps;
+}
+
+bool MemoryStatistics::isBudgetEnabled() const
+{
+    return budgetEnabled;
+}
+
+bool MemoryStatistics::writeJson(const std::string& filePath) const
+{
+    char* statsString = nullptr;
+    vmaBuildStatsString(vmaAllocator, &statsString, VK_TRUE);
+    std::ofstream file(filePath);
+    bool written = file.is_open();
+    if (written) {
+        file << statsString;
+    }
+    vmaFreeStatsString(vmaAllocator, statsString);
+    return written;
+}
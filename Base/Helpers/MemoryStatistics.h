@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "VulkanDevice.h"
+#include "vk_mem_alloc.h"
+
+// VMA memory statistics per heap: usage and budget(from VK_EXT_memory_budget if it is enabled, otherwise estimated by VMA),
+// allocation and block counts and fragmentation
+// Budgets are read every update(), the detailed statistics walk all blocks, so they are calculated once per updateInterval
+class MemoryStatistics
+{
+public:
+    class HeapStatistics
+    {
+    public:
+        VkDeviceSize    size = 0;
+        bool            deviceLocal = false;
+        // Memory used by the process(including other allocators) and available to it
+        VkDeviceSize    usage = 0;
+        VkDeviceSize    budget = 0;
+        // The largest usage since init(), to catch memory creep in long sessions
+        VkDeviceSize    peakUsage = 0;
+        uint32_t        allocationCount = 0;
+        VkDeviceSize    allocationBytes = 0;
+        uint32_t        blockCount = 0;
+        VkDeviceSize    blockBytes = 0;
+        // 0 - the free memory of the blocks is one range, close to 1 - it is split into many small ranges
+        float           fragmentation = 0.0f;
+    };
+
+    // Interval of the detailed statistics calculation in milliseconds
+    double updateInterval = 500.0;
+
+private:
+    VulkanDevice*                                       vulkanDevice = nullptr;
+    VmaAllocator                                        vmaAllocator = nullptr;
+    bool                                                budgetEnabled = false;
+    std::vector<HeapStatistics>                         heaps;
+    std::chrono::time_point<std::chrono::steady_clock>  lastDetailedUpdateTime;
+    bool                                                detailedUpdated = false;
+
+public:
+    // budgetEnabled - the allocator was created with VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT
+    void init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, bool budgetEnabled);
+    void update();
+
+    const std::vector<HeapStatistics>& getHeaps() const;
+    bool isBudgetEnabled() const;
+
+    // Writes the detailed JSON of vmaBuildStatsString(all blocks and allocations), returns false if the file can't be written
+    bool writeJson(const std::string& filePath) const;
+};
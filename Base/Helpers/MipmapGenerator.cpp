@@ -0,0 +1,439 @@
+#include "MipmapGenerator.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+void MipmapGenerator::init(VulkanDevice* vulkanDevice, const std::string& computeShaderPath)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->computeShaderPath = computeShaderPath;
+    computeShaderAvailable = !computeShaderPath.empty() && vulkanTools::fileExists(computeShaderPath);
+}
+
+void MipmapGenerator::destroy()
+{
+    if (pipeline) {
+        vkDestroyPipeline(vulkanDevice->logicalDevice, pipeline, getHostAllocationCallbacks());
+        pipeline = VK_NULL_HANDLE;
+    }
+    if (srgbPipeline) {
+        vkDestroyPipeline(vulkanDevice->logicalDevice, srgbPipeline, getHostAllocationCallbacks());
+        srgbPipeline = VK_NULL_HANDLE;
+    }
+    if (pipelineLayout) {
+        vkDestroyPipelineLayout(vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        pipelineLayout = VK_NULL_HANDLE;
+    }
+    if (descriptorSetLayout) {
+        vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayout, getHostAllocationCallbacks());
+        descriptorSetLayout = VK_NULL_HANDLE;
+    }
+    if (sampler) {
+        vkDestroySampler(vulkanDevice->logicalDevice, sampler, getHostAllocationCallbacks());
+        sampler = VK_NULL_HANDLE;
+    }
+}
+
+uint32_t MipmapGenerator::getMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t size = width > height ? width : height;
+    uint32_t mipLevelCount = 1;
+    while (size > 1) {
+        size /= 2;
+        mipLevelCount++;
+    }
+    return mipLevelCount;
+}
+
+MipmapGenerator::Method MipmapGenerator::getMethod(VkFormat format, VkQueueFlags queueFlags) const
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(vulkanDevice->physicalDevice, format, &formatProperties);
+    VkFormatFeatureFlags features = formatProperties.optimalTilingFeatures;
+
+    // vkCmdBlitImage is supported only by graphics queues
+    const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    bool canBlit = (queueFlags & VK_QUEUE_GRAPHICS_BIT) && (features & blitFeatures) == blitFeatures;
+    if (canBlit && vulkanTools::formatIsFilterable(vulkanDevice->physicalDevice, format, VK_IMAGE_TILING_OPTIMAL)) {
+        return Method::Blit;
+    }
+
+    // The shader reads the previous level with texelFetch(no filtering required) and writes rgba8 through the storage view
+    VkFormat storageFormat = getStorageFormat(format);
+    bool canCompute = computeShaderAvailable && (queueFlags & VK_QUEUE_COMPUTE_BIT) && storageFormat != VK_FORMAT_UNDEFINED;
+    if (canCompute) {
+        VkFormatProperties storageFormatProperties;
+        vkGetPhysicalDeviceFormatProperties(vulkanDevice->physicalDevice, storageFormat, &storageFormatProperties);
+        canCompute =
+            (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) &&
+            (storageFormatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+    }
+    if (canCompute) {
+        return Method::Compute;
+    }
+
+    // Nearest filter
+    if (canBlit) {
+        return Method::Blit;
+    }
+    return Method::None;
+}
+
+VkImageUsageFlags MipmapGenerator::getRequiredUsage(Method method)
+{
+    switch (method) {
+    case Method::Blit:
+        return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    case Method::Compute:
+        return VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    default:
+        return 0;
+    }
+}
+
+VkImageCreateFlags MipmapGenerator::getRequiredFlags(VkFormat format, Method method)
+{
+    // The image is created with the storage usage its format doesn't support, the views of the format must exclude it
+    if (method == Method::Compute && getStorageFormat(format) != format) {
+        return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    }
+    return 0;
+}
+
+VkFormat MipmapGenerator::getStorageFormat(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    default:
+        return VK_FORMAT_UNDEFINED;
+    }
+}
+
+void MipmapGenerator::record(
+    VkCommandBuffer commandBuffer,
+    Method method,
+    VkImage image,
+    VkFormat format,
+    uint32_t width,
+    uint32_t height,
+    const VkImageSubresourceRange& subresourceRange,
+    VkImageLayout finalLayout,
+    Resources& resources)
+{
+    if (method == Method::Blit) {
+        recordBlit(commandBuffer, image, format, width, height, subresourceRange, finalLayout);
+    }
+    else if (method == Method::Compute) {
+        recordCompute(commandBuffer, image, format, width, height, subresourceRange, finalLayout, resources);
+    }
+    else {
+        throw MakeErrorInfo("Mipmaps can't be generated for the image format!");
+    }
+}
+
+void MipmapGenerator::releaseResources(Resources& resources)
+{
+    for (VkImageView imageView : resources.imageViews) {
+        vkDestroyImageView(vulkanDevice->logicalDevice, imageView, getHostAllocationCallbacks());
+    }
+    resources.imageViews.clear();
+    // Descriptor sets are freed with the pool
+    if (resources.descriptorPool) {
+        vkDestroyDescriptorPool(vulkanDevice->logicalDevice, resources.descriptorPool, getHostAllocationCallbacks());
+        resources.descriptorPool = VK_NULL_HANDLE;
+    }
+}
+
+void MipmapGenerator::recordBlit(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout)
+{
+    VkFilter filter = vulkanTools::formatIsFilterable(vulkanDevice->physicalDevice, format, VK_IMAGE_TILING_OPTIMAL) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    VkImageSubresourceRange levelRange = subresourceRange;
+    levelRange.levelCount = 1;
+
+    // The copied level is the source of the first blit
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        levelRange
+    );
+
+    int32_t srcWidth = (int32_t)width;
+    int32_t srcHeight = (int32_t)height;
+    for (uint32_t i = 1; i < subresourceRange.levelCount; i++) {
+        int32_t dstWidth = srcWidth > 1 ? srcWidth / 2 : 1;
+        int32_t dstHeight = srcHeight > 1 ? srcHeight / 2 : 1;
+
+        VkImageBlit imageBlit{};
+        imageBlit.srcSubresource.aspectMask = subresourceRange.aspectMask;
+        imageBlit.srcSubresource.mipLevel = subresourceRange.baseMipLevel + i - 1;
+        imageBlit.srcSubresource.baseArrayLayer = subresourceRange.baseArrayLayer;
+        imageBlit.srcSubresource.layerCount = subresourceRange.layerCount;
+        imageBlit.srcOffsets[1] = { srcWidth, srcHeight, 1 };
+        imageBlit.dstSubresource.aspectMask = subresourceRange.aspectMask;
+        imageBlit.dstSubresource.mipLevel = subresourceRange.baseMipLevel + i;
+        imageBlit.dstSubresource.baseArrayLayer = subresourceRange.baseArrayLayer;
+        imageBlit.dstSubresource.layerCount = subresourceRange.layerCount;
+        imageBlit.dstOffsets[1] = { dstWidth, dstHeight, 1 };
+        vkCmdBlitImage(
+            commandBuffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &imageBlit,
+            filter
+        );
+
+        // The level is the source of the next blit
+        levelRange.baseMipLevel = subresourceRange.baseMipLevel + i;
+        vulkanTools::insertImageMemoryBarrier(
+            commandBuffer,
+            image,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            levelRange
+        );
+
+        srcWidth = dstWidth;
+        srcHeight = dstHeight;
+    }
+
+    // All levels are in the transfer source layout
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        finalLayout,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        subresourceRange
+    );
+}
+
+void MipmapGenerator::recordCompute(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, Resources& resources)
+{
+    VkFormat storageFormat = getStorageFormat(format);
+    bool encodeSrgb = storageFormat != format;
+    if (!descriptorSetLayout) {
+        createComputeLayouts();
+    }
+    VkPipeline& computePipeline = encodeSrgb ? srgbPipeline : pipeline;
+    if (!computePipeline) {
+        computePipeline = createComputePipeline(encodeSrgb);
+    }
+
+    // Views of every level, the shader reads and writes level 0 of the views
+    // Levels of sRGB images are read through the views of the format(decoded) and written through the UNORM views
+    std::vector<VkImageView> sampledViews(subresourceRange.levelCount);
+    std::vector<VkImageView> storageViews(subresourceRange.levelCount);
+    for (uint32_t i = 0; i < subresourceRange.levelCount; i++) {
+        VkImageViewUsageCreateInfo imageViewUsageCreateInfo{};
+        imageViewUsageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+        imageViewUsageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+        VkImageViewCreateInfo imageViewCreateInfo{};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.pNext = encodeSrgb ? &imageViewUsageCreateInfo : nullptr;
+        imageViewCreateInfo.image = image;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        imageViewCreateInfo.format = format;
+        imageViewCreateInfo.subresourceRange = subresourceRange;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = subresourceRange.baseMipLevel + i;
+        imageViewCreateInfo.subresourceRange.levelCount = 1;
+        VK_CHECK_RESULT(vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &sampledViews[i]));
+        resources.imageViews.push_back(sampledViews[i]);
+        storageViews[i] = sampledViews[i];
+        if (encodeSrgb) {
+            imageViewUsageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+            imageViewCreateInfo.format = storageFormat;
+            VK_CHECK_RESULT(vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &storageViews[i]));
+            resources.imageViews.push_back(storageViews[i]);
+        }
+    }
+
+    // One set per generated level
+    uint32_t setCount = subresourceRange.levelCount - 1;
+    std::vector<VkDescriptorPoolSize> poolSizes = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount }
+    };
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets = setCount;
+    descriptorPoolCreateInfo.poolSizeCount = (uint32_t)poolSizes.size();
+    descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+    VK_CHECK_RESULT(vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &resources.descriptorPool));
+
+    // The levels are read and written in the general layout
+    VkImageSubresourceRange levelRange = subresourceRange;
+    levelRange.levelCount = 1;
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        levelRange
+    );
+    VkImageSubresourceRange generatedRange = subresourceRange;
+    generatedRange.baseMipLevel = subresourceRange.baseMipLevel + 1;
+    generatedRange.levelCount = subresourceRange.levelCount - 1;
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        0,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        generatedRange
+    );
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+
+    uint32_t dstWidth = width;
+    uint32_t dstHeight = height;
+    for (uint32_t i = 1; i < subresourceRange.levelCount; i++) {
+        dstWidth = dstWidth > 1 ? dstWidth / 2 : 1;
+        dstHeight = dstHeight > 1 ? dstHeight / 2 : 1;
+
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.descriptorPool = resources.descriptorPool;
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VK_CHECK_RESULT(vkAllocateDescriptorSets(vulkanDevice->logicalDevice, &descriptorSetAllocateInfo, &descriptorSet));
+
+        VkDescriptorImageInfo srcImageInfo{ sampler, sampledViews[i - 1], VK_IMAGE_LAYOUT_GENERAL };
+        VkDescriptorImageInfo dstImageInfo{ VK_NULL_HANDLE, storageViews[i], VK_IMAGE_LAYOUT_GENERAL };
+        std::vector<VkWriteDescriptorSet> writeDescriptorSets(2);
+        writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSets[0].dstSet = descriptorSet;
+        writeDescriptorSets[0].dstBinding = 0;
+        writeDescriptorSets[0].descriptorCount = 1;
+        writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writeDescriptorSets[0].pImageInfo = &srcImageInfo;
+        writeDescriptorSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSets[1].dstSet = descriptorSet;
+        writeDescriptorSets[1].dstBinding = 1;
+        writeDescriptorSets[1].descriptorCount = 1;
+        writeDescriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writeDescriptorSets[1].pImageInfo = &dstImageInfo;
+        vkUpdateDescriptorSets(vulkanDevice->logicalDevice, (uint32_t)writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        // 8x8 workgroups, a layer per workgroup z
+        vkCmdDispatch(commandBuffer, (dstWidth + 7) / 8, (dstHeight + 7) / 8, subresourceRange.layerCount);
+
+        // The level is read by the next dispatch
+        levelRange.baseMipLevel = subresourceRange.baseMipLevel + i;
+        vulkanTools::insertImageMemoryBarrier(
+            commandBuffer,
+            image,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            levelRange
+        );
+    }
+
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        finalLayout,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        subresourceRange
+    );
+}
+
+void MipmapGenerator::createComputeLayouts()
+{
+    // The previous level is fetched without filtering
+    VkSamplerCreateInfo samplerCreateInfo{};
+    samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+    samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+    samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+    samplerCreateInfo.maxAnisotropy = 1.0f;
+    VK_CHECK_RESULT(vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, getHostAllocationCallbacks(), &sampler));
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = (uint32_t)bindings.size();
+    descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, getHostAllocationCallbacks(), &descriptorSetLayout));
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(vulkanDevice->logicalDevice, &pipelineLayoutCreateInfo, getHostAllocationCallbacks(), &pipelineLayout));
+}
+
+VkPipeline MipmapGenerator::createComputePipeline(bool encodeSrgb)
+{
+    // ENCODE_SRGB(constant_id 0) is a bool constant
+    VkBool32 encodeSrgbValue = encodeSrgb ? VK_TRUE : VK_FALSE;
+    VkSpecializationMapEntry specializationMapEntry{ 0, 0, sizeof(VkBool32) };
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &specializationMapEntry;
+    specializationInfo.dataSize = sizeof(VkBool32);
+    specializationInfo.pData = &encodeSrgbValue;
+
+    VkShaderModule shaderModule = vulkanTools::loadShader(vulkanDevice->logicalDevice, computeShaderPath);
+    VkComputePipelineCreateInfo computePipelineCreateInfo{};
+    computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    computePipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    computePipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    computePipelineCreateInfo.stage.module = shaderModule;
+    computePipelineCreateInfo.stage.pName = "main";
+    computePipelineCreateInfo.stage.pSpecializationInfo = &specializationInfo;
+    computePipelineCreateInfo.layout = pipelineLayout;
+    VkPipeline computePipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateComputePipelines(vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, getHostAllocationCallbacks(), &computePipeline);
+    // The module isn't needed after the pipeline creation
+    vkDestroyShaderModule(vulkanDevice->logicalDevice, shaderModule, getHostAllocationCallbacks());
+    if (result != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to create the mipmap compute pipeline!");
+    }
+    return computePipeline;
+}
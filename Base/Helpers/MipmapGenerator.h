@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+
+// Generates the mip levels of an image from its level 0 on the GPU
+// Every level is downsampled from the previous one with vkCmdBlitImage(linear filter) if the format supports it,
+// otherwise with a compute shader(2x2 box filter, the format must be R8G8B8A8_UNORM or R8G8B8A8_SRGB and the image must have
+// the storage usage). sRGB levels are written through a UNORM view(sRGB formats aren't storage formats), the shader averages
+// the decoded texels and encodes the result, such images must be created with getRequiredFlags()
+// The blit with nearest filter is the last resort for blittable formats without linear filtering
+class MipmapGenerator
+{
+public:
+    enum class Method
+    {
+        // The format can't be downsampled on the queue, the image should be created with one level
+        None,
+        Blit,
+        Compute
+    };
+
+    // Image views and descriptor sets of the compute path, must live until the recorded commands have been completed
+    class Resources
+    {
+    public:
+        std::vector<VkImageView>    imageViews;
+        VkDescriptorPool            descriptorPool = VK_NULL_HANDLE;
+    };
+
+private:
+    VulkanDevice*           vulkanDevice = nullptr;
+    // SPIR-V of data/shaders/Base/mipmapdownsample.comp, the compute path isn't used if the file doesn't exist
+    std::string             computeShaderPath;
+    bool                    computeShaderAvailable = false;
+    // Created on the first compute downsample
+    VkDescriptorSetLayout   descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout        pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline              pipeline = VK_NULL_HANDLE;
+    // ENCODE_SRGB specialization of the shader
+    VkPipeline              srgbPipeline = VK_NULL_HANDLE;
+    VkSampler               sampler = VK_NULL_HANDLE;
+
+public:
+    void init(VulkanDevice* vulkanDevice, const std::string& computeShaderPath = "");
+    void destroy();
+
+    // Number of levels of the full mip chain(down to 1x1)
+    static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+    // How the levels of an optimal tiling image of the format are generated on a queue with queueFlags
+    Method getMethod(VkFormat format, VkQueueFlags queueFlags) const;
+    // Image usage the method requires in addition to the transfer destination of the copy
+    static VkImageUsageFlags getRequiredUsage(Method method);
+    // Image create flags the method requires for the format(the UNORM storage view of an sRGB image)
+    static VkImageCreateFlags getRequiredFlags(VkFormat format, Method method);
+    // Format of the views the compute path writes the levels through, VK_FORMAT_UNDEFINED if it doesn't support the format
+    static VkFormat getStorageFormat(VkFormat format);
+
+    // Records the generation of levels [baseMipLevel + 1, baseMipLevel + levelCount) of subresourceRange layers
+    // All levels must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with level baseMipLevel written by transfer commands,
+    // at the end they are in finalLayout and visible to the fragment shader
+    // resources - filled by the compute path, released by releaseResources() after the commands have been completed
+    void record(
+        VkCommandBuffer commandBuffer,
+        Method method,
+        VkImage image,
+        VkFormat format,
+        uint32_t width,
+        uint32_t height,
+        const VkImageSubresourceRange& subresourceRange,
+        VkImageLayout finalLayout,
+        Resources& resources
+    );
+    void releaseResources(Resources& resources);
+
+private:
+    void recordBlit(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout);
+    void recordCompute(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, Resources& resources);
+    void createComputeLayouts();
+    VkPipeline createComputePipeline(bool encodeSrgb);
+};
@@ -0,0 +1,171 @@
+#include "PixelConversion.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_CONVERSION_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC compiles any intrinsics without architecture flags
+#define PIXEL_CONVERSION_TARGET_SSSE3
+#define PIXEL_CONVERSION_TARGET_AVX2
+#else
+#define PIXEL_CONVERSION_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define PIXEL_CONVERSION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define PIXEL_CONVERSION_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    pixelConversion::SimdLevel detectSimdLevel()
+    {
+#if defined(PIXEL_CONVERSION_X86)
+#if defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 0);
+        int maxLeaf = cpuInfo[0];
+        __cpuid(cpuInfo, 1);
+        bool ssse3 = (cpuInfo[2] & (1 << 9)) != 0;
+        bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+        bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx) {
+            // The OS saves the YMM registers
+            if ((_xgetbv(0) & 6) == 6) {
+                __cpuidex(cpuInfo, 7, 0);
+                avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+            }
+        }
+#else
+        // Also checks the OS support of the registers
+        bool ssse3 = __builtin_cpu_supports("ssse3");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (avx2) {
+            return pixelConversion::SimdLevel::AVX2;
+        }
+        if (ssse3) {
+            return pixelConversion::SimdLevel::SSSE3;
+        }
+        return pixelConversion::SimdLevel::Scalar;
+#elif defined(PIXEL_CONVERSION_NEON)
+        return pixelConversion::SimdLevel::NEON;
+#else
+        return pixelConversion::SimdLevel::Scalar;
+#endif
+    }
+
+#if defined(PIXEL_CONVERSION_X86)
+    // Returns the number of converted pixels, the rest is converted by the scalar code
+
+    PIXEL_CONVERSION_TARGET_SSSE3 size_t rgbToRgbaSSSE3(const uint8_t* src, uint8_t* dst, size_t pixelCount, uint8_t alpha)
+    {
+        // 4 RGB pixels(12 bytes) of a register -> 4 RGBA pixels, the alpha bytes are zeroed and or'ed
+        const __m128i shuffleMask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alphaMask = _mm_set1_epi32((int)((uint32_t)alpha << 24));
+        size_t i = 0;
+        // 16 pixels per iteration, 48 bytes in 3 registers
+        for (; i + 16 <= pixelCount; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 32));
+            __m128i pixels0 = a;
+            __m128i pixels1 = _mm_alignr_epi8(b, a, 12);
+            __m128i pixels2 = _mm_alignr_epi8(c, b, 8);
+            __m128i pixels3 = _mm_srli_si128(c, 4);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels0, shuffleMask), alphaMask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_or_si128(_mm_shuffle_epi8(pixels1, shuffleMask), alphaMask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 32), _mm_or_si128(_mm_shuffle_epi8(pixels2, shuffleMask), alphaMask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 48), _mm_or_si128(_mm_shuffle_epi8(pixels3, shuffleMask), alphaMask));
+        }
+        return i;
+    }
+
+    PIXEL_CONVERSION_TARGET_AVX2 size_t rgbToRgbaAVX2(const uint8_t* src, uint8_t* dst, size_t pixelCount, uint8_t alpha)
+    {
+        // The shuffle works within 128-bit lanes, so 12 bytes are moved to each lane first
+        const __m256i spreadIndices = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+        const __m256i shuffleMask = _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+        );
+        const __m256i alphaMask = _mm256_set1_epi32((int)((uint32_t)alpha << 24));
+        size_t i = 0;
+        // 8 pixels per iteration, the 32 bytes load reads 8 bytes past them
+        for (; i + 11 <= pixelCount; i += 8) {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 3));
+            pixels = _mm256_permutevar8x32_epi32(pixels, spreadIndices);
+            pixels = _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffleMask), alphaMask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), pixels);
+        }
+        return i;
+    }
+#endif
+
+#if defined(PIXEL_CONVERSION_NEON)
+    size_t rgbToRgbaNEON(const uint8_t* src, uint8_t* dst, size_t pixelCount, uint8_t alpha)
+    {
+        // Deinterleaving load and interleaving store
+        size_t i = 0;
+        for (; i + 16 <= pixelCount; i += 16) {
+            uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = rgb.val[2];
+            rgba.val[3] = vdupq_n_u8(alpha);
+            vst4q_u8(dst + i * 4, rgba);
+        }
+        return i;
+    }
+#endif
+}
+
+pixelConversion::SimdLevel pixelConversion::getSimdLevel()
+{
+    static const SimdLevel simdLevel = detectSimdLevel();
+    return simdLevel;
+}
+
+void pixelConversion::rgbToRgba(const uint8_t* src, uint8_t* dst, size_t pixelCount, uint8_t alpha)
+{
+    size_t i = 0;
+#if defined(PIXEL_CONVERSION_X86)
+    if (getSimdLevel() == SimdLevel::AVX2) {
+        i = rgbToRgbaAVX2(src, dst, pixelCount, alpha);
+    }
+    else if (getSimdLevel() == SimdLevel::SSSE3) {
+        i = rgbToRgbaSSSE3(src, dst, pixelCount, alpha);
+    }
+#elif defined(PIXEL_CONVERSION_NEON)
+    i = rgbToRgbaNEON(src, dst, pixelCount, alpha);
+#endif
+    for (; i < pixelCount; i++) {
+        dst[i * 4 + 0] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = alpha;
+    }
+}
+
+void pixelConversion::grayToRgba(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+{
+    for (size_t i = 0; i < pixelCount; i++) {
+        dst[i * 4 + 0] = src[i];
+        dst[i * 4 + 1] = src[i];
+        dst[i * 4 + 2] = src[i];
+        dst[i * 4 + 3] = 255;
+    }
+}
+
+void pixelConversion::grayAlphaToRgba(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+{
+    for (size_t i = 0; i < pixelCount; i++) {
+        dst[i * 4 + 0] = src[i * 2];
+        dst[i * 4 + 1] = src[i * 2];
+        dst[i * 4 + 2] = src[i * 2];
+        dst[i * 4 + 3] = src[i * 2 + 1];
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU pixel conversion kernels for 8-bit textures
+// The vector paths(SSSE3 and AVX2 chosen at runtime on x86, NEON on ARM) process the bulk of the pixels,
+// the remaining ones go through the scalar code
+namespace pixelConversion
+{
+    enum class SimdLevel
+    {
+        Scalar,
+        SSSE3,
+        AVX2,
+        NEON
+    };
+
+    // Detected once on the first call
+    SimdLevel getSimdLevel();
+
+    // RGB -> RGBA with a constant alpha, dst must not overlap src
+    void rgbToRgba(const uint8_t* src, uint8_t* dst, size_t pixelCount, uint8_t alpha = 255);
+    // Luminance -> RGBA(L, L, L, 255) and luminance alpha -> RGBA(L, L, L, A), dst must not overlap src
+    void grayToRgba(const uint8_t* src, uint8_t* dst, size_t pixelCount);
+    void grayAlphaToRgba(const uint8_t* src, uint8_t* dst, size_t pixelCount);
+}
@@ -0,0 +1,102 @@
+#include "SecondaryCommandRecorder.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+void SecondaryCommandRecorder::init(VulkanDevice* vulkanDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCount)
+{
+    this->vulkanDevice = vulkanDevice;
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // Command buffers are rerecorded every frame, the pool is reset as a whole
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+    framesPools.resize(framesInFlight);
+    for (auto& framePools : framesPools) {
+        framePools.resize(threadCount);
+        for (auto& threadCommandPool : framePools) {
+            VK_CHECK_RESULT(vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, getHostAllocationCallbacks(), &threadCommandPool.commandPool));
+        }
+    }
+}
+
+void SecondaryCommandRecorder::destroy()
+{
+    for (auto& framePools : framesPools) {
+        for (auto& threadCommandPool : framePools) {
+            // Command buffers are freed with the pool
+            vkDestroyCommandPool(vulkanDevice->logicalDevice, threadCommandPool.commandPool, getHostAllocationCallbacks());
+        }
+    }
+    framesPools.clear();
+}
+
+void SecondaryCommandRecorder::beginFrame(uint32_t frameIndex)
+{
+    currentFrameIndex = frameIndex;
+    for (auto& threadCommandPool : framesPools[currentFrameIndex]) {
+        if (threadCommandPool.usedCommandBuffers != 0) {
+            VK_CHECK_RESULT(vkResetCommandPool(vulkanDevice->logicalDevice, threadCommandPool.commandPool, 0));
+            threadCommandPool.usedCommandBuffers = 0;
+        }
+    }
+}
+
+const std::vector<VkCommandBuffer>& SecondaryCommandRecorder::record(JobSystem& jobSystem, uint32_t taskCount, const VkCommandBufferInheritanceInfo& inheritanceInfo, RecordFunction recordFunction)
+{
+    recordedCommandBuffers.assign(taskCount, VK_NULL_HANDLE);
+
+    // The calling thread records too while it waits, it uses its own command pool
+    JobSystem::TaskGroup taskGroup;
+    for (uint32_t taskIndex = 0; taskIndex < taskCount; taskIndex++) {
+        jobSystem.run(taskGroup, [&, taskIndex](uint32_t threadIndex) {
+            recordedCommandBuffers[taskIndex] = recordCommandBuffer(threadIndex, taskIndex, inheritanceInfo, recordFunction);
+        });
+    }
+    // Rethrows the first exception of the tasks
+    jobSystem.wait(taskGroup);
+    return recordedCommandBuffers;
+}
+
+const std::vector<VkCommandBuffer>& SecondaryCommandRecorder::recordOnCallingThread(JobSystem& jobSystem, const VkCommandBufferInheritanceInfo& inheritanceInfo, RecordFunction recordFunction)
+{
+    // The tasks of record() have been waited, the pool of the calling thread is free
+    uint32_t taskIndex = (uint32_t)recordedCommandBuffers.size();
+    recordedCommandBuffers.push_back(recordCommandBuffer(jobSystem.getCurrentThreadIndex(), taskIndex, inheritanceInfo, recordFunction));
+    return recordedCommandBuffers;
+}
+
+VkCommandBuffer SecondaryCommandRecorder::recordCommandBuffer(uint32_t threadIndex, uint32_t taskIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, const RecordFunction& recordFunction)
+{
+    VkCommandBuffer commandBuffer = getCommandBuffer(threadIndex);
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo{};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to begin recording secondary command buffer!");
+    }
+    recordFunction(commandBuffer, taskIndex);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to record secondary command buffer!");
+    }
+    return commandBuffer;
+}
+
+VkCommandBuffer SecondaryCommandRecorder::getCommandBuffer(uint32_t threadIndex)
+{
+    // Only this thread uses the pool during recording
+    ThreadCommandPool& threadCommandPool = framesPools[currentFrameIndex][threadIndex];
+    if (threadCommandPool.usedCommandBuffers == threadCommandPool.commandBuffers.size()) {
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.commandPool = threadCommandPool.commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(vulkanDevice->logicalDevice, &commandBufferAllocateInfo, &commandBuffer));
+        threadCommandPool.commandBuffers.push_back(commandBuffer);
+    }
+    return threadCommandPool.commandBuffers[threadCommandPool.usedCommandBuffers++];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+#include "JobSystem.h"
+
+// Records secondary command buffers of a render pass on the threads of a JobSystem
+// Command pools must be externally synchronized, so each thread has its own command pool per frame in flight
+// The pools of a frame are reset at once in beginFrame() instead of resetting every command buffer
+class SecondaryCommandRecorder
+{
+public:
+    // recordFunction(commandBuffer, taskIndex) records commands into a secondary command buffer
+    // that has already been begun and will be ended after the call
+    using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t taskIndex)>;
+
+private:
+    class ThreadCommandPool
+    {
+    public:
+        VkCommandPool                   commandPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer>    commandBuffers;
+        // Command buffers used in the current frame
+        uint32_t                        usedCommandBuffers = 0;
+    };
+
+    VulkanDevice*                               vulkanDevice = nullptr;
+    // [frameIndex][threadIndex]
+    std::vector<std::vector<ThreadCommandPool>> framesPools;
+    uint32_t                                    currentFrameIndex = 0;
+    // Recorded command buffers in task order
+    std::vector<VkCommandBuffer>                recordedCommandBuffers;
+
+public:
+    // threadCount - JobSystem::getThreadCount()
+    void init(VulkanDevice* vulkanDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCount);
+    void destroy();
+
+    // Resets the command pools of the frame, must be called after the frame fence has been waited
+    void beginFrame(uint32_t frameIndex);
+
+    // Records taskCount secondary command buffers in parallel and waits for them
+    // inheritanceInfo - render pass, subpass and framebuffer the command buffers will be executed in
+    // Returns the command buffers in task order, to be passed to vkCmdExecuteCommands()
+    const std::vector<VkCommandBuffer>& record(JobSystem& jobSystem, uint32_t taskCount, const VkCommandBufferInheritanceInfo& inheritanceInfo, RecordFunction recordFunction);
+    // Records one secondary command buffer on the calling thread(e.g. the UI, whose state isn't thread safe)
+    // and appends it to the command buffers returned by record(), taskIndex of the call is their count
+    const std::vector<VkCommandBuffer>& recordOnCallingThread(JobSystem& jobSystem, const VkCommandBufferInheritanceInfo& inheritanceInfo, RecordFunction recordFunction);
+
+private:
+    VkCommandBuffer getCommandBuffer(uint32_t threadIndex);
+    // Begins the command buffer of the thread, calls recordFunction and ends it
+    VkCommandBuffer recordCommandBuffer(uint32_t threadIndex, uint32_t taskIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, const RecordFunction& recordFunction);
+};
@@ -0,0 +1,412 @@
+#include "TextureStreamer.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "../ErrorInfo/ErrorInfo.h"
+
+StreamingTexture::~StreamingTexture()
+{
+    texture.destroy();
+    pendingTexture.destroy();
+    if (fileTexture) {
+        ktxTexture_Destroy(fileTexture);
+    }
+    if (tailTexture) {
+        ktxTexture_Destroy(tailTexture);
+    }
+}
+
+VulkanTexture2D* StreamingTexture::get()
+{
+    return residentLevel != UINT32_MAX ? &texture : nullptr;
+}
+
+bool StreamingTexture::isFailed() const
+{
+    return fileState.load() == FileState::Failed;
+}
+
+const std::string& StreamingTexture::getError() const
+{
+    return error;
+}
+
+uint32_t StreamingTexture::getWidth() const
+{
+    return width;
+}
+
+uint32_t StreamingTexture::getHeight() const
+{
+    return height;
+}
+
+uint32_t StreamingTexture::getLevelCount() const
+{
+    return levelCount;
+}
+
+uint32_t StreamingTexture::getResidentLevel() const
+{
+    return residentLevel;
+}
+
+VkDeviceSize StreamingTexture::getResidentSize() const
+{
+    return residentLevel != UINT32_MAX ? texture.vmaImageAllocationInfo.size : 0;
+}
+
+void TextureStreamer::init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager* uploadManager, JobSystem* jobSystem, DeferredReleaseQueue* deferredReleases, VmaPool vmaPool)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->uploadManager = uploadManager;
+    this->jobSystem = jobSystem;
+    this->deferredReleases = deferredReleases;
+    this->vmaPool = vmaPool;
+    stopping = false;
+}
+
+void TextureStreamer::destroy()
+{
+    if (!jobSystem) {
+        return;
+    }
+    // A file being read can't be interrupted, the queued ones are skipped
+    stopping = true;
+    jobSystem->wait(loadTaskGroup);
+    textures.clear();
+    jobSystem = nullptr;
+}
+
+std::shared_ptr<StreamingTexture> TextureStreamer::load(std::string filePath, VkFilter filter, StreamingTexture::ChangedCallback changedCallback)
+{
+    if (!jobSystem) {
+        throw MakeErrorInfo("TextureStreamer: not initialized!");
+    }
+    std::shared_ptr<StreamingTexture> texture = std::make_shared<StreamingTexture>();
+    texture->filePath = filePath;
+    texture->filter = filter;
+    texture->changedCallback = std::move(changedCallback);
+    texture->texture.setDeviceAndAllocator(vulkanDevice, vmaAllocator);
+    textures.push_back(texture);
+    startLoading(texture);
+    return texture;
+}
+
+void TextureStreamer::requestLevel(StreamingTexture& texture, uint32_t level)
+{
+    if (level < texture.requestedLevel) {
+        texture.requestedLevel = level;
+    }
+}
+
+void TextureStreamer::requestScreenSize(StreamingTexture& texture, float screenSize)
+{
+    // The size isn't known before the first load, the tail is loaded anyway
+    if (texture.levelCount == 0) {
+        return;
+    }
+    requestLevel(texture, getRequiredLevel(texture.width, texture.height, screenSize));
+}
+
+void TextureStreamer::update(uint64_t frameValue)
+{
+    frameNumber++;
+    replaceCompletedImages(frameValue);
+
+    for (std::shared_ptr<StreamingTexture>& texturePtr : textures) {
+        StreamingTexture& texture = *texturePtr;
+        if (texture.levelCount == 0 && texture.fileState == StreamingTexture::FileState::Loaded) {
+            initializeLevels(texture);
+        }
+        if (texture.requestedLevel != UINT32_MAX) {
+            texture.lastRequestFrame = frameNumber;
+            // A lower level is taken at once, a higher one only when the wanted level is no longer requested
+            if (texture.requestedLevel <= texture.wantedLevel || frameNumber - texture.wantedLevelFrame > evictionDelay) {
+                texture.wantedLevel = texture.requestedLevel;
+                texture.wantedLevelFrame = frameNumber;
+            }
+        }
+        else if (frameNumber - texture.lastRequestFrame > evictionDelay) {
+            texture.wantedLevel = UINT32_MAX;
+        }
+        texture.requestedLevel = UINT32_MAX;
+    }
+
+    std::vector<uint32_t> plannedLevels;
+    planLevels(plannedLevels);
+
+    VkDeviceSize uploadBytes = 0;
+    for (size_t i = 0; i < textures.size(); i++) {
+        StreamingTexture& texture = *textures[i];
+        uint32_t plannedLevel = plannedLevels[i];
+        // The file is being read, or the texture waits for the upload of its new image
+        if (plannedLevel == UINT32_MAX || texture.fileState == StreamingTexture::FileState::Loading || texture.pendingLevel != UINT32_MAX) {
+            continue;
+        }
+        if (plannedLevel == texture.residentLevel) {
+            // Only the tail is resident, the host copy of the file isn't needed for evictions
+            if (plannedLevel >= texture.tailLevel && texture.fileTexture) {
+                ktxTexture_Destroy(texture.fileTexture);
+                texture.fileTexture = nullptr;
+                texture.fileState = StreamingTexture::FileState::None;
+            }
+            continue;
+        }
+        if (plannedLevel < texture.tailLevel && !texture.fileTexture) {
+            // Evictions don't wait for the file, the texture drops to the tail
+            if (plannedLevel > texture.residentLevel) {
+                plannedLevel = texture.tailLevel;
+            }
+            else {
+                if (texture.fileState != StreamingTexture::FileState::Failed) {
+                    startLoading(textures[i]);
+                }
+                continue;
+            }
+        }
+        VkDeviceSize imageSize = getLevelsSize(texture, plannedLevel);
+        if (uploadBytes > 0 && uploadBytes + imageSize > maxUploadBytesPerUpdate) {
+            continue;
+        }
+        if (startResidencyChange(texture, plannedLevel)) {
+            uploadBytes += imageSize;
+        }
+    }
+}
+
+VkDeviceSize TextureStreamer::getResidentSize() const
+{
+    VkDeviceSize residentSize = 0;
+    for (const std::shared_ptr<StreamingTexture>& texture : textures) {
+        residentSize += texture->getResidentSize();
+    }
+    return residentSize;
+}
+
+uint32_t TextureStreamer::getTextureCount() const
+{
+    return static_cast<uint32_t>(textures.size());
+}
+
+uint32_t TextureStreamer::getRequiredLevel(uint32_t width, uint32_t height, float screenSize)
+{
+    if (screenSize <= 0.0f) {
+        return UINT32_MAX;
+    }
+    float ratio = static_cast<float>(width > height ? width : height) / screenSize;
+    if (ratio <= 1.0f) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::floor(std::log2(ratio)));
+}
+
+float TextureStreamer::getProjectedSize(float radius, float distance, float fovY, float viewportHeight)
+{
+    // Behind the camera
+    if (distance + radius <= 0.0f) {
+        return 0.0f;
+    }
+    // The camera is inside the sphere
+    if (distance <= radius) {
+        return FLT_MAX;
+    }
+    return radius * viewportHeight / (distance * std::tan(fovY * 0.5f));
+}
+
+void TextureStreamer::startLoading(std::shared_ptr<StreamingTexture> texture)
+{
+    texture->fileState = StreamingTexture::FileState::Loading;
+    // The job holds a reference, the texture outlives the loading even if the caller releases the handle
+    jobSystem->runBackground(loadTaskGroup, [this, texture](uint32_t) {
+        if (stopping) {
+            texture->fileState = StreamingTexture::FileState::None;
+            return;
+        }
+        try {
+            loadFile(*texture);
+            texture->fileState = StreamingTexture::FileState::Loaded;
+        }
+        catch (const ErrorInfo& errorInfo) {
+            texture->error = errorInfo.what;
+            texture->fileState = StreamingTexture::FileState::Failed;
+        }
+        catch (const std::exception& exception) {
+            texture->error = exception.what();
+            texture->fileState = StreamingTexture::FileState::Failed;
+        }
+    });
+}
+
+void TextureStreamer::loadFile(StreamingTexture& texture)
+{
+    ktxTexture* fileTexture = VulkanTexture2D::loadKTXFile(texture.filePath, vulkanDevice);
+    if (texture.tailTexture) {
+        texture.fileTexture = fileTexture;
+        return;
+    }
+
+    // The first level not bigger than tailSize, cube maps and 3D textures are one tail
+    uint32_t tailLevel = 0;
+    if (fileTexture->numFaces == 1 && fileTexture->numDimensions < 3) {
+        while (tailLevel + 1 < fileTexture->numLevels && ((fileTexture->baseWidth >> tailLevel) > tailSize || (fileTexture->baseHeight >> tailLevel) > tailSize)) {
+            tailLevel++;
+        }
+    }
+    if (tailLevel == 0) {
+        texture.tailTexture = fileTexture;
+        return;
+    }
+
+    ktxTextureCreateInfo createInfo{};
+    createInfo.vkFormat = ktxTexture_GetVkFormat(fileTexture);
+    createInfo.baseWidth = fileTexture->baseWidth >> tailLevel;
+    createInfo.baseHeight = fileTexture->baseHeight >> tailLevel;
+    createInfo.baseWidth = createInfo.baseWidth > 0 ? createInfo.baseWidth : 1;
+    createInfo.baseHeight = createInfo.baseHeight > 0 ? createInfo.baseHeight : 1;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = fileTexture->numLevels - tailLevel;
+    createInfo.numLayers = fileTexture->numLayers;
+    createInfo.numFaces = 1;
+    createInfo.isArray = fileTexture->isArray;
+    createInfo.generateMipmaps = KTX_FALSE;
+    ktxTexture2* tailTexture = nullptr;
+    if (ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &tailTexture) != KTX_SUCCESS) {
+        ktxTexture_Destroy(fileTexture);
+        throw MakeErrorInfo("ktx: failed to create the mip tail texture!");
+    }
+    ktx_uint8_t* fileTextureData = ktxTexture_GetData(fileTexture);
+    for (uint32_t level = tailLevel; level < fileTexture->numLevels; level++) {
+        for (uint32_t layer = 0; layer < fileTexture->numLayers; layer++) {
+            ktx_size_t offset;
+            ktxTexture_GetImageOffset(fileTexture, level, layer, 0, &offset);
+            KTX_error_code result = ktxTexture_SetImageFromMemory(ktxTexture(tailTexture), level - tailLevel, layer, 0, fileTextureData + offset, ktxTexture_GetImageSize(fileTexture, level));
+            if (result != KTX_SUCCESS) {
+                ktxTexture_Destroy(ktxTexture(tailTexture));
+                ktxTexture_Destroy(fileTexture);
+                throw MakeErrorInfo("ktx: failed to copy the mip tail of the texture!");
+            }
+        }
+    }
+    texture.tailTexture = ktxTexture(tailTexture);
+    // Kept for the first upload, the wanted level may be above the tail already
+    texture.fileTexture = fileTexture;
+}
+
+void TextureStreamer::initializeLevels(StreamingTexture& texture)
+{
+    ktxTexture* source = texture.fileTexture ? texture.fileTexture : texture.tailTexture;
+    texture.width = source->baseWidth;
+    texture.height = source->baseHeight;
+    texture.levelCount = source->numLevels;
+    texture.tailLevel = source->numLevels - texture.tailTexture->numLevels;
+    texture.levelSizes.resize(texture.levelCount);
+    for (uint32_t level = 0; level < texture.levelCount; level++) {
+        texture.levelSizes[level] = ktxTexture_GetImageSize(source, level) * source->numLayers * source->numFaces;
+    }
+}
+
+void TextureStreamer::replaceCompletedImages(uint64_t frameValue)
+{
+    std::vector<StreamingTexture*> completedTextures;
+    for (std::shared_ptr<StreamingTexture>& texture : textures) {
+        if (texture->pendingLevel != UINT32_MAX && uploadManager->isCompleted(texture->pendingUploadValue)) {
+            completedTextures.push_back(texture.get());
+        }
+    }
+
+    // Descriptor sets that reference the old images may still be used by the frames in flight,
+    // the images are destroyed after the frame being prepared has been completed
+    for (StreamingTexture* texture : completedTextures) {
+        VulkanTexture2D oldTexture = texture->texture;
+        deferredReleases->push(frameValue, [oldTexture]() mutable { oldTexture.destroy(); });
+        texture->texture = texture->pendingTexture;
+        texture->pendingTexture = VulkanTexture2D(vulkanDevice, vmaAllocator);
+        texture->residentLevel = texture->pendingLevel;
+        texture->pendingLevel = UINT32_MAX;
+        if (texture->changedCallback) {
+            texture->changedCallback();
+        }
+    }
+
+    // Released by their users(the streamer holds the last reference) and not used by jobs or uploads
+    // The frames in flight may still use them
+    auto isReleased = [](const std::shared_ptr<StreamingTexture>& texture) {
+        return texture.use_count() == 1 && texture->fileState != StreamingTexture::FileState::Loading && texture->pendingLevel == UINT32_MAX;
+    };
+    auto releasedBegin = std::stable_partition(textures.begin(), textures.end(), [&isReleased](const std::shared_ptr<StreamingTexture>& texture) {
+        return !isReleased(texture);
+    });
+    for (auto it = releasedBegin; it != textures.end(); ++it) {
+        deferredReleases->push(frameValue, [releasedTexture = std::move(*it)]() mutable { releasedTexture.reset(); });
+    }
+    textures.erase(releasedBegin, textures.end());
+}
+
+void TextureStreamer::planLevels(std::vector<uint32_t>& plannedLevels)
+{
+    plannedLevels.assign(textures.size(), UINT32_MAX);
+    std::vector<size_t> plannedTextures;
+    VkDeviceSize plannedSize = 0;
+    for (size_t i = 0; i < textures.size(); i++) {
+        const StreamingTexture& texture = *textures[i];
+        if (texture.levelCount == 0) {
+            continue;
+        }
+        plannedLevels[i] = texture.wantedLevel < texture.tailLevel ? texture.wantedLevel : texture.tailLevel;
+        plannedSize += getLevelsSize(texture, plannedLevels[i]);
+        plannedTextures.push_back(i);
+    }
+    if (plannedSize <= memoryBudget) {
+        return;
+    }
+
+    // The least recently requested textures lose their levels first
+    std::stable_sort(plannedTextures.begin(), plannedTextures.end(), [this](size_t a, size_t b) {
+        return textures[a]->lastRequestFrame < textures[b]->lastRequestFrame;
+    });
+    for (size_t i : plannedTextures) {
+        const StreamingTexture& texture = *textures[i];
+        while (plannedSize > memoryBudget && plannedLevels[i] < texture.tailLevel) {
+            plannedSize -= texture.levelSizes[plannedLevels[i]];
+            plannedLevels[i]++;
+        }
+        if (plannedSize <= memoryBudget) {
+            break;
+        }
+    }
+}
+
+bool TextureStreamer::startResidencyChange(StreamingTexture& texture, uint32_t level)
+{
+    ktxTexture* source = nullptr;
+    uint32_t baseLevel = 0;
+    if (level >= texture.tailLevel) {
+        source = texture.tailTexture;
+        baseLevel = level - texture.tailLevel;
+    }
+    else if (texture.fileTexture) {
+        source = texture.fileTexture;
+        baseLevel = level;
+    }
+    else {
+        return false;
+    }
+    texture.pendingTexture.setDeviceAndAllocator(vulkanDevice, vmaAllocator);
+    texture.pendingTexture.createTextureFromKTX(*uploadManager, source, texture.filter, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, vmaPool, baseLevel);
+    // The new image replaces the old one at the first update() after the batch has been completed
+    texture.pendingLevel = level;
+    texture.pendingUploadValue = uploadManager->getRecordingValue();
+    return true;
+}
+
+VkDeviceSize TextureStreamer::getLevelsSize(const StreamingTexture& texture, uint32_t level)
+{
+    VkDeviceSize size = 0;
+    for (uint32_t i = level; i < texture.levelCount; i++) {
+        size += texture.levelSizes[i];
+    }
+    return size;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+#include "VulkanTexture.h"
+#include "UploadManager.h"
+#include "JobSystem.h"
+#include "DeferredReleaseQueue.h"
+#include "vk_mem_alloc.h"
+
+// KTX texture with streamed mip levels, the handle is returned by TextureStreamer::load()
+// Only the levels from getResidentLevel() of the file are in the device memory, they are levels 0.. of the image
+class StreamingTexture
+{
+public:
+    // Called on the main thread when the handles of the texture have changed(the first image is ready,
+    // levels were streamed in or evicted), e.g. to rewrite descriptor sets
+    using ChangedCallback = std::function<void()>;
+
+private:
+    friend class TextureStreamer;
+
+    enum class FileState { None, Loading, Loaded, Failed };
+
+    std::string             filePath;
+    VkFilter                filter = VK_FILTER_LINEAR;
+    ChangedCallback         changedCallback;
+    // Size and levels of the file, set on the main thread after the first load
+    uint32_t                width = 0;
+    uint32_t                height = 0;
+    uint32_t                levelCount = 0;
+    // Bytes of each level of the file(all layers)
+    std::vector<VkDeviceSize> levelSizes;
+    // The smallest levels(not bigger than TextureStreamer::tailSize) are always resident and kept in the host memory
+    uint32_t                tailLevel = 0;
+    ktxTexture*             tailTexture = nullptr;
+    // The whole file, loaded by a background job when higher levels are needed
+    // Kept while levels above the tail are resident, they can be evicted without reading the file again
+    std::atomic<FileState>  fileState = FileState::None;
+    ktxTexture*             fileTexture = nullptr;
+    std::string             error;
+
+    VulkanTexture2D         texture;
+    // UINT32_MAX - no image yet
+    uint32_t                residentLevel = UINT32_MAX;
+    // Image with the new levels being uploaded, replaces texture after the upload has been completed
+    VulkanTexture2D         pendingTexture;
+    uint32_t                pendingLevel = UINT32_MAX;
+    uint64_t                pendingUploadValue = 0;
+
+    // The smallest level requested since the last TextureStreamer::update()
+    uint32_t                requestedLevel = UINT32_MAX;
+    // Level the texture should have, a higher requested level replaces it only after it hasn't been requested
+    // for TextureStreamer::evictionDelay frames
+    uint32_t                wantedLevel = UINT32_MAX;
+    uint64_t                wantedLevelFrame = 0;
+    uint64_t                lastRequestFrame = 0;
+
+public:
+    ~StreamingTexture();
+
+    // nullptr until the first levels are resident
+    VulkanTexture2D* get();
+    bool isFailed() const;
+    const std::string& getError() const;
+
+    // Size and level count of the file(0 until it has been loaded)
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+    uint32_t getLevelCount() const;
+    // The first level of the file in the image, UINT32_MAX - no image yet
+    uint32_t getResidentLevel() const;
+    // Device memory of the resident levels
+    VkDeviceSize getResidentSize() const;
+};
+
+// Streams the mip levels of KTX textures by the detail they are needed with, under a device memory budget
+// - a texture is created with the levels of its mip tail only(the file is read once to get them)
+// - the required level is requested every frame(requestLevel(), e.g. by the screen size of the materials using it),
+//   higher levels are read from the file by a job system background job and uploaded through the upload manager
+// - if the resident levels of all textures exceed memoryBudget, the least recently requested textures lose their
+//   highest levels first(down to the tail)
+// Without sparse residency the level count of an image can't change, so a new image is created for the new levels,
+// the levels are uploaded from the host copy of the file and the image replaces the old one when the upload has
+// been completed. The frames in flight may still use the old image, so it is released through the deferred release
+// queue with the frame value of update() and destroyed only after that frame has been completed(textures released by
+// their users too), the host never waits for the queue. The changed callback is called at once, a sample with a descriptor
+// set per frame rewrites each set when its frame slot comes around
+// Streamed textures must not be registered for defragmentation, their handles are replaced by the streamer
+class TextureStreamer
+{
+public:
+    // Device memory the resident levels of all textures may use(estimated by the level sizes in the files)
+    VkDeviceSize    memoryBudget = 256 * 1024 * 1024;
+    // Levels not bigger than it(in pixels, the larger side) are the mip tail, always resident
+    uint32_t        tailSize = 128;
+    // Frames the requested level is kept after the last request, so a texture isn't evicted as soon as it is out of view
+    uint64_t        evictionDelay = 120;
+    // Limits the new images created per update(), the upload of at least one image is started
+    VkDeviceSize    maxUploadBytesPerUpdate = 32 * 1024 * 1024;
+
+private:
+    VulkanDevice*                                   vulkanDevice = nullptr;
+    VmaAllocator                                    vmaAllocator = nullptr;
+    UploadManager*                                  uploadManager = nullptr;
+    JobSystem*                                      jobSystem = nullptr;
+    // Old images and released textures are destroyed by it after the frames that may use them have been completed
+    DeferredReleaseQueue*                           deferredReleases = nullptr;
+    VmaPool                                         vmaPool = nullptr;
+
+    JobSystem::TaskGroup                            loadTaskGroup;
+    // Workers skip the file loading after destroy() has been called
+    std::atomic<bool>                               stopping = false;
+    std::vector<std::shared_ptr<StreamingTexture>>  textures;
+    uint64_t                                        frameNumber = 0;
+
+public:
+    // deferredReleases - collected by the frame values passed to update()(see BaseSample::base_deferredReleases)
+    // vmaPool - pool the images are allocated from(see MemoryPools), nullptr - default pools
+    void init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, UploadManager* uploadManager, JobSystem* jobSystem, DeferredReleaseQueue* deferredReleases, VmaPool vmaPool = nullptr);
+    // Waits for the loading jobs and destroys the textures, the GPU must not use them
+    // The released images may still be in the deferred release queue, it must be flushed after
+    void destroy();
+
+    // Starts loading the mip tail of a KTX(KTX1 or KTX2) file, changedCallback is called every time the handles change
+    // Cube maps and 3D textures are not streamed(always fully resident)
+    std::shared_ptr<StreamingTexture> load(
+        std::string filePath,
+        VkFilter filter = VK_FILTER_LINEAR,
+        StreamingTexture::ChangedCallback changedCallback = nullptr
+    );
+
+    // The texture is needed from the level(of the file) until the next update()
+    void requestLevel(StreamingTexture& texture, uint32_t level);
+    // requestLevel() of getRequiredLevel() for the texture covering screenSize pixels
+    void requestScreenSize(StreamingTexture& texture, float screenSize);
+
+    // Called at the frame boundary before the upload manager flush, frameValue - value of the frame being prepared
+    // (BaseSample::getFrameTimelineValue()), the replaced images and released textures are destroyed after it has been completed
+    // Replaces the images with completed uploads, plans the levels of the textures in the budget,
+    // starts the file loads and the uploads of the new images
+    void update(uint64_t frameValue);
+
+    // Device memory of the resident levels of all textures
+    VkDeviceSize getResidentSize() const;
+    uint32_t getTextureCount() const;
+
+    // Level of a width x height texture whose texels match the screen pixels if the texture covers screenSize pixels
+    // (along the larger side), the GPU doesn't sample the levels below it. UINT32_MAX if screenSize is 0(not visible)
+    static uint32_t getRequiredLevel(uint32_t width, uint32_t height, float screenSize);
+    // Projected diameter in pixels of a sphere at the distance from the camera(perspective projection, fovY in radians)
+    static float getProjectedSize(float radius, float distance, float fovY, float viewportHeight);
+
+private:
+    void startLoading(std::shared_ptr<StreamingTexture> texture);
+    // Reads the file and copies the mip tail to tailTexture on the first load, called by a background job
+    void loadFile(StreamingTexture& texture);
+    // Sets the size and levels of the texture from the loaded file
+    void initializeLevels(StreamingTexture& texture);
+    void replaceCompletedImages(uint64_t frameValue);
+    // Level of each texture in the budget
+    void planLevels(std::vector<uint32_t>& plannedLevels);
+    // Creates the image with levels [level, levelCount) of the file and records its upload, false if the data isn't loaded
+    bool startResidencyChange(StreamingTexture& texture, uint32_t level);
+    static VkDeviceSize getLevelsSize(const StreamingTexture& texture, uint32_t level);
+};
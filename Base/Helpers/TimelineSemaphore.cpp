@@ -0,0 +1,100 @@
+#include "TimelineSemaphore.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+bool TimelineSemaphore::isSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion, bool& extensionRequired)
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bool coreSupported = instanceApiVersion >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2;
+    extensionRequired = !coreSupported;
+    if (extensionRequired) {
+        VulkanDevice device(physicalDevice);
+        if (!device.checkExtensionsSupport({ VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME })) {
+            return false;
+        }
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &timelineSemaphoreFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    return timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+}
+
+void TimelineSemaphore::create(VulkanDevice* vulkanDevice, uint64_t initialValue)
+{
+    this->vulkanDevice = vulkanDevice;
+    completedValue = initialValue;
+
+    getSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(vulkanDevice->logicalDevice, "vkGetSemaphoreCounterValue");
+    waitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(vulkanDevice->logicalDevice, "vkWaitSemaphores");
+    if (!getSemaphoreCounterValue || !waitSemaphores) {
+        getSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(vulkanDevice->logicalDevice, "vkGetSemaphoreCounterValueKHR");
+        waitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(vulkanDevice->logicalDevice, "vkWaitSemaphoresKHR");
+    }
+    if (!getSemaphoreCounterValue || !waitSemaphores) {
+        throw MakeErrorInfo("Failed to get timeline semaphore functions!");
+    }
+
+    VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+    semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeCreateInfo.initialValue = initialValue;
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo{};
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+    if (vkCreateSemaphore(vulkanDevice->logicalDevice, &semaphoreCreateInfo, getHostAllocationCallbacks(), &semaphore) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to create timeline semaphore!");
+    }
+}
+
+void TimelineSemaphore::destroy()
+{
+    if (semaphore) {
+        vkDestroySemaphore(vulkanDevice->logicalDevice, semaphore, getHostAllocationCallbacks());
+        semaphore = VK_NULL_HANDLE;
+    }
+}
+
+uint64_t TimelineSemaphore::getCompletedValue()
+{
+    uint64_t value = 0;
+    if (getSemaphoreCounterValue(vulkanDevice->logicalDevice, semaphore, &value) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to get timeline semaphore value!");
+    }
+    completedValue = value;
+    return completedValue;
+}
+
+bool TimelineSemaphore::isCompleted(uint64_t value)
+{
+    // Avoid the call if the cached value already answers
+    if (completedValue >= value) {
+        return true;
+    }
+    return getCompletedValue() >= value;
+}
+
+bool TimelineSemaphore::wait(uint64_t value, uint64_t timeout)
+{
+    if (isCompleted(value)) {
+        return true;
+    }
+    VkSemaphoreWaitInfo semaphoreWaitInfo{};
+    semaphoreWaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    semaphoreWaitInfo.semaphoreCount = 1;
+    semaphoreWaitInfo.pSemaphores = &semaphore;
+    semaphoreWaitInfo.pValues = &value;
+    VkResult result = waitSemaphores(vulkanDevice->logicalDevice, &semaphoreWaitInfo, timeout);
+    if (result == VK_TIMEOUT) {
+        return false;
+    }
+    if (result != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to wait for timeline semaphore!");
+    }
+    completedValue = value;
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+
+// Timeline semaphore(Vulkan 1.2 or VK_KHR_timeline_semaphore)
+// A single semaphore with a 64-bit counter: each submission signals a bigger value,
+// the completion of any submission is checked by comparing the counter with its value
+class TimelineSemaphore
+{
+public:
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+
+private:
+    VulkanDevice*                   vulkanDevice = nullptr;
+    // Core functions on Vulkan 1.2, KHR functions with the extension
+    PFN_vkGetSemaphoreCounterValue  getSemaphoreCounterValue = nullptr;
+    PFN_vkWaitSemaphores            waitSemaphores = nullptr;
+    // Cached counter value, the counter never decreases
+    uint64_t                        completedValue = 0;
+
+public:
+    // Returns true if the device supports timeline semaphores
+    // extensionRequired is set to true if VK_KHR_timeline_semaphore must be enabled(API version lower than 1.2)
+    static bool isSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion, bool& extensionRequired);
+
+    // The timelineSemaphore feature must be enabled on the logical device
+    void create(VulkanDevice* vulkanDevice, uint64_t initialValue = 0);
+    void destroy();
+
+    // Non-blocking
+    uint64_t getCompletedValue();
+    bool isCompleted(uint64_t value);
+
+    // Blocks until the counter reaches the value, returns false on timeout
+    bool wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+};
@@ -2,6 +2,10 @@
 
 #include <../imgui/imgui.h>
 #include <chrono>
+#include "GpuProfiler.h"
+#include "MemoryStatistics.h"
+#include "MemoryPools.h"
+#include "HostAllocationTracker.h"
 
 namespace UIOverlay
 {
@@ -41,4 +45,131 @@ namespace UIOverlay
 
         ImGui::Text("%i FPS (%.3f ms)", FPS, tmpFrameTime);
     }
+
+    // Displays the GPU profiler scopes statistics in milliseconds
+    inline void printGpuProfilerStatistics(const GpuProfiler& gpuProfiler)
+    {
+        if (!gpuProfiler.isSupported()) {
+            ImGui::Text("GPU timestamps are not supported");
+            return;
+        }
+        if (ImGui::BeginTable("GPU profiler", 4, ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("GPU scope");
+            ImGui::TableSetupColumn("min");
+            ImGui::TableSetupColumn("avg");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableHeadersRow();
+            for (const auto& [name, statistics] : gpuProfiler.getStatistics()) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.min);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.avg);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", statistics.p99);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    // Displays the memory heaps usage(MB), budget(MB), allocation and block counts and fragmentation
+    inline void printMemoryStatistics(const MemoryStatistics& memoryStatistics)
+    {
+        const float MB = 1024.0f * 1024.0f;
+        if (!memoryStatistics.isBudgetEnabled()) {
+            ImGui::Text("VK_EXT_memory_budget is not supported, budgets are estimated");
+        }
+        if (ImGui::BeginTable("Memory heaps", 7, ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Heap");
+            ImGui::TableSetupColumn("usage");
+            ImGui::TableSetupColumn("peak");
+            ImGui::TableSetupColumn("budget");
+            ImGui::TableSetupColumn("allocs");
+            ImGui::TableSetupColumn("blocks");
+            ImGui::TableSetupColumn("frag");
+            ImGui::TableHeadersRow();
+            const std::vector<MemoryStatistics::HeapStatistics>& heaps = memoryStatistics.getHeaps();
+            for (size_t i = 0; i < heaps.size(); i++) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu%s", i, heaps[i].deviceLocal ? " (device)" : "");
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", heaps[i].usage / MB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", heaps[i].peakUsage / MB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", heaps[i].budget / MB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", heaps[i].allocationCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", heaps[i].blockCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f%%", heaps[i].fragmentation * 100.0f);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    // Per-category accounting of the memory pools
+    inline void printMemoryPools(const MemoryPools& memoryPools)
+    {
+        const float MB = 1024.0f * 1024.0f;
+        if (ImGui::BeginTable("Memory pools", 4, ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Pool");
+            ImGui::TableSetupColumn("allocated");
+            ImGui::TableSetupColumn("blocks");
+            ImGui::TableSetupColumn("allocs");
+            ImGui::TableHeadersRow();
+            for (size_t i = 0; i < (size_t)MemoryPools::Category::Count; i++) {
+                MemoryPools::Category category = (MemoryPools::Category)i;
+                VmaStatistics statistics = memoryPools.getStatistics(category);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", MemoryPools::getName(category));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", statistics.allocationBytes / MB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", statistics.blockBytes / MB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", statistics.allocationCount);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    // Host memory allocated by the Vulkan implementation through the allocation callbacks
+    inline void printHostAllocations(const HostAllocationTracker& hostAllocationTracker)
+    {
+        const float KB = 1024.0f;
+        ImGui::Text("Host allocations%s", hostAllocationTracker.isPooled() ? " (pooled)" : "");
+        if (ImGui::BeginTable("Host allocations", 6, ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Scope");
+            ImGui::TableSetupColumn("KB");
+            ImGui::TableSetupColumn("peak");
+            ImGui::TableSetupColumn("allocs");
+            ImGui::TableSetupColumn("total");
+            ImGui::TableSetupColumn("internal");
+            ImGui::TableHeadersRow();
+            for (uint32_t i = 0; i < HostAllocationTracker::scopeCount; i++) {
+                VkSystemAllocationScope scope = (VkSystemAllocationScope)i;
+                HostAllocationTracker::ScopeStatistics statistics = hostAllocationTracker.getStatistics(scope);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", HostAllocationTracker::getScopeName(scope));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", statistics.bytes / KB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", statistics.peakBytes / KB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%lld", (long long)statistics.allocationCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)statistics.totalAllocationCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", statistics.internalBytes / KB);
+            }
+            ImGui::EndTable();
+        }
+    }
 }
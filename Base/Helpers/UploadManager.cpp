@@ -0,0 +1,558 @@
+#include "UploadManager.h"
+#include "../ErrorInfo/ErrorInfo.h"
+
+void UploadManager::init(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, VkQueue queue, uint32_t queueFamilyIndex, VkQueue dstQueue, uint32_t dstQueueFamilyIndex, VkDeviceSize ringSize, VmaPool stagingPool, const std::string& mipmapShaderPath)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->queue = queue;
+    this->queueFamilyIndex = queueFamilyIndex;
+    this->dstQueue = dstQueue;
+    this->dstQueueFamilyIndex = dstQueueFamilyIndex;
+    this->ringSize = ringSize;
+    ownershipTransfer = dstQueue && dstQueueFamilyIndex != queueFamilyIndex;
+    mipmapGenerator.init(vulkanDevice, mipmapShaderPath);
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // Batch command buffers are reused one by one
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+    VK_CHECK_RESULT(vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, getHostAllocationCallbacks(), &commandPool));
+    if (ownershipTransfer) {
+        // Acquire barriers are recorded for the destination queue family
+        commandPoolCreateInfo.queueFamilyIndex = dstQueueFamilyIndex;
+        VK_CHECK_RESULT(vkCreateCommandPool(vulkanDevice->logicalDevice, &commandPoolCreateInfo, getHostAllocationCallbacks(), &dstCommandPool));
+    }
+
+    // The ring stays mapped for the whole lifetime
+    ringBuffer.setDeviceAndAllocator(vulkanDevice, vmaAllocator);
+    ringBuffer.createBuffer(
+        ringSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        nullptr,
+        0,
+        VMA_MEMORY_USAGE_AUTO,
+        stagingPool
+    );
+    ringData = static_cast<uint8_t*>(ringBuffer.vmaAllocationInfo.pMappedData);
+
+    ringHead = 0;
+    ringTail = 0;
+    completedValue = 0;
+    recordingBatch = Batch();
+    recordingBatch.value = 1;
+}
+
+void UploadManager::destroy()
+{
+    if (!commandPool) {
+        return;
+    }
+    waitIdle();
+    while (!acquireSubmissions.empty()) {
+        VK_CHECK_RESULT(vkWaitForFences(vulkanDevice->logicalDevice, 1, &acquireSubmissions.front().fence, VK_TRUE, UINT64_MAX));
+        reclaimCompletedBatches();
+    }
+    for (auto& fence : freeFences) {
+        vkDestroyFence(vulkanDevice->logicalDevice, fence, getHostAllocationCallbacks());
+    }
+    freeFences.clear();
+    for (auto& semaphore : freeSemaphores) {
+        vkDestroySemaphore(vulkanDevice->logicalDevice, semaphore, getHostAllocationCallbacks());
+    }
+    freeSemaphores.clear();
+    // Command buffers are freed with the pool
+    freeCommandBuffers.clear();
+    freeAcquireCommandBuffers.clear();
+    vkDestroyCommandPool(vulkanDevice->logicalDevice, commandPool, getHostAllocationCallbacks());
+    commandPool = VK_NULL_HANDLE;
+    if (dstCommandPool) {
+        vkDestroyCommandPool(vulkanDevice->logicalDevice, dstCommandPool, getHostAllocationCallbacks());
+        dstCommandPool = VK_NULL_HANDLE;
+    }
+    mipmapGenerator.destroy();
+    ringBuffer.destroy();
+    ringData = nullptr;
+}
+
+bool UploadManager::isOwnershipTransferred() const
+{
+    return ownershipTransfer;
+}
+
+MipmapGenerator::Method UploadManager::getMipmapMethod(VkFormat format) const
+{
+    // With the ownership transfer the levels are generated on the destination queue
+    uint32_t generationQueueFamilyIndex = ownershipTransfer ? dstQueueFamilyIndex : queueFamilyIndex;
+    return mipmapGenerator.getMethod(format, vulkanDevice->queueFamilyProperties[generationQueueFamilyIndex].queueFlags);
+}
+
+UploadManager::StagingAllocation UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+{
+    // A multiple of both, the requested alignment may not be a power of two(e.g. 12 for 3 byte texels)
+    VkDeviceSize requestedAlignment = alignment;
+    while (alignment % vulkanDevice->properties.limits.optimalBufferCopyOffsetAlignment != 0) {
+        alignment += requestedAlignment;
+    }
+    beginRecording();
+
+    StagingAllocation staging;
+    staging.size = size;
+
+    // Doesn't fit into the ring at all, a temporary buffer is destroyed when the batch is completed
+    // It is allocated from the default pools, it may not fit into the blocks of the staging pool
+    if (size > ringSize) {
+        recordingBatch.dedicatedStagingBuffers.emplace_back(vulkanDevice, vmaAllocator);
+        VulkanBuffer& stagingBuffer = recordingBatch.dedicatedStagingBuffers.back();
+        stagingBuffer.createBuffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+        staging.data = stagingBuffer.vmaAllocationInfo.pMappedData;
+        staging.buffer = stagingBuffer.buffer;
+        staging.offset = 0;
+        return staging;
+    }
+
+    reclaimCompletedBatches();
+    while (true) {
+        // The offset in the ring is aligned, the ring size isn't a multiple of every alignment
+        uint64_t offset = ringHead % ringSize;
+        uint64_t position = ringHead + (offset + alignment - 1) / alignment * alignment - offset;
+        // An allocation can't wrap around the end of the ring, start from the beginning
+        if (position % ringSize + size > ringSize) {
+            position = (position / ringSize + 1) * ringSize;
+        }
+        if (position + size - ringTail <= ringSize) {
+            ringHead = position + size;
+            staging.data = ringData + position % ringSize;
+            staging.buffer = ringBuffer.buffer;
+            staging.offset = position % ringSize;
+            return staging;
+        }
+        // The ring is full
+        if (submittedBatches.empty()) {
+            // All space is used by the recording batch
+            flush();
+            beginRecording();
+        }
+        waitOldestBatch();
+    }
+}
+
+void UploadManager::copyToBuffer(const StagingAllocation& staging, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = staging.offset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = staging.size;
+    vkCmdCopyBuffer(recordingBatch.commandBuffer, staging.buffer, dstBuffer, 1, &copyRegion);
+
+    if (!ownershipTransfer) {
+        // A single memory barrier for all buffers at the end of the batch
+        recordingBatch.hasBufferCopies = true;
+        return;
+    }
+
+    // Release the copied range to the destination queue family, the matching acquire is submitted after the batch is completed
+    VkBufferMemoryBarrier bufferMemoryBarrier{};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    // Ignored by the release
+    bufferMemoryBarrier.dstAccessMask = 0;
+    bufferMemoryBarrier.srcQueueFamilyIndex = queueFamilyIndex;
+    bufferMemoryBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    bufferMemoryBarrier.buffer = dstBuffer;
+    bufferMemoryBarrier.offset = dstOffset;
+    bufferMemoryBarrier.size = staging.size;
+    vkCmdPipelineBarrier(
+        recordingBatch.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0, nullptr,
+        1, &bufferMemoryBarrier,
+        0, nullptr
+    );
+
+    // Ignored by the acquire
+    bufferMemoryBarrier.srcAccessMask = 0;
+    // Buffers can be used by any stage(vertex input, uniforms, storage)
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    recordingBatch.bufferAcquireBarriers.push_back(bufferMemoryBarrier);
+}
+
+void UploadManager::copyToImage(const StagingAllocation& staging, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, const MipmapGeneration* mipmapGeneration)
+{
+    VkCommandBuffer commandBuffer = recordingBatch.commandBuffer;
+
+    // Transition the texture image layout to transfer target, so we can safely copy our buffer data to it
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        0, // srcAccessMask - We do not perform any operations before memory barrier
+        VK_ACCESS_TRANSFER_WRITE_BIT, // dstAccessMask - We write after memory barrier
+        VK_IMAGE_LAYOUT_UNDEFINED, // oldImageLayout
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // newImageLayout
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // srcStageMask - We don't wait anything before the barrier
+        VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask - Stages in which we make transfer operations should wait a barrier
+        subresourceRange
+    );
+
+    // Regions offsets are relative to the staging memory
+    std::vector<VkBufferImageCopy> bufferCopyRegions = regions;
+    for (auto& bufferCopyRegion : bufferCopyRegions) {
+        bufferCopyRegion.bufferOffset += staging.offset;
+    }
+    vkCmdCopyBufferToImage(
+        commandBuffer,
+        staging.buffer,
+        image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        (uint32_t)bufferCopyRegions.size(),
+        bufferCopyRegions.data()
+    );
+
+    bool generateMipmaps = mipmapGeneration && mipmapGeneration->method != MipmapGenerator::Method::None && subresourceRange.levelCount > 1;
+
+    if (ownershipTransfer) {
+        // Release the image to the destination queue family with the transition to finalLayout,
+        // the matching acquire(with the same transition) is submitted after the batch is completed
+        // The levels to generate stay in the transfer layout, they are generated on the destination queue after the acquire
+        VkImageLayout releaseLayout = generateMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : finalLayout;
+        VkImageMemoryBarrier imageMemoryBarrier{};
+        imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        // Ignored by the release
+        imageMemoryBarrier.dstAccessMask = 0;
+        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarrier.newLayout = releaseLayout;
+        imageMemoryBarrier.srcQueueFamilyIndex = queueFamilyIndex;
+        imageMemoryBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+        imageMemoryBarrier.image = image;
+        imageMemoryBarrier.subresourceRange = subresourceRange;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &imageMemoryBarrier
+        );
+
+        // Ignored by the acquire
+        imageMemoryBarrier.srcAccessMask = 0;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        if (generateMipmaps) {
+            imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            PendingMipmapGeneration pendingMipmapGeneration;
+            pendingMipmapGeneration.image = image;
+            pendingMipmapGeneration.mipmapGeneration = *mipmapGeneration;
+            pendingMipmapGeneration.subresourceRange = subresourceRange;
+            pendingMipmapGeneration.finalLayout = finalLayout;
+            recordingBatch.pendingMipmapGenerations.push_back(pendingMipmapGeneration);
+        }
+        recordingBatch.imageAcquireBarriers.push_back(imageMemoryBarrier);
+        return;
+    }
+
+    if (generateMipmaps) {
+        // Right after the copy, the generator transitions the image to finalLayout
+        MipmapGenerator::Resources resources;
+        mipmapGenerator.record(
+            commandBuffer,
+            mipmapGeneration->method,
+            image,
+            mipmapGeneration->format,
+            mipmapGeneration->width,
+            mipmapGeneration->height,
+            subresourceRange,
+            finalLayout,
+            resources
+        );
+        recordingBatch.mipmapResources.push_back(resources);
+        return;
+    }
+
+    // Change image layout to finalLayout after transfer
+    vulkanTools::insertImageMemoryBarrier(
+        commandBuffer,
+        image,
+        VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask - We write the data to the image
+        VK_ACCESS_SHADER_READ_BIT, // dstAccessMask - The shader reads data from the image
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
+        finalLayout, // newImageLayout
+        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask - We have to wait for the transfer operation that loads the image
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, // dstStageMask - The shader should read the data only after it is loaded to image
+        subresourceRange
+    );
+}
+
+void UploadManager::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+{
+    StagingAllocation staging = allocateStaging(size);
+    memcpy(staging.data, data, size);
+    copyToBuffer(staging, dstBuffer, dstOffset);
+}
+
+void UploadManager::uploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, VkImageLayout finalLayout, const MipmapGeneration* mipmapGeneration)
+{
+    StagingAllocation staging = allocateStaging(size);
+    memcpy(staging.data, data, size);
+    copyToImage(staging, image, regions, subresourceRange, finalLayout, mipmapGeneration);
+}
+
+uint64_t UploadManager::flush()
+{
+    reclaimCompletedBatches();
+    if (!recordingBatch.commandBuffer) {
+        return recordingBatch.value - 1;
+    }
+
+    if (recordingBatch.hasBufferCopies) {
+        // Buffers can be used by any stage(vertex input, uniforms, storage), images have their own barriers
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(
+            recordingBatch.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &memoryBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+    if (vkEndCommandBuffer(recordingBatch.commandBuffer) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to record upload command buffer!");
+    }
+
+    recordingBatch.fence = getFence();
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &recordingBatch.commandBuffer;
+    if (ownershipTransfer) {
+        // Waited by the acquire submission on the destination queue
+        if (!freeSemaphores.empty()) {
+            recordingBatch.semaphore = freeSemaphores.back();
+            freeSemaphores.pop_back();
+        }
+        else {
+            VkSemaphoreCreateInfo semaphoreCreateInfo{};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            VK_CHECK_RESULT(vkCreateSemaphore(vulkanDevice->logicalDevice, &semaphoreCreateInfo, getHostAllocationCallbacks(), &recordingBatch.semaphore));
+        }
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &recordingBatch.semaphore;
+    }
+    if (vkQueueSubmit(queue, 1, &submitInfo, recordingBatch.fence) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to submit upload command buffer!");
+    }
+
+    uint64_t value = recordingBatch.value;
+    recordingBatch.ringEnd = ringHead;
+    submittedBatches.push_back(std::move(recordingBatch));
+    recordingBatch = Batch();
+    recordingBatch.value = value + 1;
+    return value;
+}
+
+uint64_t UploadManager::getRecordingValue() const
+{
+    return recordingBatch.value;
+}
+
+bool UploadManager::isCompleted(uint64_t value)
+{
+    if (value > completedValue) {
+        reclaimCompletedBatches();
+    }
+    return value <= completedValue;
+}
+
+void UploadManager::wait(uint64_t value)
+{
+    if (value >= recordingBatch.value) {
+        flush();
+    }
+    while (completedValue < value && !submittedBatches.empty()) {
+        waitOldestBatch();
+    }
+}
+
+void UploadManager::waitIdle()
+{
+    wait(flush());
+}
+
+void UploadManager::beginRecording()
+{
+    if (recordingBatch.commandBuffer) {
+        return;
+    }
+    if (!freeCommandBuffers.empty()) {
+        recordingBatch.commandBuffer = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+    }
+    else {
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.commandPool = commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(vulkanDevice->logicalDevice, &commandBufferAllocateInfo, &recordingBatch.commandBuffer));
+    }
+
+    // Implicitly resets the command buffer
+    VkCommandBufferBeginInfo commandBufferBeginInfo{};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(recordingBatch.commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to begin recording upload command buffer!");
+    }
+}
+
+void UploadManager::reclaimCompletedBatches()
+{
+    // Batches are reclaimed in submission order, so the ring tail only moves forward
+    while (!submittedBatches.empty()) {
+        Batch& batch = submittedBatches.front();
+        if (vkGetFenceStatus(vulkanDevice->logicalDevice, batch.fence) != VK_SUCCESS) {
+            break;
+        }
+        VK_CHECK_RESULT(vkResetFences(vulkanDevice->logicalDevice, 1, &batch.fence));
+        freeFences.push_back(batch.fence);
+        freeCommandBuffers.push_back(batch.commandBuffer);
+        for (auto& stagingBuffer : batch.dedicatedStagingBuffers) {
+            stagingBuffer.destroy();
+        }
+        for (auto& resources : batch.mipmapResources) {
+            mipmapGenerator.releaseResources(resources);
+        }
+        if (ownershipTransfer) {
+            submitAcquireBarriers(batch);
+        }
+        ringTail = batch.ringEnd;
+        completedValue = batch.value;
+        submittedBatches.pop_front();
+    }
+
+    // The semaphore can be reused after the acquire submission waiting for it has been completed
+    while (!acquireSubmissions.empty()) {
+        AcquireSubmission& acquireSubmission = acquireSubmissions.front();
+        if (vkGetFenceStatus(vulkanDevice->logicalDevice, acquireSubmission.fence) != VK_SUCCESS) {
+            break;
+        }
+        VK_CHECK_RESULT(vkResetFences(vulkanDevice->logicalDevice, 1, &acquireSubmission.fence));
+        freeFences.push_back(acquireSubmission.fence);
+        freeAcquireCommandBuffers.push_back(acquireSubmission.commandBuffer);
+        freeSemaphores.push_back(acquireSubmission.semaphore);
+        for (auto& resources : acquireSubmission.mipmapResources) {
+            mipmapGenerator.releaseResources(resources);
+        }
+        acquireSubmissions.pop_front();
+    }
+}
+
+void UploadManager::submitAcquireBarriers(Batch& batch)
+{
+    AcquireSubmission acquireSubmission;
+    if (!freeAcquireCommandBuffers.empty()) {
+        acquireSubmission.commandBuffer = freeAcquireCommandBuffers.back();
+        freeAcquireCommandBuffers.pop_back();
+    }
+    else {
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.commandPool = dstCommandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(vulkanDevice->logicalDevice, &commandBufferAllocateInfo, &acquireSubmission.commandBuffer));
+    }
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo{};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(acquireSubmission.commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to begin recording acquire command buffer!");
+    }
+    if (!batch.bufferAcquireBarriers.empty() || !batch.imageAcquireBarriers.empty()) {
+        // The first scope is chained to the semaphore wait
+        vkCmdPipelineBarrier(
+            acquireSubmission.commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0, nullptr,
+            (uint32_t)batch.bufferAcquireBarriers.size(), batch.bufferAcquireBarriers.data(),
+            (uint32_t)batch.imageAcquireBarriers.size(), batch.imageAcquireBarriers.data()
+        );
+    }
+    // The acquired levels are generated before the resources can be used
+    for (auto& pendingMipmapGeneration : batch.pendingMipmapGenerations) {
+        const MipmapGeneration& mipmapGeneration = pendingMipmapGeneration.mipmapGeneration;
+        MipmapGenerator::Resources resources;
+        mipmapGenerator.record(
+            acquireSubmission.commandBuffer,
+            mipmapGeneration.method,
+            pendingMipmapGeneration.image,
+            mipmapGeneration.format,
+            mipmapGeneration.width,
+            mipmapGeneration.height,
+            pendingMipmapGeneration.subresourceRange,
+            pendingMipmapGeneration.finalLayout,
+            resources
+        );
+        acquireSubmission.mipmapResources.push_back(resources);
+    }
+    if (vkEndCommandBuffer(acquireSubmission.commandBuffer) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to record acquire command buffer!");
+    }
+
+    // The batch has been completed, so the semaphore is already signaled and the destination queue doesn't wait
+    acquireSubmission.semaphore = batch.semaphore;
+    acquireSubmission.fence = getFence();
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &acquireSubmission.semaphore;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &acquireSubmission.commandBuffer;
+    if (vkQueueSubmit(dstQueue, 1, &submitInfo, acquireSubmission.fence) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to submit acquire command buffer!");
+    }
+    acquireSubmissions.push_back(acquireSubmission);
+}
+
+VkFence UploadManager::getFence()
+{
+    VkFence fence = VK_NULL_HANDLE;
+    if (!freeFences.empty()) {
+        fence = freeFences.back();
+        freeFences.pop_back();
+    }
+    else {
+        VkFenceCreateInfo fenceCreateInfo{};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VK_CHECK_RESULT(vkCreateFence(vulkanDevice->logicalDevice, &fenceCreateInfo, getHostAllocationCallbacks(), &fence));
+    }
+    return fence;
+}
+
+void UploadManager::waitOldestBatch()
+{
+    VK_CHECK_RESULT(vkWaitForFences(vulkanDevice->logicalDevice, 1, &submittedBatches.front().fence, VK_TRUE, UINT64_MAX));
+    reclaimCompletedBatches();
+}
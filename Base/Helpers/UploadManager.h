@@ -0,0 +1,202 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "MipmapGenerator.h"
+#include "vk_mem_alloc.h"
+
+// Uploads data to device local buffers and images through a persistently mapped staging ring buffer
+// Copies are recorded into one command buffer(batch) and submitted together by flush()
+// Each submitted batch gets an increasing value and a fence, the ring space of a batch is reused after its fence is signaled
+// If the copies are submitted to a queue of another family than the queue that uses the resources(e.g. a dedicated transfer queue),
+// the batch releases the ownership of the resources and signals a semaphore. The acquire barriers are submitted to the destination
+// queue(waiting for the semaphore) only after the batch has been completed, so the destination queue never waits for the copies
+// Mip levels of images can be generated from the copied level 0 by MipmapGenerator, in the same command buffer as the copy
+// (or in the acquire command buffer of the destination queue, a transfer queue can't blit or dispatch)
+// Not thread safe
+class UploadManager
+{
+public:
+    // Staging memory in the ring, valid until the batch it is used in has been completed
+    class StagingAllocation
+    {
+    public:
+        void*           data = nullptr;
+        VkBuffer        buffer = VK_NULL_HANDLE;
+        VkDeviceSize    offset = 0;
+        VkDeviceSize    size = 0;
+    };
+
+    // Generation of the mip levels from the copied level 0(see copyToImage())
+    class MipmapGeneration
+    {
+    public:
+        // getMipmapMethod() of the format
+        MipmapGenerator::Method method = MipmapGenerator::Method::None;
+        VkFormat                format = VK_FORMAT_UNDEFINED;
+        // Size of level 0
+        uint32_t                width = 0;
+        uint32_t                height = 0;
+    };
+
+private:
+    // Recorded on the destination queue after the acquire barriers
+    class PendingMipmapGeneration
+    {
+    public:
+        VkImage                 image = VK_NULL_HANDLE;
+        MipmapGeneration        mipmapGeneration;
+        VkImageSubresourceRange subresourceRange{};
+        VkImageLayout           finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    class Batch
+    {
+    public:
+        uint64_t                    value = 0;
+        VkCommandBuffer             commandBuffer = VK_NULL_HANDLE;
+        VkFence                     fence = VK_NULL_HANDLE;
+        // Ring position after the last allocation of the batch
+        uint64_t                    ringEnd = 0;
+        // Staging buffers for data bigger than the ring
+        std::vector<VulkanBuffer>   dedicatedStagingBuffers;
+        bool                        hasBufferCopies = false;
+        // Released after the batch has been completed
+        std::vector<MipmapGenerator::Resources> mipmapResources;
+        // Ownership transfer to the destination queue family
+        VkSemaphore                         semaphore = VK_NULL_HANDLE;
+        std::vector<VkBufferMemoryBarrier>  bufferAcquireBarriers;
+        std::vector<VkImageMemoryBarrier>   imageAcquireBarriers;
+        std::vector<PendingMipmapGeneration> pendingMipmapGenerations;
+    };
+
+    // Acquire barriers of a completed batch submitted to the destination queue
+    class AcquireSubmission
+    {
+    public:
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence         fence = VK_NULL_HANDLE;
+        VkSemaphore     semaphore = VK_NULL_HANDLE;
+        std::vector<MipmapGenerator::Resources> mipmapResources;
+    };
+
+    VulkanDevice*       vulkanDevice = nullptr;
+    VmaAllocator        vmaAllocator = nullptr;
+    VkQueue             queue = VK_NULL_HANDLE;
+    uint32_t            queueFamilyIndex = 0;
+    VkCommandPool       commandPool = VK_NULL_HANDLE;
+    // Queue the uploaded resources are used on, ownership is transferred to it if it has another family
+    VkQueue             dstQueue = VK_NULL_HANDLE;
+    uint32_t            dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    VkCommandPool       dstCommandPool = VK_NULL_HANDLE;
+    bool                ownershipTransfer = false;
+    MipmapGenerator     mipmapGenerator;
+
+    VulkanBuffer        ringBuffer;
+    uint8_t*            ringData = nullptr;
+    VkDeviceSize        ringSize = 0;
+    // Absolute positions, the offset in the ring is position % ringSize
+    // [ringTail, ringHead) is used by the recording and submitted batches
+    uint64_t            ringHead = 0;
+    uint64_t            ringTail = 0;
+
+    // The batch being recorded, its command buffer is begun on the first copy
+    Batch               recordingBatch;
+    // Submitted batches in submission order
+    std::deque<Batch>   submittedBatches;
+    // Completed batch command buffers and fences for reuse
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+    std::vector<VkFence>         freeFences;
+    std::vector<VkSemaphore>     freeSemaphores;
+    std::vector<VkCommandBuffer> freeAcquireCommandBuffers;
+    std::deque<AcquireSubmission> acquireSubmissions;
+    // The last batch whose resources can be used by the commands submitted to the destination queue from now on
+    uint64_t            completedValue = 0;
+
+public:
+    // queue - queue the copies are submitted to, queueFamilyIndex - its family
+    // dstQueue - queue the resources are used on, dstQueueFamilyIndex - its family(VK_NULL_HANDLE - the same queue)
+    // ringSize - size of the staging ring buffer
+    // stagingPool - custom pool the ring is allocated from(see MemoryPools), its blocks must fit the ring
+    // mipmapShaderPath - SPIR-V of the compute downsample(see MipmapGenerator), optional
+    void init(
+        VulkanDevice* vulkanDevice,
+        VmaAllocator vmaAllocator,
+        VkQueue queue,
+        uint32_t queueFamilyIndex,
+        VkQueue dstQueue = VK_NULL_HANDLE,
+        uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        VkDeviceSize ringSize = 64 * 1024 * 1024,
+        VmaPool stagingPool = nullptr,
+        const std::string& mipmapShaderPath = ""
+    );
+    // Waits for all submitted batches
+    void destroy();
+
+    // True if the ownership of the uploaded resources is transferred to another queue family
+    bool isOwnershipTransferred() const;
+
+    // How the mip levels of an image of the format are generated by copyToImage()
+    // The image must be created with MipmapGenerator::getRequiredUsage() and getRequiredFlags() of the method, None - only level 0 can be uploaded
+    MipmapGenerator::Method getMipmapMethod(VkFormat format) const;
+
+    // Allocates staging memory to be written by the caller and passed to copyToBuffer()/copyToImage()
+    // May submit the recording batch and wait for the submitted ones if the ring is full
+    // alignment - of the offset in the staging buffer, at least optimalBufferCopyOffsetAlignment is used
+    StagingAllocation allocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+    // Records a copy of the staging memory to the buffer
+    void copyToBuffer(const StagingAllocation& staging, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+    // Records the transition of subresourceRange to the transfer layout, the copy of the regions and the transition to finalLayout
+    // The previous content of the image is discarded, regions bufferOffset are relative to the staging memory
+    // mipmapGeneration - the regions contain only level baseMipLevel, the other levels of subresourceRange are generated from it
+    void copyToImage(
+        const StagingAllocation& staging,
+        VkImage image,
+        const std::vector<VkBufferImageCopy>& regions,
+        const VkImageSubresourceRange& subresourceRange,
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        const MipmapGeneration* mipmapGeneration = nullptr
+    );
+
+    // allocateStaging() + memcpy + copyToBuffer()/copyToImage()
+    void uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+    void uploadImage(
+        VkImage image,
+        const void* data,
+        VkDeviceSize size,
+        const std::vector<VkBufferImageCopy>& regions,
+        const VkImageSubresourceRange& subresourceRange,
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        const MipmapGeneration* mipmapGeneration = nullptr
+    );
+
+    // Submits the recorded copies, returns the value of the batch(the last submitted value if nothing was recorded)
+    // Also submits the acquire barriers of the completed batches
+    // Without ownership transfer the copies are visible to the commands submitted to the same queue after it,
+    // otherwise the resources can be used only after isCompleted() returns true for the batch
+    uint64_t flush();
+
+    // Value the currently recorded copies will be submitted with
+    uint64_t getRecordingValue() const;
+    // True if the resources of the batch can be used by the commands submitted to the destination queue from now on
+    // Non-blocking, also reclaims the ring space of completed batches
+    bool isCompleted(uint64_t value);
+    // Blocks until the batch with the value has been completed(and its acquire barriers submitted)
+    void wait(uint64_t value);
+    // Submits the recorded copies and waits for all of them
+    void waitIdle();
+
+private:
+    void beginRecording();
+    // Releases the resources of the completed batches from the oldest one, submits their acquire barriers
+    void reclaimCompletedBatches();
+    void submitAcquireBarriers(Batch& batch);
+    VkFence getFence();
+    void waitOldestBatch();
+};
@@ -1,4 +1,5 @@
 #include "VulkanBuffer.h"
+#include "UploadManager.h"
 
 VulkanBuffer::VulkanBuffer(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator)
 {
@@ -18,7 +19,7 @@ void VulkanBuffer::setDeviceAndAllocator(VulkanDevice* vulkanDevice, VmaAllocato
     this->vmaAllocator = vmaAllocator;
 }
 
-void VulkanBuffer::createBuffer(size_t bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags requiredMemoryFlags, VmaAllocationCreateFlags vmaAllocationCreateFlags, void* pData, size_t pDataSize, VmaMemoryUsage vmaMemoryUsage)
+void VulkanBuffer::createBuffer(size_t bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags requiredMemoryFlags, VmaAllocationCreateFlags vmaAllocationCreateFlags, void* pData, size_t pDataSize, VmaMemoryUsage vmaMemoryUsage, VmaPool vmaPool)
 {
     if (buffer) {
         throw MakeErrorInfo("Trying to create the same buffer multiple times!");
@@ -34,32 +35,91 @@ void VulkanBuffer::createBuffer(size_t bufferSize, VkBufferUsageFlags usageFlags
     bufferAllocationCreateInfo.usage = vmaMemoryUsage;
     bufferAllocationCreateInfo.requiredFlags = requiredMemoryFlags;
     bufferAllocationCreateInfo.flags = vmaAllocationCreateFlags;
+    bufferAllocationCreateInfo.pool = vmaPool;
 
     if (vmaCreateBuffer(vmaAllocator, &bufferCreateInfo, &bufferAllocationCreateInfo, &buffer, &vmaAllocation, &vmaAllocationInfo) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create buffer!");
     }
 
+    this->bufferSize = bufferSize;
+    this->usageFlags = usageFlags;
+    mapped = vmaAllocationInfo.pMappedData;
+    // VMA may choose coherent memory even if it wasn't required
+    vmaGetAllocationMemoryProperties(vmaAllocator, vmaAllocation, &memoryPropertyFlags);
+    coherent = memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
     // Fill buffer by pData data
     if (pData) {
-        void* pMappedBuffer = nullptr;
-        if (vmaMapMemory(vmaAllocator, vmaAllocation, &pMappedBuffer) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to map VMA memory!");
-        }
-        memcpy(pMappedBuffer, pData, pDataSize);
-        vmaUnmapMemory(vmaAllocator, vmaAllocation);
+        writeData(pData, pDataSize);
+        // Only the written range of non coherent memory is flushed
+        flushDirtyRanges();
     }
 
-    // It's non coherent memory
-    // Need flush
-    if (!(requiredMemoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-        vmaFlushAllocation(vmaAllocator, vmaAllocation, 0, pDataSize);
+    this->setupDescriptor();
+}
+
+void VulkanBuffer::createDynamicBuffer(VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VmaPool vmaPool)
+{
+    createBuffer(
+        bufferSize,
+        usageFlags,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        nullptr,
+        0,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+        vmaPool
+    );
+}
+
+void VulkanBuffer::createStaticBuffer(UploadManager& uploadManager, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, const void* pData, VmaPool vmaPool)
+{
+    VmaAllocationCreateFlags vmaAllocationCreateFlags = 0;
+    VkMemoryPropertyFlags requiredMemoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (hasHostVisibleDeviceMemory(vmaAllocator)) {
+        // VMA chooses the host visible device local memory and falls back to device local only memory(e.g. out of budget)
+        vmaAllocationCreateFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
+        requiredMemoryFlags = 0;
     }
+    // Transfer destination for the staging copy fallback
+    createBuffer(bufferSize, usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, requiredMemoryFlags, vmaAllocationCreateFlags, nullptr, 0, VMA_MEMORY_USAGE_AUTO, vmaPool);
 
-    this->setupDescriptor();
+    if (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        // Visible to the commands submitted after this call, no copy pass
+        writeData(pData, bufferSize);
+        flushDirtyRanges();
+    }
+    else {
+        uploadManager.uploadBuffer(buffer, 0, pData, bufferSize);
+    }
+}
+
+bool VulkanBuffer::hasHostVisibleDeviceMemory(VmaAllocator vmaAllocator)
+{
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(vmaAllocator, &memoryProperties);
+    VkDeviceSize largestDeviceHeapSize = 0;
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+        if ((memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && memoryProperties->memoryHeaps[i].size > largestDeviceHeapSize) {
+            largestDeviceHeapSize = memoryProperties->memoryHeaps[i].size;
+        }
+    }
+    const VkMemoryPropertyFlags hostVisibleDeviceLocal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; i++) {
+        const VkMemoryType& memoryType = memoryProperties->memoryTypes[i];
+        if ((memoryType.propertyFlags & hostVisibleDeviceLocal) == hostVisibleDeviceLocal && memoryProperties->memoryHeaps[memoryType.heapIndex].size == largestDeviceHeapSize) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void VulkanBuffer::map(void** pMappedBuffer)
 {
+    if (mapped) {
+        *pMappedBuffer = mapped;
+        return;
+    }
     if (vmaMapMemory(vmaAllocator, vmaAllocation, pMappedBuffer) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to map VMA memory!");
     }
@@ -67,6 +127,9 @@ void VulkanBuffer::map(void** pMappedBuffer)
 
 void VulkanBuffer::unmap()
 {
+    if (mapped) {
+        return;
+    }
     vmaUnmapMemory(vmaAllocator, vmaAllocation);
 }
 
@@ -75,6 +138,37 @@ void VulkanBuffer::flush(VkDeviceSize offset, VkDeviceSize size)
     vmaFlushAllocation(vmaAllocator, vmaAllocation, offset, size);
 }
 
+void VulkanBuffer::writeData(const void* pData, VkDeviceSize size, VkDeviceSize offset)
+{
+    if (mapped) {
+        memcpy(static_cast<uint8_t*>(mapped) + offset, pData, size);
+    }
+    else {
+        void* pMappedBuffer = nullptr;
+        map(&pMappedBuffer);
+        memcpy(static_cast<uint8_t*>(pMappedBuffer) + offset, pData, size);
+        unmap();
+    }
+    if (!coherent) {
+        dirtyOffsets.push_back(offset);
+        dirtySizes.push_back(size);
+    }
+}
+
+void VulkanBuffer::flushDirtyRanges()
+{
+    if (dirtyOffsets.empty()) {
+        return;
+    }
+    // VMA aligns the ranges to nonCoherentAtomSize
+    flushAllocations.assign(dirtyOffsets.size(), vmaAllocation);
+    if (vmaFlushAllocations(vmaAllocator, (uint32_t)flushAllocations.size(), flushAllocations.data(), dirtyOffsets.data(), dirtySizes.data()) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to flush VMA memory!");
+    }
+    dirtyOffsets.clear();
+    dirtySizes.clear();
+}
+
 void VulkanBuffer::setupDescriptor(VkDeviceSize size, VkDeviceSize offset)
 {
     descriptor.offset = offset;
@@ -88,4 +182,7 @@ void VulkanBuffer::destroy()
         vmaDestroyBuffer(vmaAllocator, buffer, vmaAllocation);
     }
     buffer = VK_NULL_HANDLE;
+    mapped = nullptr;
+    dirtyOffsets.clear();
+    dirtySizes.clear();
 }
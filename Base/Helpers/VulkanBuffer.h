@@ -1,21 +1,38 @@
 #pragma once
 
+#include <vector>
 #include <vulkan/vulkan.h>
 #include "VulkanDevice.h"
 #include "VulkanTools.h"
 #include "vk_mem_alloc.h"
 
+class UploadManager;
+
 class VulkanBuffer
 {
 private:
     VulkanDevice* vulkanDevice = nullptr;
     VmaAllocator vmaAllocator = NULL;
+    // Ranges written by write() and not flushed yet(only for non coherent memory)
+    std::vector<VkDeviceSize> dirtyOffsets;
+    std::vector<VkDeviceSize> dirtySizes;
+    // vmaAllocation repeated for each range of vmaFlushAllocations(), kept to reuse its memory
+    std::vector<VmaAllocation> flushAllocations;
 
 public:
     VkBuffer buffer = VK_NULL_HANDLE;
     VmaAllocation vmaAllocation{};
     VmaAllocationInfo vmaAllocationInfo{};
     VkDescriptorBufferInfo descriptor;
+    // Size and usage the buffer was created with
+    VkDeviceSize bufferSize = 0;
+    VkBufferUsageFlags usageFlags = 0;
+    // Persistently mapped memory if the buffer was created with VMA_ALLOCATION_CREATE_MAPPED_BIT, otherwise nullptr
+    void* mapped = nullptr;
+    // Properties of the memory type VMA has chosen
+    VkMemoryPropertyFlags memoryPropertyFlags = 0;
+    // The memory is host coherent, writes don't need flushes
+    bool coherent = false;
 
     VulkanBuffer(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator);
     VulkanBuffer();
@@ -36,8 +53,12 @@ public:
     // If not nullptr, it sets a pointer to the data that must be copied to the buffer after it is created
     // - pDataSize
     // The size of the data that must be copied from pData
+    // The memory is flushed after the copy if it isn't coherent
     // - vmaMemoryUsage
     // Default: VMA_MEMORY_USAGE_AUTO
+    // - vmaPool
+    // Custom pool to allocate from(see MemoryPools), the memory type of the pool is used
+    // Default: nullptr(default pools)
     void createBuffer(
         size_t bufferSize,
         VkBufferUsageFlags usageFlags,
@@ -45,11 +66,37 @@ public:
         VmaAllocationCreateFlags vmaAllocationCreateFlags = 0,
         void* pData = nullptr,
         size_t pDataSize = 0,
-        VmaMemoryUsage vmaMemoryUsage = VMA_MEMORY_USAGE_AUTO
+        VmaMemoryUsage vmaMemoryUsage = VMA_MEMORY_USAGE_AUTO,
+        VmaPool vmaPool = nullptr
     );
+
+    // Buffer written by the CPU every frame(uniform buffers), persistently mapped
+    // DEVICE_LOCAL | HOST_VISIBLE memory(BAR, resizable BAR, UMA) is preferred, so the GPU doesn't read it over the bus,
+    // otherwise the host memory is used. The memory may be not coherent, writes are followed by flushDirtyRanges()
+    void createDynamicBuffer(VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VmaPool vmaPool = nullptr);
+    // Device local buffer with the initial data(vertices, indices), it isn't mapped
+    // If VMA has chosen host visible memory(resizable BAR, UMA), the data is written directly,
+    // otherwise the copy from the staging memory is recorded into uploadManager
+    void createStaticBuffer(UploadManager& uploadManager, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, const void* pData, VmaPool vmaPool = nullptr);
+    // True if a DEVICE_LOCAL | HOST_VISIBLE memory type covers the largest device local heap(resizable BAR or UMA)
+    // With the 256 MB BAR only the dynamic buffers use it, the static data would take the small heap
+    static bool hasHostVisibleDeviceMemory(VmaAllocator vmaAllocator);
+
+    // Returns the persistent mapping without VMA calls if the buffer has one
     void map(void** pMappedBuffer);
     void unmap();
     void flush(VkDeviceSize offset, VkDeviceSize size);
+
+    // Copies the data to the buffer memory(through the persistent mapping if there is one, otherwise map + unmap)
+    // The range is remembered for flushDirtyRanges() if the memory isn't coherent
+    void writeData(const void* pData, VkDeviceSize size, VkDeviceSize offset = 0);
+    template<typename T>
+    void write(VkDeviceSize offset, const T& value)
+    {
+        writeData(&value, sizeof(T), offset);
+    }
+    // Flushes all ranges written since the last flush with one call
+    void flushDirtyRanges();
     void setupDescriptor(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
     void destroy();
 };
@@ -31,7 +31,7 @@ VulkanDevice::VulkanDevice(VkPhysicalDevice physicalDevice)
 VulkanDevice::~VulkanDevice()
 {
     if (this->logicalDevice) {
-        vkDestroyDevice(this->logicalDevice, nullptr);
+        vkDestroyDevice(this->logicalDevice, getHostAllocationCallbacks());
     }
 }
 
@@ -186,7 +186,7 @@ void VulkanDevice::findQueueFamilyIndices(VkQueueFlags requiredQueueFamilyTypes,
     this->queueFamilyIndices = indices;
 }
 
-void VulkanDevice::createLogicalDevice(VkPhysicalDeviceFeatures requiredFeatures, std::vector<std::string> requiredExtensionsNames)
+void VulkanDevice::createLogicalDevice(VkPhysicalDeviceFeatures requiredFeatures, std::vector<std::string> requiredExtensionsNames, const void* pNext)
 {
     // We already have a logical device and cannot create a second one
     if (this->logicalDevice) {
@@ -227,6 +227,7 @@ void VulkanDevice::createLogicalDevice(VkPhysicalDeviceFeatures requiredFeatures
     // Create logical device
     VkDeviceCreateInfo deviceCreateInfo{};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pNext = pNext;
     deviceCreateInfo.queueCreateInfoCount = queueCreateInfos.size();
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
     std::vector<const char*> requiredExtensionsNames_const_char_ptr;
@@ -238,13 +239,14 @@ void VulkanDevice::createLogicalDevice(VkPhysicalDeviceFeatures requiredFeatures
     deviceCreateInfo.pEnabledFeatures = &requiredFeatures;
 
     VkResult result;
-    result = vkCreateDevice(this->physicalDevice, &deviceCreateInfo, nullptr, &this->logicalDevice);
+    result = vkCreateDevice(this->physicalDevice, &deviceCreateInfo, getHostAllocationCallbacks(), &this->logicalDevice);
     if (result != VK_SUCCESS && result != VK_ERROR_FEATURE_NOT_PRESENT) {
         throw MakeErrorInfo("Failed to create a logical device!");
     }
     else if (result == VK_ERROR_FEATURE_NOT_PRESENT) {
         throw MakeErrorInfo("The physical device does not support the required feature! It looks like the sample incorrectly checks and set the required features");
     }
+    enabledFeatures = requiredFeatures;
 }
 
 VkCommandBuffer VulkanDevice::beginSingleTimeCommands(VkCommandPool commandPool)
@@ -279,11 +281,11 @@ void VulkanDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer, VkQueue
     VkFence fence;
     VkFenceCreateInfo fenceCreateInfo = vulkanInitializers::fenceCreateInfo();
 
-    vkCreateFence(this->logicalDevice, &fenceCreateInfo, nullptr, &fence);
+    vkCreateFence(this->logicalDevice, &fenceCreateInfo, getHostAllocationCallbacks(), &fence);
 
     VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
     vkWaitForFences(this->logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX);
 
-    vkDestroyFence(this->logicalDevice, fence, nullptr);
+    vkDestroyFence(this->logicalDevice, fence, getHostAllocationCallbacks());
     vkFreeCommandBuffers(this->logicalDevice, commandPool, 1, &commandBuffer);
 }
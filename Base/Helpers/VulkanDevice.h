@@ -52,7 +52,8 @@ public:
     void findQueueFamilyIndices(VkQueueFlags requiredQueueFamilyTypes, VkSurfaceKHR surface);
 
     // Create logical device
-    void createLogicalDevice(VkPhysicalDeviceFeatures requiredFeatures, std::vector<std::string> requiredExtensionsNames);
+    // pNext - chain of additional feature structures(e.g. VkPhysicalDeviceTimelineSemaphoreFeatures), can be NULL
+    void createLogicalDevice(VkPhysicalDeviceFeatures requiredFeatures, std::vector<std::string> requiredExtensionsNames, const void* pNext = nullptr);
 
     // Allocates the command buffer from the command pool and starts recording commands to it
     VkCommandBuffer beginSingleTimeCommands(VkCommandPool commandPool);
@@ -30,15 +30,26 @@ VulkanSwapChain::VulkanSwapChain(VulkanDevice* vulkanDevice, VkSurfaceKHR surfac
     }
 }
 
+VulkanSwapChain::VulkanSwapChain(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator)
+{
+    this->vulkanDevice = vulkanDevice;
+    this->vmaAllocator = vmaAllocator;
+    this->offscreen = true;
+}
+
 VulkanSwapChain::~VulkanSwapChain()
 {
     for (const auto& swapChainImageView : this->imagesViews) {
         if (swapChainImageView != VK_NULL_HANDLE) {
-            vkDestroyImageView(this->vulkanDevice->logicalDevice, swapChainImageView, nullptr);
+            vkDestroyImageView(this->vulkanDevice->logicalDevice, swapChainImageView, getHostAllocationCallbacks());
         }
     }
+    // Offscreen images are owned by us, swap chain images are owned by the swap chain
+    for (size_t i = 0; i < this->imagesAllocations.size(); i++) {
+        vmaDestroyImage(this->vmaAllocator, this->images[i], this->imagesAllocations[i]);
+    }
     if (this->swapChain) {
-        vkDestroySwapchainKHR(this->vulkanDevice->logicalDevice, this->swapChain, nullptr);
+        vkDestroySwapchainKHR(this->vulkanDevice->logicalDevice, this->swapChain, getHostAllocationCallbacks());
     }
 }
 
@@ -110,7 +121,7 @@ void VulkanSwapChain::createSwapChain(VkSurfaceFormatKHR preferredFormat, VkPres
     swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
 
     VkResult result;
-    result = vkCreateSwapchainKHR(vulkanDevice->logicalDevice, &swapChainCreateInfo, nullptr, &this->swapChain);
+    result = vkCreateSwapchainKHR(vulkanDevice->logicalDevice, &swapChainCreateInfo, getHostAllocationCallbacks(), &this->swapChain);
     if (result != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create a swapchain!");
     }
@@ -121,6 +132,48 @@ void VulkanSwapChain::createSwapChain(VkSurfaceFormatKHR preferredFormat, VkPres
     vkGetSwapchainImagesKHR(vulkanDevice->logicalDevice, swapChain, &imageCount, images.data());
 
     // Create image views for swap chain images
+    createImagesViews();
+}
+
+void VulkanSwapChain::createOffscreenImages(VkFormat format, VkExtent2D extent, uint32_t imageCount)
+{
+    // There is no surface, so the format and the extent are chosen by the application
+    surfaceFormat = { format, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+    surfacePresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    surfaceExtent = extent;
+    surfaceSupportDetails.capabilities.minImageCount = imageCount;
+    surfaceSupportDetails.capabilities.maxImageCount = imageCount;
+    surfaceSupportDetails.capabilities.currentExtent = extent;
+
+    VkImageCreateInfo imageCreateInfo{};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = format;
+    imageCreateInfo.extent = { extent.width, extent.height, 1 };
+    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocationCreateInfo{};
+    allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+    images.resize(imageCount);
+    imagesAllocations.resize(imageCount);
+    for (uint32_t i = 0; i < imageCount; i++) {
+        if (vmaCreateImage(vmaAllocator, &imageCreateInfo, &allocationCreateInfo, &images[i], &imagesAllocations[i], nullptr) != VK_SUCCESS) {
+            throw MakeErrorInfo("Failed to create offscreen image!");
+        }
+    }
+
+    createImagesViews();
+}
+
+void VulkanSwapChain::createImagesViews()
+{
     imagesViews.resize(images.size());
     for (uint32_t i = 0; i < imagesViews.size(); i++) {
         VkImageViewCreateInfo imageViewCreateInfo{};
@@ -138,7 +191,7 @@ void VulkanSwapChain::createSwapChain(VkSurfaceFormatKHR preferredFormat, VkPres
         imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
         imageViewCreateInfo.subresourceRange.layerCount = 1;
         VkResult result;
-        result = vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &imagesViews[i]);
+        result = vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &imagesViews[i]);
         if (result != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create image view for swap chain image!");
         }
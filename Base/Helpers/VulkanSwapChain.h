@@ -7,6 +7,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include "VulkanDevice.h"
+#include "vk_mem_alloc.h"
 
 class VulkanSwapChain
 {
@@ -29,10 +30,18 @@ public:
     VkSurfaceFormatKHR          surfaceFormat{};
     VkPresentModeKHR            surfacePresentMode{};
     VkExtent2D                  surfaceExtent{};
+
+    // Offscreen(headless) mode: there is no surface and no presentation engine,
+    // images are allocated by VMA and are cycled by the application itself
+    bool                        offscreen = false;
+    VmaAllocator                vmaAllocator = VK_NULL_HANDLE;
+    std::vector<VmaAllocation>  imagesAllocations;
     
     // Collects and save data about swapchain for VulkanDevice
     // Choose optimal swap chain parameters (format, present mode and extent)
     VulkanSwapChain(VulkanDevice* vulkanDevice, VkSurfaceKHR surface, GLFWwindow* window);
+    // Offscreen swap chain replacement, images are created by createOffscreenImages()
+    VulkanSwapChain(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator);
     ~VulkanSwapChain();
     
     // Choose format, present mode, extent
@@ -41,6 +50,10 @@ public:
     // Retrieving the swap chain images
     void createSwapChain(VkSurfaceFormatKHR preferredFormat, VkPresentModeKHR preferredPresentMode);
 
+    // Creates a ring of imageCount color images (and image views) in device local memory
+    // Images can be used as color attachment and as transfer source(for reading back the result)
+    void createOffscreenImages(VkFormat format, VkExtent2D extent, uint32_t imageCount);
+
     // Checks whether preferredFormat is supported by surface,
     // if it is available, it will be selected and the function will return true,
     // otherwise another supported format will be selected and the function will return false(this does not mean that further work is impossible)
@@ -53,4 +66,8 @@ public:
 
     // Set swap chain image extent using surface capabilities
     void setSwapChainExtent();
+
+private:
+    // Create image views for images
+    void createImagesViews();
 };
@@ -7,13 +7,57 @@ void VulkanTexture::updateDescriptor()
     descriptor.imageLayout = imageLayout;
 }
 
+VkImageUsageFlags VulkanTexture::getViewUsage() const
+{
+    if (imageFlags & VK_IMAGE_CREATE_EXTENDED_USAGE_BIT) {
+        return imageUsage & ~VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+    return imageUsage;
+}
+
+void VulkanTexture::createImage(const VkImageCreateInfo& imageCreateInfo, VmaPool vmaPool)
+{
+    imageFlags = imageCreateInfo.flags;
+    VmaAllocationCreateInfo imageAllocationCreateInfo{};
+    imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    imageAllocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    imageAllocationCreateInfo.pool = vmaPool;
+    // VMA doesn't check the memory type of a pool against the image, the allocation is bound after the check
+    if (vmaPool) {
+        imageAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_DONT_BIND_BIT;
+    }
+
+    if (vmaCreateImage(vmaAllocator, &imageCreateInfo, &imageAllocationCreateInfo, &image, &vmaImageAllocation, &vmaImageAllocationInfo) != VK_SUCCESS) {
+        throw MakeErrorInfo("Failed to create image!");
+    }
+    if (!vmaPool) {
+        return;
+    }
+
+    VkMemoryRequirements memoryRequirements{};
+    vkGetImageMemoryRequirements(vulkanDevice->logicalDevice, image, &memoryRequirements);
+    if (!(memoryRequirements.memoryTypeBits & (1u << vmaImageAllocationInfo.memoryType))) {
+        // Incompatible memory type of the pool, the default pools choose a type the image allows
+        vmaFreeMemory(vmaAllocator, vmaImageAllocation);
+        imageAllocationCreateInfo.pool = nullptr;
+        imageAllocationCreateInfo.flags = 0;
+        if (vmaAllocateMemoryForImage(vmaAllocator, image, &imageAllocationCreateInfo, &vmaImageAllocation, &vmaImageAllocationInfo) != VK_SUCCESS) {
+            vkDestroyImage(vulkanDevice->logicalDevice, image, getHostAllocationCallbacks());
+            image = VK_NULL_HANDLE;
+            vmaImageAllocation = nullptr;
+            throw MakeErrorInfo("Failed to allocate image memory!");
+        }
+    }
+    VK_CHECK_RESULT(vmaBindImageMemory(vmaAllocator, vmaImageAllocation, image));
+}
+
 void VulkanTexture::destroy()
 {
     if (sampler) {
-        vkDestroySampler(vulkanDevice->logicalDevice, sampler, nullptr);
+        vkDestroySampler(vulkanDevice->logicalDevice, sampler, getHostAllocationCallbacks());
     }
     if (imageView) {
-        vkDestroyImageView(vulkanDevice->logicalDevice, imageView, nullptr);
+        vkDestroyImageView(vulkanDevice->logicalDevice, imageView, getHostAllocationCallbacks());
     }
     if (image) {
         vmaDestroyImage(vmaAllocator, image, vmaImageAllocation);
@@ -39,7 +83,16 @@ void VulkanTexture2D::setDeviceAndAllocator(VulkanDevice* vulkanDevice, VmaAlloc
 }
 
 
-void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPool transferCommandPool, unsigned char* imageData, uint32_t width, uint32_t height, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout)
+void VulkanTexture2D::createTextureFromMemory(UploadManager& uploadManager, unsigned char* imageData, uint32_t width, uint32_t height, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout, VmaPool vmaPool, bool generateMipmaps)
+{
+    // Copy image data to the staging ring
+    VkDeviceSize imageSize = (VkDeviceSize)width * height * getTexelSize(textureFormat);
+    UploadManager::StagingAllocation staging = uploadManager.allocateStaging(imageSize, getTexelSize(textureFormat) * 4);
+    memcpy(staging.data, imageData, imageSize);
+    createTextureFromStaging(uploadManager, staging, width, height, filter, imageUsageFlags, imageLayout, vmaPool, generateMipmaps);
+}
+
+void VulkanTexture2D::createTextureFromStaging(UploadManager& uploadManager, const UploadManager::StagingAllocation& staging, uint32_t width, uint32_t height, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout, VmaPool vmaPool, bool generateMipmaps)
 {
     // Load image raw data to GPU memory
     // 
@@ -50,20 +103,17 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
     this->height = height;
     this->mipLevels = 1;
 
-    // RGBA
-    uint32_t imageSize = width * height * 4;
-
-    // Create staging buffer
-    VulkanBuffer stagingBuffer(vulkanDevice, vmaAllocator);
-    stagingBuffer.createBuffer(
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-        imageData,
-        imageSize
-    );
+    // Levels 1..mipLevels-1 are downsampled from the uploaded level 0 right after the copy
+    UploadManager::MipmapGeneration mipmapGeneration;
+    if (generateMipmaps) {
+        mipmapGeneration.method = uploadManager.getMipmapMethod(textureFormat);
+        mipmapGeneration.format = textureFormat;
+        mipmapGeneration.width = width;
+        mipmapGeneration.height = height;
+        if (mipmapGeneration.method != MipmapGenerator::Method::None) {
+            this->mipLevels = MipmapGenerator::getMipLevelCount(width, height);
+        }
+    }
 
     // Create image
     VkImageCreateInfo imageCreateInfo{};
@@ -75,21 +125,19 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
     imageCreateInfo.arrayLayers = 1;
     imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    // Transfer source for the copy to a new place by the defragmenter
+    imageUsage = imageUsageFlags | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (mipLevels > 1) {
+        imageUsage |= MipmapGenerator::getRequiredUsage(mipmapGeneration.method);
+        imageCreateInfo.flags = MipmapGenerator::getRequiredFlags(textureFormat, mipmapGeneration.method);
+    }
+    imageCreateInfo.usage = imageUsage;
     imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    VmaAllocationCreateInfo imageAllocationCreateInfo{};
-    imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    imageAllocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-    if (vmaCreateImage(vmaAllocator, &imageCreateInfo, &imageAllocationCreateInfo, &image, &vmaImageAllocation, &vmaImageAllocationInfo) != VK_SUCCESS) {
-        throw MakeErrorInfo("Failed to create image!");
-    }
-
-    // Copy image data from buffer to image
-    VkCommandBuffer commandBuffer = vulkanDevice->beginSingleTimeCommands(transferCommandPool);
+    createImage(imageCreateInfo, vmaPool);
 
+    // Record the copy of the staging memory to image
     VkImageSubresourceRange subresourceRange = {};
     subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     subresourceRange.baseMipLevel = 0;
@@ -97,62 +145,29 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
     subresourceRange.baseArrayLayer = 0;
     subresourceRange.layerCount = 1;
 
-    // Transition the texture image layout to transfer target, so we can safely copy our buffer data to it
-    vulkanTools::insertImageMemoryBarrier(
-        commandBuffer,
-        image,
-        0, // srcAccessMask - We do not perform any operations before memory barrier
-        VK_ACCESS_TRANSFER_WRITE_BIT, // dstAccessMask - We write after memory barrier
-        VK_IMAGE_LAYOUT_UNDEFINED, // oldImageLayout
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // newImageLayout
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // srcStageMask - We don't wait anything before the barrier
-        VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask - Stages in which we make transfer operations should wait a barrier
-        subresourceRange
-    );
-
-    // Copy buffer to image
-    // Setup buffer copy regions without mip levels and layers
-    VkBufferImageCopy bufferCopyRegion{};
-    bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    bufferCopyRegion.imageSubresource.mipLevel = 0;
-    bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-    bufferCopyRegion.imageSubresource.layerCount = 1;
-    bufferCopyRegion.imageExtent.width = width;
-    bufferCopyRegion.imageExtent.height = height;
-    bufferCopyRegion.imageExtent.depth = 1;
-    bufferCopyRegion.bufferOffset = 0;
-
-    // Copy image from staging buffer
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        stagingBuffer.buffer,
-        image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &bufferCopyRegion
-    );
+    // Setup buffer copy regions without mip levels and layers(only level 0 is copied)
+    std::vector<VkBufferImageCopy> bufferCopyRegions(1);
+    bufferCopyRegions[0].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    bufferCopyRegions[0].imageSubresource.mipLevel = 0;
+    bufferCopyRegions[0].imageSubresource.baseArrayLayer = 0;
+    bufferCopyRegions[0].imageSubresource.layerCount = 1;
+    bufferCopyRegions[0].imageExtent.width = width;
+    bufferCopyRegions[0].imageExtent.height = height;
+    bufferCopyRegions[0].imageExtent.depth = 1;
+    bufferCopyRegions[0].bufferOffset = 0;
 
     // Change image layout to imageLayout after transfer
     this->imageLayout = imageLayout;
-    vulkanTools::insertImageMemoryBarrier(
-        commandBuffer,
-        image,
-        VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask - We write the data to the image
-        VK_ACCESS_SHADER_READ_BIT, // dstAccessMask - The shader reads data from the image
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
-        imageLayout, // newImageLayout
-        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask - We have to wait for the transfer operation that loads the image
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, // dstStageMask - The shader should read the data only after it is loaded to image
-        subresourceRange
-    );
-
-    vulkanDevice->endSingleTimeCommands(commandBuffer, transferQueue, transferCommandPool);
-    // Destroy staging buffer
-    stagingBuffer.destroy();
+    uploadManager.copyToImage(staging, image, bufferCopyRegions, subresourceRange, imageLayout, mipLevels > 1 ? &mipmapGeneration : nullptr);
 
     // Create image view
+    VkImageViewUsageCreateInfo imageViewUsageCreateInfo{};
+    imageViewUsageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+    imageViewUsageCreateInfo.usage = getViewUsage();
     VkImageViewCreateInfo imageViewCreateInfo{};
     imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    // Vulkan 1.1, the usage is restricted only for the images created with the extended usage
+    imageViewCreateInfo.pNext = imageViewUsageCreateInfo.usage != imageUsage ? &imageViewUsageCreateInfo : nullptr;
     imageViewCreateInfo.image = image;
     imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
     imageViewCreateInfo.format = textureFormat;
@@ -163,7 +178,7 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
     imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
     imageViewCreateInfo.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &imageView) != VK_SUCCESS) {
+    if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &imageView) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create image view!");
     }
 
@@ -179,7 +194,7 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
     samplerCreateInfo.mipLodBias = 0.0f;
     samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
     samplerCreateInfo.minLod = 0.0f;
-    samplerCreateInfo.maxLod = 0.0f;
+    samplerCreateInfo.maxLod = (float)mipLevels;
     if (vulkanDevice->enabledFeatures.samplerAnisotropy == VK_TRUE) {
         samplerCreateInfo.anisotropyEnable = VK_TRUE;
         samplerCreateInfo.maxAnisotropy = vulkanDevice->properties.limits.maxSamplerAnisotropy;
@@ -189,7 +204,7 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
         samplerCreateInfo.maxAnisotropy = 1.0f;
     }
 
-    if (vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, nullptr, &sampler) != VK_SUCCESS) {
+    if (vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, getHostAllocationCallbacks(), &sampler) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create sampler!");
     }
 
@@ -198,11 +213,8 @@ void VulkanTexture2D::createTextureFromMemory(VkQueue transferQueue, VkCommandPo
     descriptor.imageLayout = imageLayout;
 }
 
-void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool transferCommandPool, std::string filePath, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout)
+ktxTexture* VulkanTexture2D::loadKTXFile(std::string filePath, const VulkanDevice* vulkanDevice)
 {
-    // We create the image in the local memory of the device(without the possibility of mapping to the host memory)
-    // and use an staging buffer to copy the texture data to image memory
-
     ktxResult result;
     ktxTexture* ktxTexture;
 
@@ -214,26 +226,106 @@ void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool
     if (result != KTX_SUCCESS) {
         throw MakeErrorInfo("ktx: failed to load texture!");
     }
+    if (vulkanDevice) {
+        try {
+            transcodeKTX(ktxTexture, vulkanDevice);
+        }
+        catch (...) {
+            ktxTexture_Destroy(ktxTexture);
+            throw;
+        }
+    }
+    return ktxTexture;
+}
+
+void VulkanTexture2D::transcodeKTX(ktxTexture* ktxTexture, const VulkanDevice* vulkanDevice)
+{
+    if (ktxTexture->classId != ktxTexture2_c) {
+        return;
+    }
+    ktxTexture2* ktxTexture2 = reinterpret_cast<struct ktxTexture2*>(ktxTexture);
+    if (!ktxTexture2_NeedsTranscoding(ktxTexture2)) {
+        return;
+    }
+
+    VkPhysicalDeviceFeatures features = vulkanDevice->enabledFeatures;
+    // RGBA8 is supported everywhere but takes 4-8 times more memory than the block formats
+    ktx_transcode_fmt_e transcodeFormat = KTX_TTF_RGBA32;
+    // ETC1S is BasisLZ supercompressed, it is a subset of ETC1 so ETC2 keeps its quality
+    // UASTC is closest to ASTC 4x4, BC7 is the best block format of desktop GPUs for both
+    if (ktxTexture2->supercompressionScheme == KTX_SS_BASIS_LZ) {
+        if (features.textureCompressionETC2) {
+            transcodeFormat = KTX_TTF_ETC2_RGBA;
+        }
+        else if (features.textureCompressionBC) {
+            transcodeFormat = KTX_TTF_BC7_RGBA;
+        }
+        else if (features.textureCompressionASTC_LDR) {
+            transcodeFormat = KTX_TTF_ASTC_4x4_RGBA;
+        }
+    }
+    else {
+        if (features.textureCompressionASTC_LDR) {
+            transcodeFormat = KTX_TTF_ASTC_4x4_RGBA;
+        }
+        else if (features.textureCompressionBC) {
+            transcodeFormat = KTX_TTF_BC7_RGBA;
+        }
+        else if (features.textureCompressionETC2) {
+            transcodeFormat = KTX_TTF_ETC2_RGBA;
+        }
+    }
+
+    if (ktxTexture2_TranscodeBasis(ktxTexture2, transcodeFormat, 0) != KTX_SUCCESS) {
+        throw MakeErrorInfo("ktx: failed to transcode texture!");
+    }
+}
+
+void VulkanTexture2D::createTextureFromKTX(UploadManager& uploadManager, std::string filePath, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout, VmaPool vmaPool)
+{
+    ktxTexture* ktxTexture = loadKTXFile(filePath);
+    try {
+        createTextureFromKTX(uploadManager, ktxTexture, filter, imageUsageFlags, imageLayout, vmaPool);
+    }
+    catch (...) {
+        ktxTexture_Destroy(ktxTexture);
+        throw;
+    }
+    // The data has been copied to the staging ring
+    ktxTexture_Destroy(ktxTexture);
+}
+
+void VulkanTexture2D::createTextureFromKTX(UploadManager& uploadManager, ktxTexture* ktxTexture, VkFilter filter, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout, VmaPool vmaPool, uint32_t baseLevel)
+{
+    // We create the image in the local memory of the device(without the possibility of mapping to the host memory)
+    // and use an staging buffer to copy the texture data to image memory
+
+    // Basis Universal textures not transcoded by loadKTXFile()
+    transcodeKTX(ktxTexture, vulkanDevice);
+
+    // The format is stored in the file(vkFormat of KTX2, GL internal format of KTX1)
+    textureFormat = ktxTexture_GetVkFormat(ktxTexture);
+    if (textureFormat == VK_FORMAT_UNDEFINED) {
+        throw MakeErrorInfo("ktx: texture format has no Vulkan equivalent!");
+    }
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(vulkanDevice->physicalDevice, textureFormat, &formatProperties);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        throw MakeErrorInfo("The KTX texture format is not supported by the device!");
+    }
+
+    if (baseLevel >= ktxTexture->numLevels) {
+        throw MakeErrorInfo("ktx: the base level is out of the texture levels!");
+    }
 
     // Get texture properties 
-    width = ktxTexture->baseWidth;
-    height = ktxTexture->baseHeight;
-    mipLevels = ktxTexture->numLevels;
+    width = ktxTexture->baseWidth >> baseLevel;
+    height = ktxTexture->baseHeight >> baseLevel;
+    width = width > 0 ? width : 1;
+    height = height > 0 ? height : 1;
+    mipLevels = ktxTexture->numLevels - baseLevel;
     layerCount = ktxTexture->numLayers;
     ktx_uint8_t* ktxTextureData = ktxTexture_GetData(ktxTexture);
-    ktx_size_t ktxTextureSize = ktxTexture_GetDataSize(ktxTexture);
-
-    // Create staging buffer
-    VulkanBuffer stagingBuffer(vulkanDevice, vmaAllocator);
-    stagingBuffer.createBuffer(
-        ktxTextureSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-        ktxTextureData,
-        ktxTextureSize
-    );
 
     // Create image
     VkImageCreateInfo imageCreateInfo{};
@@ -245,21 +337,15 @@ void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool
     imageCreateInfo.arrayLayers = layerCount;
     imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    // Transfer source for the copy to a new place by the defragmenter
+    imageUsage = imageUsageFlags | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.usage = imageUsage;
     imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    VmaAllocationCreateInfo imageAllocationCreateInfo{};
-    imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    imageAllocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-    if (vmaCreateImage(vmaAllocator, &imageCreateInfo, &imageAllocationCreateInfo, &image, &vmaImageAllocation, &vmaImageAllocationInfo) != VK_SUCCESS) {
-        throw MakeErrorInfo("Failed to create image!");
-    }
-
-    // Copy data from staging buffer to image
-    VkCommandBuffer commandBuffer = vulkanDevice->beginSingleTimeCommands(transferCommandPool);
+    createImage(imageCreateInfo, vmaPool);
 
+    // Copy data to the staging ring and record the copy to image
     // The sub resource range describes the regions of the image that will be transitioned using the memory barriers below
     VkImageSubresourceRange subresourceRange = {};
     // Image only contains color data
@@ -271,69 +357,45 @@ void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool
     subresourceRange.baseArrayLayer = 0;
     subresourceRange.layerCount = layerCount;
 
-    // Transition the texture image layout to transfer target, so we can safely copy our buffer data to it
-    vulkanTools::insertImageMemoryBarrier(
-        commandBuffer,
-        image,
-        0, // srcAccessMask - We do not perform any operations before memory barrier
-        VK_ACCESS_TRANSFER_WRITE_BIT, // dstAccessMask - We write after memory barrier
-        VK_IMAGE_LAYOUT_UNDEFINED, // oldImageLayout
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // newImageLayout
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // srcStageMask - We don't wait anything before the barrier
-        VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask - Stages in which we make transfer operations should wait a barrier
-        subresourceRange);
-
     // Copy buffer to image
 
     // Setup buffer copy regions for each layer and mip level
+    // Only the range of the file data with the uploaded levels is copied to the staging memory
     std::vector<VkBufferImageCopy> bufferCopyRegions;
+    ktx_size_t dataBegin = ktxTexture_GetDataSize(ktxTexture);
+    ktx_size_t dataEnd = 0;
     for (uint32_t currentLayer = 0; currentLayer < layerCount; currentLayer++) {
-        for (uint32_t currentLevel = 0; currentLevel < mipLevels; currentLevel++) {
+        for (uint32_t currentLevel = baseLevel; currentLevel < ktxTexture->numLevels; currentLevel++) {
             ktx_size_t offset;
             KTX_error_code ret = ktxTexture_GetImageOffset(ktxTexture, currentLevel, currentLayer, 0, &offset);
             assert(ret == KTX_SUCCESS);
+            ktx_size_t imageEnd = offset + ktxTexture_GetImageSize(ktxTexture, currentLevel);
+            dataBegin = offset < dataBegin ? offset : dataBegin;
+            dataEnd = imageEnd > dataEnd ? imageEnd : dataEnd;
             // Setup a buffer image copy structure for the current layer and mip level
             VkBufferImageCopy bufferCopyRegion = {};
             bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            bufferCopyRegion.imageSubresource.mipLevel = currentLevel;
+            bufferCopyRegion.imageSubresource.mipLevel = currentLevel - baseLevel;
             bufferCopyRegion.imageSubresource.baseArrayLayer = currentLayer;
             bufferCopyRegion.imageSubresource.layerCount = 1;
-            bufferCopyRegion.imageExtent.width = ktxTexture->baseWidth >> currentLevel;
-            bufferCopyRegion.imageExtent.height = ktxTexture->baseHeight >> currentLevel;
+            // Not a multiple of the block size for small levels of block compressed formats, it is the level size
+            uint32_t levelWidth = ktxTexture->baseWidth >> currentLevel;
+            uint32_t levelHeight = ktxTexture->baseHeight >> currentLevel;
+            bufferCopyRegion.imageExtent.width = levelWidth > 0 ? levelWidth : 1;
+            bufferCopyRegion.imageExtent.height = levelHeight > 0 ? levelHeight : 1;
             bufferCopyRegion.imageExtent.depth = 1;
             bufferCopyRegion.bufferOffset = offset;
             bufferCopyRegions.push_back(bufferCopyRegion);
         }
     }
 
-    // Copy mip levels from staging buffer
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        stagingBuffer.buffer,
-        image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        bufferCopyRegions.size(),
-        bufferCopyRegions.data());
+    for (VkBufferImageCopy& bufferCopyRegion : bufferCopyRegions) {
+        bufferCopyRegion.bufferOffset -= dataBegin;
+    }
 
     // Change image layout to imageLayout after transfer
     this->imageLayout = imageLayout;
-    vulkanTools::insertImageMemoryBarrier(
-        commandBuffer,
-        image,
-        VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask - We write the data to the image
-        VK_ACCESS_SHADER_READ_BIT, // dstAccessMask - The shader reads data from the image
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
-        imageLayout, // newImageLayout
-        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask - We have to wait for the transfer operation that loads the image
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, // dstStageMask - The shader should read the data only after it is loaded to image
-        subresourceRange
-    );
-
-    vulkanDevice->endSingleTimeCommands(commandBuffer, transferQueue, transferCommandPool);
-
-    // Destroy staging buffer
-    stagingBuffer.destroy();
-    ktxTexture_Destroy(ktxTexture);
+    uploadManager.uploadImage(image, ktxTextureData + dataBegin, dataEnd - dataBegin, bufferCopyRegions, subresourceRange, imageLayout);
 
     // Create image view
     VkImageViewCreateInfo imageViewCreateInfo{};
@@ -348,7 +410,7 @@ void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool
     imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
     imageViewCreateInfo.subresourceRange.layerCount = layerCount;
 
-    if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &imageView) != VK_SUCCESS) {
+    if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &imageView) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create image view!");
     }
 
@@ -378,7 +440,7 @@ void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool
     samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
 
-    if (vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, nullptr, &sampler) != VK_SUCCESS) {
+    if (vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, getHostAllocationCallbacks(), &sampler) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create sampler!");
     }
 
@@ -387,40 +449,64 @@ void VulkanTexture2D::createTextureFromKTX(VkQueue transferQueue, VkCommandPool
     descriptor.imageLayout = imageLayout;
 }
 
-void VulkanTexture2D::createTextureFromglTF(VkQueue transferQueue, VkCommandPool transferCommandPool, tinygltf::Image& glTFImage)
+void VulkanTexture2D::createTextureFromglTF(UploadManager& uploadManager, tinygltf::Image& glTFImage, VmaPool vmaPool)
 {
     this->width = glTFImage.width;
     this->height = glTFImage.height;
     this->layerCount = 1;
     this->mipLevels = 1;
 
-    byte* buffer = nullptr;
-    size_t bufferSize = 0;
-    bool deleteBuffer = false;
-    // RGB to RGBA
-    if (glTFImage.component == 3) {
-        // Most devices don't support RGB only on Vulkan so convert if necessary
-        // TODO: Check actual format support and transform only if required
-        bufferSize = glTFImage.width * glTFImage.height * 4;
-        buffer = new byte[bufferSize];
-        byte* rgba = buffer;
-        byte* rgb = &glTFImage.image[0];
-        for (int i = 0; i < glTFImage.width * glTFImage.height; ++i) {
-            for (int32_t j = 0; j < 3; ++j) {
-                rgba[j] = rgb[j];
-            }
-            rgba += 4;
-            rgb += 3;
-        }
-        deleteBuffer = true;
+    if (glTFImage.bits != 8) {
+        throw MakeErrorInfo("glTF: only 8 bits per channel images are supported!");
     }
-    else {
-        buffer = &glTFImage.image[0];
-        bufferSize = glTFImage.image.size();
+    size_t pixelCount = (size_t)glTFImage.width * glTFImage.height;
+
+    // Uploaded as is if the device can sample and filter the RGB format and generate its mip levels
+    bool rgbSupported =
+        isFormatSupported(VK_FORMAT_R8G8B8_UNORM) &&
+        uploadManager.getMipmapMethod(VK_FORMAT_R8G8B8_UNORM) != MipmapGenerator::Method::None;
+    if (glTFImage.component == 3 && rgbSupported) {
+        textureFormat = VK_FORMAT_R8G8B8_UNORM;
+        createTextureFromMemory(uploadManager, glTFImage.image.data(), width, height, VK_FILTER_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, vmaPool);
+        return;
+    }
+
+    // Otherwise converted to RGBA right into the staging memory
+    textureFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    UploadManager::StagingAllocation staging = uploadManager.allocateStaging(pixelCount * 4);
+    uint8_t* rgba = static_cast<uint8_t*>(staging.data);
+    switch (glTFImage.component) {
+    case 1:
+        pixelConversion::grayToRgba(glTFImage.image.data(), rgba, pixelCount);
+        break;
+    case 2:
+        pixelConversion::grayAlphaToRgba(glTFImage.image.data(), rgba, pixelCount);
+        break;
+    case 3:
+        pixelConversion::rgbToRgba(glTFImage.image.data(), rgba, pixelCount);
+        break;
+    default:
+        memcpy(rgba, glTFImage.image.data(), pixelCount * 4);
+        break;
     }
+    createTextureFromStaging(uploadManager, staging, width, height, VK_FILTER_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, vmaPool, true);
+}
 
-    uint32_t imageSize = bufferSize;
-    byte* imageData = buffer;
+uint32_t VulkanTexture2D::getTexelSize(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_R8G8B8_UNORM:
+    case VK_FORMAT_R8G8B8_SRGB:
+        return 3;
+    default:
+        return 4;
+    }
+}
 
-    this->createTextureFromMemory(transferQueue, transferCommandPool, imageData, width, height);
+bool VulkanTexture2D::isFormatSupported(VkFormat format) const
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(vulkanDevice->physicalDevice, format, &formatProperties);
+    const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
 }
@@ -4,9 +4,12 @@
 #include "VulkanDevice.h"
 #include "VulkanTools.h"
 #include "VulkanBuffer.h"
+#include "UploadManager.h"
+#include "PixelConversion.h"
 #include "vk_mem_alloc.h"
 #define KHRONOS_STATIC
 #include <ktx.h>
+#include <ktxvulkan.h>
 
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #include "tiny_gltf.h"
@@ -24,6 +27,9 @@ public:
     uint32_t                layerCount = 1;
     uint32_t                facesCount = 1;
     VkFormat                textureFormat = VK_FORMAT_R8G8B8A8_UNORM; // 4 channels (RGBA) with unnormalized 8-bit values, this is the most commonly supported format
+    // Usage and flags the image was created with
+    VkImageUsageFlags       imageUsage = 0;
+    VkImageCreateFlags      imageFlags = 0;
     VkDescriptorImageInfo   descriptor{};
     VkSampler               sampler = VK_NULL_HANDLE;
 
@@ -32,6 +38,14 @@ public:
     VmaAllocationInfo       vmaImageAllocationInfo{};
 public:
     void updateDescriptor();
+    // Usage of the views of textureFormat, the image usage without the storage usage only the views of other formats
+    // have(VK_IMAGE_CREATE_EXTENDED_USAGE_BIT, see MipmapGenerator::getRequiredFlags())
+    VkImageUsageFlags getViewUsage() const;
+
+    // Creates image and its device local allocation, from vmaPool if it isn't nullptr
+    // The memory type of a pool is chosen by a typical texture(see MemoryPools), the format, tiling or usage of the image
+    // may not allow it, then the image is allocated from the default pools
+    void createImage(const VkImageCreateInfo& imageCreateInfo, VmaPool vmaPool = nullptr);
 
     void destroy();
 };
@@ -46,36 +60,86 @@ public:
     // Set the device and allocator if they were not specified in the constructor
     void setDeviceAndAllocator(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator);
 
-    // Load image data from byte array(Raw data of RGBA image!)
+    // The upload is recorded into the current batch of uploadManager, the texture can be used
+    // by the commands submitted to the upload queue after uploadManager.flush()
+    // The image is allocated from vmaPool if it isn't nullptr(see MemoryPools)
+
+    // Load image data from byte array(Raw data of RGBA image, or RGB if textureFormat is a 3 byte format!)
     // Create VkImage, VkImageView and VkSampler for texture
+    // generateMipmaps - the full mip chain is generated on the GPU from the image data(if the format allows it, see MipmapGenerator)
     void createTextureFromMemory(
-        VkQueue transferQueue,
-        VkCommandPool transferCommandPool,
+        UploadManager& uploadManager,
         unsigned char* imageData,
         uint32_t width,
         uint32_t height,
         VkFilter filter = VK_FILTER_LINEAR,
         VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
-        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VmaPool vmaPool = nullptr,
+        bool generateMipmaps = true
     );
 
-    // Load image data from KTX texture file
-    // Create VkImage, VkImageView and VkSampler for texture
+    // Load image data from KTX(KTX1 or KTX2) texture file
+    // Create VkImage, VkImageView and VkSampler for texture, the image format is taken from the file
     void createTextureFromKTX(
-        VkQueue transferQueue,
-        VkCommandPool transferCommandPool,
+        UploadManager& uploadManager,
         std::string filePath,
         VkFilter filter = VK_FILTER_LINEAR,
         VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
-        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VmaPool vmaPool = nullptr
+    );
+
+    // Create VkImage, VkImageView and VkSampler for texture from already loaded KTX texture data
+    // The ktxTexture is not destroyed, its data is copied to the staging memory
+    // Basis Universal textures are transcoded first if it hasn't been done by loadKTXFile()
+    // baseLevel - the levels of the file from it are uploaded, level baseLevel becomes level 0 of the image(see TextureStreamer)
+    void createTextureFromKTX(
+        UploadManager& uploadManager,
+        ktxTexture* ktxTexture,
+        VkFilter filter = VK_FILTER_LINEAR,
+        VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VmaPool vmaPool = nullptr,
+        uint32_t baseLevel = 0
     );
 
+    // Load KTX texture file, doesn't use Vulkan so can be called from any thread
+    // If vulkanDevice isn't nullptr Basis Universal KTX2 textures are transcoded for it(see transcodeKTX())
+    // The caller destroys the returned texture with ktxTexture_Destroy()
+    static ktxTexture* loadKTXFile(std::string filePath, const VulkanDevice* vulkanDevice = nullptr);
+
+    // Transcodes a Basis Universal(ETC1S or UASTC) KTX2 texture in place, other textures are not changed
+    // The block format is chosen by the texture compression features enabled on the device:
+    // UASTC - ASTC 4x4, BC7, ETC2, ETC1S - ETC2, BC7, ASTC 4x4, RGBA8 if none of them is enabled
+    static void transcodeKTX(ktxTexture* ktxTexture, const VulkanDevice* vulkanDevice);
+
     // Load image data from glTF file
-    // Create VkImage, VkImageView and VkSampler for texture
+    // Create VkImage, VkImageView and VkSampler for texture, the mip chain is generated on the GPU
+    // RGB images are uploaded as is if the device supports R8G8B8_UNORM(with the mipmap generation), otherwise they(and gray images)
+    // are expanded to RGBA by pixelConversion right into the staging memory
     void createTextureFromglTF(
-        VkQueue transferQueue,
-        VkCommandPool transferCommandPool,
-        tinygltf::Image& glTFImage
+        UploadManager& uploadManager,
+        tinygltf::Image& glTFImage,
+        VmaPool vmaPool = nullptr
+    );
+
+private:
+    // Creates the texture from the image data already written to the staging memory
+    void createTextureFromStaging(
+        UploadManager& uploadManager,
+        const UploadManager::StagingAllocation& staging,
+        uint32_t width,
+        uint32_t height,
+        VkFilter filter,
+        VkImageUsageFlags imageUsageFlags,
+        VkImageLayout imageLayout,
+        VmaPool vmaPool,
+        bool generateMipmaps
     );
+    // Bytes per texel of the uncompressed formats createTextureFromMemory() accepts
+    static uint32_t getTexelSize(VkFormat format);
+    // Optimal tiling image of the format can be sampled with linear filter
+    bool isFormatSupported(VkFormat format) const;
 };
 
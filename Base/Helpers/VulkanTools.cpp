@@ -320,7 +320,7 @@ VkShaderModule vulkanTools::loadShader(VkDevice device, std::string fileName)
     moduleCreateInfo.codeSize = size;
     moduleCreateInfo.pCode = (uint32_t*)shaderCode;
 
-    VK_CHECK_RESULT(vkCreateShaderModule(device, &moduleCreateInfo, NULL, &shaderModule));
+    VK_CHECK_RESULT(vkCreateShaderModule(device, &moduleCreateInfo, getHostAllocationCallbacks(), &shaderModule));
 
     delete[] shaderCode;
 
@@ -23,6 +23,7 @@
 #include <Windows.h>
 #include "vulkan/vulkan.h"
 #include "VulkanInitializers.hpp"
+#include "HostAllocationTracker.h"
 #include "../ErrorInfo/ErrorInfo.h"
 
 // Custom define for better code readability
@@ -11,22 +11,54 @@
 uint32_t vulkanglTF::descriptorBindingFlags = vulkanglTF::DescriptorBindingFlags::ImageBaseColor;
 VkDescriptorSetLayout vulkanglTF::descriptorSetLayoutImage = VK_NULL_HANDLE;
 
-vulkanglTF::Model::Model(VulkanDevice* vulkanDevice, VkQueue transferQueue, VkCommandPool transferCommandPool, VmaAllocator vmaAllocator)
+void vulkanglTF::createDescriptorSetLayoutImage(VkDevice device)
+{
+    // Layout is global, so only create if it hasn't already been created before
+    if (descriptorSetLayoutImage != VK_NULL_HANDLE) {
+        return;
+    }
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+    if (descriptorBindingFlags & DescriptorBindingFlags::ImageBaseColor) {
+        setLayoutBindings.push_back(vulkanInitializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, static_cast<uint32_t>(setLayoutBindings.size())));
+    }
+    if (descriptorBindingFlags & DescriptorBindingFlags::ImageNormalMap) {
+        setLayoutBindings.push_back(vulkanInitializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, static_cast<uint32_t>(setLayoutBindings.size())));
+    }
+    VkDescriptorSetLayoutCreateInfo descriptorLayoutCreateInfo{};
+    descriptorLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorLayoutCreateInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+    descriptorLayoutCreateInfo.pBindings = setLayoutBindings.data();
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorLayoutCreateInfo, getHostAllocationCallbacks(), &descriptorSetLayoutImage));
+}
+
+vulkanglTF::Model::Model(VulkanDevice* vulkanDevice, UploadManager* uploadManager, VmaAllocator vmaAllocator)
 {
     this->vulkanDevice = vulkanDevice;
-    this->transferQueue = transferQueue;
-    this->transferCommandPool = transferCommandPool;
+    this->uploadManager = uploadManager;
     this->vmaAllocator = vmaAllocator;
 }
 
 vulkanglTF::Model::~Model()
 {
+    if (defragmenter) {
+        for (auto& texture : textures) {
+            defragmenter->unregisterTexture(&texture);
+        }
+        if (vertexBuffer.vulkanBuffer) {
+            defragmenter->unregisterBuffer(vertexBuffer.vulkanBuffer);
+        }
+        if (indexBuffer.vulkanBuffer) {
+            defragmenter->unregisterBuffer(indexBuffer.vulkanBuffer);
+        }
+    }
+
     if (descriptorSetLayoutImage) {
-        vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayoutImage, nullptr);
+        vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayoutImage, getHostAllocationCallbacks());
+        descriptorSetLayoutImage = VK_NULL_HANDLE;
     }
 
     if (descriptorPool) {
-        vkDestroyDescriptorPool(vulkanDevice->logicalDevice, descriptorPool, nullptr);
+        vkDestroyDescriptorPool(vulkanDevice->logicalDevice, descriptorPool, getHostAllocationCallbacks());
     }
 
     for (auto texture : textures) {
@@ -39,6 +71,8 @@ vulkanglTF::Model::~Model()
         delete node;
     }
 
+    uniformArena.destroy();
+
     if (vertexBuffer.vulkanBuffer) {
         vertexBuffer.vulkanBuffer->destroy();
         delete vertexBuffer.vulkanBuffer;
@@ -50,37 +84,31 @@ vulkanglTF::Model::~Model()
     }
 }
 
-void vulkanglTF::Model::loadImages(tinygltf::Model& gltfModel, VulkanDevice* device, VkQueue transferQueue)
+void vulkanglTF::Model::loadImages(tinygltf::Model& gltfModel)
 {
+    // The copies of all images are recorded into one upload batch
     for (tinygltf::Image& image : gltfModel.images) {
         VulkanTexture2D texture(vulkanDevice, vmaAllocator);
-        texture.createTextureFromglTF(transferQueue, transferCommandPool, image);
+        texture.createTextureFromglTF(*uploadManager, image, getPool(MemoryPools::Category::Textures));
         textures.push_back(texture);
     }
     // Create an empty texture to be used for empty material images
-    createEmptyTexture(transferQueue);
+    createEmptyTexture();
 }
 
-vulkanglTF::Mesh::Mesh(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, glm::mat4 matrix) {
+vulkanglTF::Mesh::Mesh(VulkanDevice* vulkanDevice, BufferArena& uniformArena, glm::mat4 matrix) {
     this->vulkanDevice = vulkanDevice;
-    this->vmaAllocator = vmaAllocator;
     this->uniformBlock.matrix = matrix;
 
-    this->uniformBuffer.vulkanBuffer = new VulkanBuffer(vulkanDevice, vmaAllocator);
-    this->uniformBuffer.vulkanBuffer->createBuffer(
-        sizeof(uniformBlock),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
-    );
+    this->uniformBuffer.allocation = uniformArena.allocate(sizeof(uniformBlock));
+    this->uniformBuffer.descriptor = this->uniformBuffer.allocation.getDescriptor();
 };
 
 vulkanglTF::Mesh::~Mesh() {
+    // The uniform buffer range is freed with the model's arena
     for (auto& primitive : primitives) {
         delete primitive;
     }
-    vmaDestroyBuffer(vmaAllocator, uniformBuffer.vulkanBuffer->buffer, uniformBuffer.vulkanBuffer->vmaAllocation);
-    delete uniformBuffer.vulkanBuffer;
 }
 
 void vulkanglTF::Material::createDescriptorSet(VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, uint32_t descriptorBindingFlags)
@@ -91,6 +119,11 @@ void vulkanglTF::Material::createDescriptorSet(VkDescriptorPool descriptorPool,
     descriptorSetAllocInfo.pSetLayouts = &descriptorSetLayout;
     descriptorSetAllocInfo.descriptorSetCount = 1;
     VK_CHECK_RESULT(vkAllocateDescriptorSets(vulkanDevice->logicalDevice, &descriptorSetAllocInfo, &descriptorSet));
+    updateDescriptorSet(descriptorBindingFlags);
+}
+
+void vulkanglTF::Material::updateDescriptorSet(uint32_t descriptorBindingFlags)
+{
     std::vector<VkDescriptorImageInfo> imageDescriptors{};
     std::vector<VkWriteDescriptorSet> writeDescriptorSets{};
     if (descriptorBindingFlags & DescriptorBindingFlags::ImageBaseColor) {
@@ -138,10 +171,7 @@ void vulkanglTF::Node::update()
 {
     if (mesh) {
         glm::mat4 m = getMatrix();
-        void* mappedBuffer;
-        mesh->uniformBuffer.vulkanBuffer->map(&mappedBuffer);
-        memcpy(mappedBuffer, &m, sizeof(glm::mat4));
-        mesh->uniformBuffer.vulkanBuffer->unmap();
+        memcpy(mesh->uniformBuffer.allocation.data, &m, sizeof(glm::mat4));
     }
 
     for (auto& child : children) {
@@ -159,6 +189,11 @@ vulkanglTF::Node::~Node()
     }
 }
 
+VmaPool vulkanglTF::Model::getPool(MemoryPools::Category category) const
+{
+    return memoryPools ? memoryPools->getPool(category) : nullptr;
+}
+
 VulkanTexture2D* vulkanglTF::Model::getTexture(uint32_t index)
 {
     if (index >= textures.size()) {
@@ -167,7 +202,7 @@ VulkanTexture2D* vulkanglTF::Model::getTexture(uint32_t index)
     return &textures[index];
 }
 
-void vulkanglTF::Model::createEmptyTexture(VkQueue transferQueue)
+void vulkanglTF::Model::createEmptyTexture()
 {
     emptyTexture.vulkanDevice = vulkanDevice;
     emptyTexture.vmaAllocator = vmaAllocator;
@@ -177,20 +212,6 @@ void vulkanglTF::Model::createEmptyTexture(VkQueue transferQueue)
     emptyTexture.mipLevels = 1;
 
     uint32_t imageSize = emptyTexture.width * emptyTexture.height * 4;
-    unsigned char* imageData = new byte[imageSize];
-    memset(imageData, 0, imageSize);
-
-    // Create staging buffer
-    VulkanBuffer stagingBuffer(vulkanDevice, vmaAllocator);
-    stagingBuffer.createBuffer(
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-        imageData,
-        imageSize
-    );
 
     // Create image
     VkImageCreateInfo imageCreateInfo{};
@@ -206,17 +227,9 @@ void vulkanglTF::Model::createEmptyTexture(VkQueue transferQueue)
     imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    VmaAllocationCreateInfo imageAllocationCreateInfo{};
-    imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    imageAllocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-    if (vmaCreateImage(vmaAllocator, &imageCreateInfo, &imageAllocationCreateInfo, &emptyTexture.image, &emptyTexture.vmaImageAllocation, &emptyTexture.vmaImageAllocationInfo) != VK_SUCCESS) {
-        throw MakeErrorInfo("Failed to create image!");
-    }
-
-    // Copy image data from buffer to image
-    VkCommandBuffer commandBuffer = vulkanDevice->beginSingleTimeCommands(transferCommandPool);
+    emptyTexture.createImage(imageCreateInfo, getPool(MemoryPools::Category::Textures));
 
+    // Copy image data to the staging ring and record the copy to image
     VkImageSubresourceRange subresourceRange = {};
     subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     subresourceRange.baseMipLevel = 0;
@@ -224,61 +237,25 @@ void vulkanglTF::Model::createEmptyTexture(VkQueue transferQueue)
     subresourceRange.baseArrayLayer = 0;
     subresourceRange.layerCount = 1;
 
-    // Transition the texture image layout to transfer target, so we can safely copy our buffer data to it
-    vulkanTools::insertImageMemoryBarrier(
-        commandBuffer,
-        emptyTexture.image,
-        0, // srcAccessMask - We do not perform any operations before memory barrier
-        VK_ACCESS_TRANSFER_WRITE_BIT, // dstAccessMask - We write after memory barrier
-        VK_IMAGE_LAYOUT_UNDEFINED, // oldImageLayout
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // newImageLayout
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // srcStageMask - We don't wait anything before the barrier
-        VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask - Stages in which we make transfer operations should wait a barrier
-        subresourceRange
-    );
-
-    // Copy buffer to image
     // Setup buffer copy regions without mip levels and layers
-    VkBufferImageCopy bufferCopyRegion{};
-    bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    bufferCopyRegion.imageSubresource.mipLevel = 0;
-    bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-    bufferCopyRegion.imageSubresource.layerCount = 1;
-    bufferCopyRegion.imageExtent.width = emptyTexture.width;
-    bufferCopyRegion.imageExtent.height = emptyTexture.height;
-    bufferCopyRegion.imageExtent.depth = 1;
-    bufferCopyRegion.bufferOffset = 0;
-
-    // Copy image from staging buffer
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        stagingBuffer.buffer,
-        emptyTexture.image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &bufferCopyRegion
-    );
-
-    // Change image layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL after transfer
-    vulkanTools::insertImageMemoryBarrier(
-        commandBuffer,
-        emptyTexture.image,
-        VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask - We write the data to the image
-        VK_ACCESS_SHADER_READ_BIT, // dstAccessMask - The shader reads data from the image
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, // newImageLayout
-        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask - We have to wait for the transfer operation that loads the image
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, // dstStageMask - The shader should read the data only after it is loaded to image
-        subresourceRange
-    );
+    std::vector<VkBufferImageCopy> bufferCopyRegions(1);
+    bufferCopyRegions[0].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    bufferCopyRegions[0].imageSubresource.mipLevel = 0;
+    bufferCopyRegions[0].imageSubresource.baseArrayLayer = 0;
+    bufferCopyRegions[0].imageSubresource.layerCount = 1;
+    bufferCopyRegions[0].imageExtent.width = emptyTexture.width;
+    bufferCopyRegions[0].imageExtent.height = emptyTexture.height;
+    bufferCopyRegions[0].imageExtent.depth = 1;
+    bufferCopyRegions[0].bufferOffset = 0;
+
+    // The texture is black, the staging memory is written directly
+    UploadManager::StagingAllocation staging = uploadManager->allocateStaging(imageSize);
+    memset(staging.data, 0, imageSize);
+    uploadManager->copyToImage(staging, emptyTexture.image, bufferCopyRegions, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
     // Store current layout for later reuse
     emptyTexture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    vulkanDevice->endSingleTimeCommands(commandBuffer, transferQueue, transferCommandPool);
-    // Destroy staging buffer
-    stagingBuffer.destroy();
-
     // Create image view
     VkImageViewCreateInfo imageViewCreateInfo{};
     imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -292,7 +269,7 @@ void vulkanglTF::Model::createEmptyTexture(VkQueue transferQueue)
     imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
     imageViewCreateInfo.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &emptyTexture.imageView) != VK_SUCCESS) {
+    if (vkCreateImageView(vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &emptyTexture.imageView) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create image view!");
     }
 
@@ -312,7 +289,7 @@ void vulkanglTF::Model::createEmptyTexture(VkQueue transferQueue)
     samplerCreateInfo.anisotropyEnable = VK_FALSE;
     samplerCreateInfo.maxAnisotropy = 1.0f;
 
-    if (vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, nullptr, &emptyTexture.sampler) != VK_SUCCESS) {
+    if (vkCreateSampler(vulkanDevice->logicalDevice, &samplerCreateInfo, getHostAllocationCallbacks(), &emptyTexture.sampler) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create sampler!");
     }
 }
@@ -405,7 +382,7 @@ void vulkanglTF::Model::loadNode(Node* parent, const tinygltf::Node& node, uint3
     // Node contains mesh data
     if (node.mesh > -1) {
         const tinygltf::Mesh mesh = model.meshes[node.mesh];
-        Mesh* newMesh = new Mesh(vulkanDevice, vmaAllocator, newNode->matrix);
+        Mesh* newMesh = new Mesh(vulkanDevice, uniformArena, newNode->matrix);
         newMesh->name = mesh.name;
         for (size_t j = 0; j < mesh.primitives.size(); j++) {
             const tinygltf::Primitive& primitive = mesh.primitives[j];
@@ -566,10 +543,47 @@ void vulkanglTF::Model::loadNode(Node* parent, const tinygltf::Node& node, uint3
     linearNodes.push_back(newNode);
 }
 
-void vulkanglTF::Model::loadFromFile(std::string filePath, uint32_t fileLoadingFlags, VkQueue transferQueue, VkCommandPool transferCommandPool, float globalScale)
+namespace
+{
+    // Image loader of the parser, keeps the encoded bytes instead of decoding them
+    // The bytes of embedded and external images don't outlive the call, so they are copied
+    bool deferImageLoading(tinygltf::Image* image, const int imageIndex, std::string* error, std::string* warning, int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData)
+    {
+        std::vector<vulkanglTF::EncodedImage>* encodedImages = static_cast<std::vector<vulkanglTF::EncodedImage>*>(userData);
+        vulkanglTF::EncodedImage encodedImage;
+        encodedImage.imageIndex = imageIndex;
+        encodedImage.requiredWidth = requiredWidth;
+        encodedImage.requiredHeight = requiredHeight;
+        encodedImage.data.assign(bytes, bytes + size);
+        encodedImages->push_back(std::move(encodedImage));
+        return true;
+    }
+}
+
+void vulkanglTF::Model::loadglTFFile(std::string filePath, tinygltf::Model& gltfModel, JobSystem* jobSystem)
+{
+    std::vector<EncodedImage> encodedImages;
+    parseglTFFile(filePath, gltfModel, encodedImages);
+
+    if (jobSystem) {
+        // One image per job, the decoding time depends on the image size a lot
+        jobSystem->parallelFor(static_cast<uint32_t>(encodedImages.size()), 1, [&](uint32_t first, uint32_t end, uint32_t) {
+            for (uint32_t i = first; i < end; i++) {
+                decodeImage(gltfModel, encodedImages[i]);
+            }
+        });
+    }
+    else {
+        for (EncodedImage& encodedImage : encodedImages) {
+            decodeImage(gltfModel, encodedImage);
+        }
+    }
+}
+
+void vulkanglTF::Model::parseglTFFile(std::string filePath, tinygltf::Model& gltfModel, std::vector<EncodedImage>& encodedImages)
 {
-    tinygltf::Model gltfModel;
     tinygltf::TinyGLTF gltfLoader;
+    gltfLoader.SetImageLoader(deferImageLoading, &encodedImages);
 
     std::string error, warning;
     bool fileLoaded = gltfLoader.LoadASCIIFromFile(&gltfModel, &error, &warning, filePath);
@@ -578,16 +592,74 @@ void vulkanglTF::Model::loadFromFile(std::string filePath, uint32_t fileLoadingF
         throw MakeErrorInfo("glTF: Failed to load model from file!\n"
                             "Error:" + error);
     }
+}
+
+void vulkanglTF::Model::decodeImage(tinygltf::Model& gltfModel, EncodedImage& encodedImage)
+{
+    tinygltf::Image& image = gltfModel.images[encodedImage.imageIndex];
+    // Images keep their channel count, RGB images are converted(if at all) by VulkanTexture2D::createTextureFromglTF()
+    tinygltf::LoadImageDataOption option;
+    option.preserve_channels = true;
+
+    std::string error, warning;
+    bool imageLoaded = tinygltf::LoadImageData(
+        &image,
+        encodedImage.imageIndex,
+        &error,
+        &warning,
+        encodedImage.requiredWidth,
+        encodedImage.requiredHeight,
+        encodedImage.data.data(),
+        static_cast<int>(encodedImage.data.size()),
+        &option
+    );
+    encodedImage.data = std::vector<unsigned char>();
+
+    if (!imageLoaded) {
+        throw MakeErrorInfo("glTF: Failed to decode image!\n"
+                            "Error:" + error);
+    }
+}
+
+void vulkanglTF::Model::loadFromFile(std::string filePath, uint32_t fileLoadingFlags, float globalScale)
+{
+    tinygltf::Model gltfModel;
+    loadglTFFile(filePath, gltfModel, jobSystem);
+    loadFromglTFModel(gltfModel, fileLoadingFlags, globalScale);
+    uploadManager->flush();
+}
 
+void vulkanglTF::Model::loadFromglTFModel(tinygltf::Model& gltfModel, uint32_t fileLoadingFlags, float globalScale)
+{
     if (!(fileLoadingFlags & FileLoadingFlags::DontLoadImages)) {
-        loadImages(gltfModel, vulkanDevice, transferQueue);
+        loadImages(gltfModel);
     }
     loadMaterials(gltfModel);
+    // One block for the uniform buffers of all meshes
+    uint32_t meshNodeCount = 0;
+    for (const tinygltf::Node& node : gltfModel.nodes) {
+        if (node.mesh > -1) {
+            meshNodeCount++;
+        }
+    }
+    VkDeviceSize uniformAlignment = vulkanDevice->properties.limits.minUniformBufferOffsetAlignment;
+    VkDeviceSize alignedUniformBlockSize = (sizeof(Mesh::UniformBlock) + uniformAlignment - 1) & ~(uniformAlignment - 1);
+    uniformArena.init(
+        vulkanDevice,
+        vmaAllocator,
+        alignedUniformBlockSize * (meshNodeCount > 0 ? meshNodeCount : 1),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+    );
     const tinygltf::Scene& scene = gltfModel.scenes[0];
     for (size_t i = 0; i < scene.nodes.size(); i++) {
         const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
         loadNode(nullptr, node, scene.nodes[i], gltfModel, indexes, vertexes, globalScale);
     }
+    for (auto node : nodes) {
+        addNodeToDrawList(node);
+    }
 
     for (auto node : linearNodes) {
         // Initial pose
@@ -649,62 +721,23 @@ void vulkanglTF::Model::loadFromFile(std::string filePath, uint32_t fileLoadingF
     indexBuffer.count = static_cast<uint32_t>(indexes.size());
     vertexBuffer.vulkanBuffer = new VulkanBuffer(vulkanDevice, vmaAllocator);
     indexBuffer.vulkanBuffer = new VulkanBuffer(vulkanDevice, vmaAllocator);
-    vertexBuffer.vulkanBuffer->createBuffer(
-        vertexBufferSize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-    );
-    indexBuffer.vulkanBuffer->createBuffer(
-        indexBufferSize,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-    );
-
-    // Create staging buffers
-    VulkanBuffer vertexStaging(vulkanDevice, vmaAllocator);
-    VulkanBuffer indexStaging(vulkanDevice, vmaAllocator);
-    vertexStaging.createBuffer(
+    // Written directly if the device local memory is host visible(resizable BAR, UMA), otherwise copied through the staging ring
+    // The whole model(images, vertices and indices) is submitted in one batch
+    vertexBuffer.vulkanBuffer->createStaticBuffer(
+        *uploadManager,
         vertexBufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         vertexes.data(),
-        vertexBufferSize
+        getPool(MemoryPools::Category::StaticGeometry)
     );
-    indexStaging.createBuffer(
+    indexBuffer.vulkanBuffer->createStaticBuffer(
+        *uploadManager,
         indexBufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         indexes.data(),
-        indexBufferSize
-    );
-
-    // Copy data from staging buffer to GPU memory
-    VkCommandBuffer copyCommandBuffer = vulkanDevice->beginSingleTimeCommands(transferCommandPool);
-    VkBufferCopy copyRegion{};
-    copyRegion.size = vertexBufferSize;
-    vkCmdCopyBuffer(
-        copyCommandBuffer,
-        vertexStaging.buffer,
-        vertexBuffer.vulkanBuffer->buffer,
-        1,
-        &copyRegion
-    );
-
-    copyRegion.size = indexBufferSize;
-    vkCmdCopyBuffer(
-        copyCommandBuffer,
-        indexStaging.buffer,
-        indexBuffer.vulkanBuffer->buffer,
-        1,
-        &copyRegion
+        getPool(MemoryPools::Category::StaticGeometry)
     );
 
-    vulkanDevice->endSingleTimeCommands(copyCommandBuffer, transferQueue, transferCommandPool);
-    vertexStaging.destroy();
-    indexStaging.destroy();
-
     // Setup descriptors
     uint32_t uboCount{ 0 };
     uint32_t imageCount{ 0 };
@@ -734,27 +767,13 @@ void vulkanglTF::Model::loadFromFile(std::string filePath, uint32_t fileLoadingF
     descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
     descriptorPoolCreateInfo.maxSets = uboCount + imageCount;
-    if (vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+    if (vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &descriptorPool) != VK_SUCCESS) {
         throw MakeErrorInfo("Failed to create command pool!");
     }
 
     // Descriptors for per-material images
     {
-        // Layout is global, so only create if it hasn't already been created before
-        if (descriptorSetLayoutImage == VK_NULL_HANDLE) {
-            std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
-            if (descriptorBindingFlags & DescriptorBindingFlags::ImageBaseColor) {
-                setLayoutBindings.push_back(vulkanInitializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, static_cast<uint32_t>(setLayoutBindings.size())));
-            }
-            if (descriptorBindingFlags & DescriptorBindingFlags::ImageNormalMap) {
-                setLayoutBindings.push_back(vulkanInitializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, static_cast<uint32_t>(setLayoutBindings.size())));
-            }
-            VkDescriptorSetLayoutCreateInfo descriptorLayoutCreateInfo{};
-            descriptorLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            descriptorLayoutCreateInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
-            descriptorLayoutCreateInfo.pBindings = setLayoutBindings.data();
-            VK_CHECK_RESULT(vkCreateDescriptorSetLayout(vulkanDevice->logicalDevice, &descriptorLayoutCreateInfo, nullptr, &descriptorSetLayoutImage));
-        }
+        createDescriptorSetLayoutImage(vulkanDevice->logicalDevice);
         for (auto& material : materials) {
             if (material.baseColorTexture != nullptr) {
                 material.createDescriptorSet(descriptorPool, descriptorSetLayoutImage, descriptorBindingFlags);
@@ -818,6 +837,27 @@ VkPipelineVertexInputStateCreateInfo* vulkanglTF::Vertex::getPipelineVertexInput
     return &pipelineVertexInputStateCreateInfo;
 }
 
+void vulkanglTF::Model::registerForDefragmentation(Defragmenter& defragmenter)
+{
+    this->defragmenter = &defragmenter;
+    for (auto& texture : textures) {
+        VulkanTexture2D* movedTexture = &texture;
+        defragmenter.registerTexture(movedTexture, [this, movedTexture]() {
+            for (auto& material : materials) {
+                if (material.descriptorSet == VK_NULL_HANDLE) {
+                    continue;
+                }
+                if (material.baseColorTexture == movedTexture || material.normalTexture == movedTexture) {
+                    material.updateDescriptorSet(descriptorBindingFlags);
+                }
+            }
+        });
+    }
+    // Vertex and index buffers are bound at recording time, nothing to rewrite
+    defragmenter.registerBuffer(vertexBuffer.vulkanBuffer);
+    defragmenter.registerBuffer(indexBuffer.vulkanBuffer);
+}
+
 void vulkanglTF::Model::bindBuffers(VkCommandBuffer commandBuffer)
 {
     const VkDeviceSize offsets[1] = { 0 };
@@ -826,27 +866,44 @@ void vulkanglTF::Model::bindBuffers(VkCommandBuffer commandBuffer)
     buffersBound = true;
 }
 
+void vulkanglTF::Model::addNodeToDrawList(Node* node)
+{
+    if (node->mesh) {
+        for (Primitive* primitive : node->mesh->primitives) {
+            drawList.push_back(primitive);
+        }
+    }
+    for (auto& child : node->children) {
+        addNodeToDrawList(child);
+    }
+}
+
+void vulkanglTF::Model::drawPrimitive(Primitive* primitive, VkCommandBuffer commandBuffer, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet) const
+{
+    bool skip = false;
+    const vulkanglTF::Material& material = primitive->material;
+    if (renderFlags & RenderFlags::RenderOpaqueNodes) {
+        skip = (material.alphaMode != Material::ALPHAMODE_OPAQUE);
+    }
+    if (renderFlags & RenderFlags::RenderAlphaMaskedNodes) {
+        skip = (material.alphaMode != Material::ALPHAMODE_MASK);
+    }
+    if (renderFlags & RenderFlags::RenderAlphaBlendedNodes) {
+        skip = (material.alphaMode != Material::ALPHAMODE_BLEND);
+    }
+    if (!skip) {
+        if (renderFlags & RenderFlags::BindImages) {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, bindImageSet, 1, &material.descriptorSet, 0, nullptr);
+        }
+        vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+    }
+}
+
 void vulkanglTF::Model::drawNode(Node* node, VkCommandBuffer commandBuffer, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet)
 {
     if (node->mesh) {
         for (Primitive* primitive : node->mesh->primitives) {
-            bool skip = false;
-            const vulkanglTF::Material& material = primitive->material;
-            if (renderFlags & RenderFlags::RenderOpaqueNodes) {
-                skip = (material.alphaMode != Material::ALPHAMODE_OPAQUE);
-            }
-            if (renderFlags & RenderFlags::RenderAlphaMaskedNodes) {
-                skip = (material.alphaMode != Material::ALPHAMODE_MASK);
-            }
-            if (renderFlags & RenderFlags::RenderAlphaBlendedNodes) {
-                skip = (material.alphaMode != Material::ALPHAMODE_BLEND);
-            }
-            if (!skip) {
-                if (renderFlags & RenderFlags::BindImages) {
-                    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, bindImageSet, 1, &material.descriptorSet, 0, nullptr);
-                }
-                vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
-            }
+            drawPrimitive(primitive, commandBuffer, renderFlags, pipelineLayout, bindImageSet);
         }
     }
     for (auto& child : node->children) {
@@ -865,3 +922,14 @@ void vulkanglTF::Model::draw(VkCommandBuffer commandBuffer, uint32_t renderFlags
         drawNode(node, commandBuffer, renderFlags, pipelineLayout, bindImageSet);
     }
 }
+
+void vulkanglTF::Model::drawRange(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet) const
+{
+    const VkDeviceSize offsets[1] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.vulkanBuffer->buffer, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer.vulkanBuffer->buffer, 0, VK_INDEX_TYPE_UINT32);
+    uint32_t end = first + count < drawList.size() ? first + count : (uint32_t)drawList.size();
+    for (uint32_t i = first; i < end; i++) {
+        drawPrimitive(drawList[i], commandBuffer, renderFlags, pipelineLayout, bindImageSet);
+    }
+}
@@ -19,6 +19,11 @@
 #include "VulkanDevice.h"
 #include "VulkanBuffer.h"
 #include "VulkanTexture.h"
+#include "UploadManager.h"
+#include "BufferArena.h"
+#include "Defragmenter.h"
+#include "MemoryPools.h"
+#include "JobSystem.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -50,6 +55,8 @@ namespace vulkanglTF
 
     extern uint32_t descriptorBindingFlags;
     extern VkDescriptorSetLayout descriptorSetLayoutImage;
+    // Creates descriptorSetLayoutImage if it hasn't been created yet(e.g. for pipelines created before the model is loaded)
+    void createDescriptorSetLayoutImage(VkDevice device);
 
     enum class VertexComponent { Position, Normal, UV, Color, Tangent, Joint0, Weight0 };
     struct Vertex {
@@ -85,13 +92,14 @@ namespace vulkanglTF
     // Contains the node's (optional) geometry and can be made up of an arbitrary number of primitives
     struct Mesh {
         VulkanDevice* vulkanDevice;
-        VmaAllocator vmaAllocator;
 
         std::vector<Primitive*> primitives;
         std::string name;
 
+        // Range of the model's uniform buffer arena, persistently mapped
+        // descriptor.buffer is shared by the meshes, descriptor.offset can be used as a dynamic offset
         struct UniformBuffer {
-            VulkanBuffer* vulkanBuffer;
+            BufferArena::Allocation allocation;
             VkDescriptorBufferInfo descriptor;
             VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
         } uniformBuffer;
@@ -100,7 +108,7 @@ namespace vulkanglTF
             glm::mat4 matrix;
         } uniformBlock;
 
-        Mesh(VulkanDevice* vulkanDevice, VmaAllocator vmaAllocator, glm::mat4 matrix);
+        Mesh(VulkanDevice* vulkanDevice, BufferArena& uniformArena, glm::mat4 matrix);
         ~Mesh();
     };
 
@@ -126,6 +134,8 @@ namespace vulkanglTF
 
         Material(VulkanDevice* vulkanDevice) : vulkanDevice(vulkanDevice) {};
         void createDescriptorSet(VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, uint32_t descriptorBindingFlags);
+        // Writes the current descriptors of the textures to the descriptor set(e.g. after the textures were moved)
+        void updateDescriptorSet(uint32_t descriptorBindingFlags);
     };
 
     // Contains the texture for a single glTF image
@@ -136,6 +146,18 @@ namespace vulkanglTF
         VkDescriptorSet descriptorSet;
     };
 
+    // Encoded bytes of a glTF image kept by the parser, decoded later so the images of a file can be decoded in parallel
+    class EncodedImage
+    {
+    public:
+        // Index in tinygltf::Model::images
+        int imageIndex = -1;
+        // Size declared by the file, 0 if not declared
+        int requiredWidth = 0;
+        int requiredHeight = 0;
+        std::vector<unsigned char> data;
+    };
+
     // A node represents an object in the glTF scene graph
     struct Node {
         Node* parent;
@@ -158,7 +180,13 @@ namespace vulkanglTF
     private:
         VulkanTexture2D* getTexture(uint32_t index);
         VulkanTexture2D emptyTexture;
-        void createEmptyTexture(VkQueue transferQueue);
+        void createEmptyTexture();
+        void addNodeToDrawList(Node* node);
+        // The pool of the category if memoryPools is set, otherwise nullptr(default pools)
+        VmaPool getPool(MemoryPools::Category category) const;
+        // Set if the textures and buffers of the model are registered for defragmentation
+        Defragmenter* defragmenter = nullptr;
+        void drawPrimitive(Primitive* primitive, VkCommandBuffer commandBuffer, uint32_t renderFlags, VkPipelineLayout pipelineLayout, uint32_t bindImageSet) const;
     public:
         // Single vertex buffer for all primitives
         struct {
@@ -174,9 +202,17 @@ namespace vulkanglTF
     public:
         VulkanDevice* vulkanDevice = nullptr;
         VmaAllocator vmaAllocator = 0;
-        VkQueue transferQueue;
-        VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+        // Images, vertices and indices are uploaded in batches through it
+        UploadManager* uploadManager = nullptr;
+        // If set before loading, the vertex and index buffers are allocated from the static geometry pool
+        // and the images from the textures pool
+        const MemoryPools* memoryPools = nullptr;
+        // If set before loadFromFile(), the images are decoded by its workers(e.g. &BaseSample::base_jobSystem)
+        // Models loaded by a background job(AssetStreamer) leave it null, the job must not wait for other jobs
+        JobSystem* jobSystem = nullptr;
         VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        // Uniform buffers of all meshes are sub-allocated from one buffer instead of a buffer per mesh
+        BufferArena uniformArena;
 
         std::vector<Material> materials;
         std::vector<VulkanTexture2D> textures;
@@ -186,6 +222,10 @@ namespace vulkanglTF
         std::vector<Node*> nodes;
         std::vector<Node*> linearNodes;
 
+        // Primitives of all nodes in the order they are drawn by draw()
+        // Allows to split drawing into ranges recorded to different command buffers
+        std::vector<Primitive*> drawList;
+
         bool buffersBound = false;
 
         std::vector<uint32_t> indexes;
@@ -195,14 +235,33 @@ namespace vulkanglTF
         std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
         VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo;
     public:
-        Model(VulkanDevice* vulkanDevice, VkQueue transferQueue, VkCommandPool transferCommandPool, VmaAllocator vmaAllocator);
+        Model(VulkanDevice* vulkanDevice, UploadManager* uploadManager, VmaAllocator vmaAllocator);
         ~Model();
-        void loadImages(tinygltf::Model& gltfModel, VulkanDevice* device, VkQueue transferQueue);
+        void loadImages(tinygltf::Model& gltfModel);
         void loadMaterials(tinygltf::Model& gltfModel);
         void loadNode(Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model, std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, float globalScale = 1.0f);
-        void loadFromFile(std::string filePath, uint32_t fileLoadingFlags, VkQueue transferQueue, VkCommandPool transferCommandPool, float globalScale = 1.0f);
+        // All uploads of the model are submitted in one batch at the end, the model can be drawn
+        // by the commands submitted to the upload queue after it
+        // The images are decoded in parallel if jobSystem is set
+        void loadFromFile(std::string filePath, uint32_t fileLoadingFlags, float globalScale = 1.0f);
+        // Parses the file and decodes its images, doesn't use Vulkan so can be called from any thread
+        // If jobSystem is set, the images are decoded by its workers(must not be called from a background job)
+        static void loadglTFFile(std::string filePath, tinygltf::Model& gltfModel, JobSystem* jobSystem = nullptr);
+        // Parses the file without decoding the images, gltfModel.images get their names and URIs only
+        static void parseglTFFile(std::string filePath, tinygltf::Model& gltfModel, std::vector<EncodedImage>& encodedImages);
+        // Decodes the image into gltfModel.images[encodedImage.imageIndex] and frees the encoded bytes
+        // Different images can be decoded from several threads at once
+        static void decodeImage(tinygltf::Model& gltfModel, EncodedImage& encodedImage);
+        // Creates the Vulkan resources of a parsed model and records their uploads, doesn't flush the upload manager
+        void loadFromglTFModel(tinygltf::Model& gltfModel, uint32_t fileLoadingFlags, float globalScale = 1.0f);
+        // Allows the defragmenter to move the textures, vertex and index buffers of the model
+        // The material descriptor sets are rewritten when a texture is moved
+        void registerForDefragmentation(Defragmenter& defragmenter);
         void bindBuffers(VkCommandBuffer commandBuffer);
         void drawNode(Node* node, VkCommandBuffer commandBuffer, uint32_t renderFlags = 0, VkPipelineLayout pipelineLayout = VK_NULL_HANDLE, uint32_t bindImageSet = 1);
         void draw(VkCommandBuffer commandBuffer, uint32_t renderFlags = 0, VkPipelineLayout pipelineLayout = VK_NULL_HANDLE, uint32_t bindImageSet = 1);
+        // Draws drawList[first, first + count), always binds the vertex and index buffers
+        // Doesn't modify the model, so ranges can be recorded from several threads at once
+        void drawRange(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count, uint32_t renderFlags = 0, VkPipelineLayout pipelineLayout = VK_NULL_HANDLE, uint32_t bindImageSet = 1) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+
+# Runs every sample in benchmark mode(headless by default) and prints a summary
+# The results of each sample are written to <output folder>/<sample>.json
+#
+# Usage: benchmark.py <folder with sample executables> [output folder] [extra sample arguments...]
+# e.g.   benchmark.py x64/Release benchmark_results --benchmark-frames 2000 --width 1920 --height 1080
+
+import os
+import sys
+import json
+import subprocess
+
+if len(sys.argv) < 2:
+    print('Usage: benchmark.py <folder with sample executables> [output folder] [extra sample arguments...]')
+    exit()
+
+executables_path = os.path.abspath(sys.argv[1])
+output_path = os.path.abspath(sys.argv[2] if len(sys.argv) > 2 else 'benchmark_results')
+extra_args = sys.argv[3:]
+# Windowed benchmark is requested explicitly
+headless = '--windowed' not in extra_args
+extra_args = [arg for arg in extra_args if arg != '--windowed']
+
+samples_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'samples')
+samples = sorted(name for name in os.listdir(samples_path) if os.path.isdir(os.path.join(samples_path, name)))
+os.makedirs(output_path, exist_ok=True)
+
+print('{:24} | {:>9} | {:>9} | {:>9} | {:>9} | {:>9}'.format('Sample', 'avg ms', 'p99 ms', 'CPU ms', 'GPU ms', 'FPS'))
+failed = False
+for sample in samples:
+    executable = os.path.join(executables_path, sample + ('.exe' if os.name == 'nt' else ''))
+    if not os.path.isfile(executable):
+        print('{:24} | not built'.format(sample))
+        continue
+    result_file = os.path.join(output_path, sample + '.json')
+    args = [executable, '--benchmark', '--benchmark-output', result_file] + (['--headless'] if headless else []) + extra_args
+    # The sample looks for assets relative to its own folder
+    result = subprocess.run(args, cwd=executables_path, capture_output=True, text=True)
+    if result.returncode != 0 or not os.path.isfile(result_file):
+        print('{:24} | failed'.format(sample))
+        print(result.stdout)
+        print(result.stderr)
+        failed = True
+        continue
+    with open(result_file) as file:
+        results = json.load(file)
+    # Nested scopes(e.g. ImGui recorded in the Scene render pass) are already included in their parents
+    gpu_time = sum(scope['avg'] for scope in results['gpuTimeMs'].values() if scope.get('depth', 0) == 0)
+    print('{:24} | {:9.3f} | {:9.3f} | {:9.3f} | {:9.3f} | {:9.1f}'.format(
+        sample, results['frameTimeMs']['avg'], results['frameTimeMs']['p99'], results['cpuTimeMs']['avg'], gpu_time, results['averageFPS']))
+
+exit(1 if failed else 0)
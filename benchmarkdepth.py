@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+
+# Runs a sample in headless mode with a shared depth image and with per-frame depth images
+# for each number of frames in flight and prints the average frame time
+# With a shared depth image consecutive frames are serialized on the depth tests,
+# with per-frame depth images they can overlap, so the frame time should go down with more frames in flight
+#
+# Usage: benchmarkdepth.py <path to sample executable> [frames] [width] [height]
+
+import os
+import re
+import sys
+import subprocess
+
+if len(sys.argv) < 2:
+    print('Usage: benchmarkdepth.py <path to sample executable> [frames] [width] [height]')
+    exit()
+
+sample_path = os.path.abspath(sys.argv[1])
+frames = sys.argv[2] if len(sys.argv) > 2 else '2000'
+width = sys.argv[3] if len(sys.argv) > 3 else '1920'
+height = sys.argv[4] if len(sys.argv) > 4 else '1080'
+
+def run_sample(frames_in_flight, per_frame_depth):
+    args = [sample_path, '--headless', '--frames', frames, '--width', width, '--height', height, '--frames-in-flight', str(frames_in_flight)]
+    if per_frame_depth:
+        args.append('--per-frame-depth')
+    # The sample looks for assets relative to its own folder
+    result = subprocess.run(args, cwd=os.path.dirname(sample_path), capture_output=True, text=True)
+    match = re.search(r'Headless: \d+ frames in [\d.]+ ms, ([\d.]+) ms per frame, ([\d.]+) FPS', result.stdout)
+    if not match:
+        print('Error: failed to run the sample')
+        print(result.stdout)
+        print(result.stderr)
+        exit()
+    return float(match.group(1)), float(match.group(2))
+
+print('Frames in flight | Shared depth(ms / FPS) | Per-frame depth(ms / FPS)')
+for frames_in_flight in range(1, 5):
+    shared_time, shared_fps = run_sample(frames_in_flight, False)
+    per_frame_time, per_frame_fps = run_sample(frames_in_flight, True)
+    print('{:16} | {:10.3f} / {:9.1f} | {:11.3f} / {:10.1f}'.format(frames_in_flight, shared_time, shared_fps, per_frame_time, per_frame_fps))
@@ -23,7 +23,7 @@ glslc_path = vulkan_sdk_path + '\Bin\glslc.exe'
 print('Using glslc: ' + glslc_path)
 
 for file in full_file_paths:
-    match = re.search("\.vert$|\.frag$", file)
+    match = re.search("\.vert$|\.frag$|\.comp$", file)
     if match:
         print('Compiling', file)
         args = [glslc_path, '-c', file, '-o', file + '.spv']
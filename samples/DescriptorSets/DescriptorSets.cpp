@@ -22,7 +22,7 @@ class Sample : public BaseSample
         alignas(16) glm::mat4 view;
         alignas(16) glm::mat4 model;
     };
-    std::vector<VulkanBuffer>       matrixBuffers;
+    FrameResourceRing<VulkanBuffer> matrixBuffers;
 
     VkDescriptorSetLayout           descriptorSetLayout = VK_NULL_HANDLE;
 
@@ -59,21 +59,19 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, getHostAllocationCallbacks());
 
         // Descriptor pool and allocated sets
-        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, nullptr);
+        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, getHostAllocationCallbacks());
 
         // Descriptor set layouts
-        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayout, getHostAllocationCallbacks());
 
         // Buffers
-        for (uint32_t i = 0; i < matrixBuffers.size(); ++i) {
-            matrixBuffers[i].destroy();
-        }
+        matrixBuffers.destroy([](VulkanBuffer& buffer) { buffer.destroy(); });
         vertexBuffer.destroy();
     }
 
@@ -82,28 +80,21 @@ public:
         // Acquire image
         BaseSample::prepareFrame();
 
+        base_cpuProfiler.beginScope("Update");
         updateUniformBuffer(base_currentFrameIndex);
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -126,27 +117,25 @@ public:
     {
         // Vertex buffer
         vertexBuffer.setDeviceAndAllocator(base_vulkanDevice, base_vmaAllocator);
-        vertexBuffer.createBuffer(
+        // Device local, written directly with resizable BAR, otherwise through the staging copy
+        vertexBuffer.createStaticBuffer(
+            base_uploadManager,
             VkDeviceSize(sizeof(vertexes[0])) * vertexes.size(),
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-            vertexes.data(),
-            VkDeviceSize(sizeof(vertexes[0])) * vertexes.size()
+            vertexes.data()
         );
 
         // matrixes uniform buffers
-        for (uint32_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; ++i) {
-            matrixBuffers.push_back({ base_vulkanDevice, base_vmaAllocator });
-            matrixBuffers.back().createBuffer(
+        matrixBuffers.create(base_maxFramesInFlight, [&](uint32_t frameIndex) {
+            VulkanBuffer buffer(base_vulkanDevice, base_vmaAllocator);
+            // Persistently mapped, it is written every frame
+            buffer.createDynamicBuffer(
                 sizeof(matrixes),
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+                base_memoryPools.getPool(MemoryPools::Category::PerFrame)
             );
-        }
+            return buffer;
+        });
     }
 
     void createDescriptorSetLayouts()
@@ -163,7 +152,7 @@ public:
         descriptorSetLayoutCreateInfo.bindingCount = 1;
         descriptorSetLayoutCreateInfo.pBindings = &descriptorSetLayoutBinding;
 
-        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, getHostAllocationCallbacks(), &descriptorSetLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor set!");
         }
     }
@@ -173,26 +162,26 @@ public:
         // We need several descriptors to bind the buffer(one per frame)
         VkDescriptorPoolSize descriptorPoolSize{};
         descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorPoolSize.descriptorCount = BASE_MAX_FRAMES_IN_FLIGHT;
+        descriptorPoolSize.descriptorCount = base_maxFramesInFlight;
 
         VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
         descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         descriptorPoolCreateInfo.poolSizeCount = 1;
         descriptorPoolCreateInfo.pPoolSizes = &descriptorPoolSize;
         // Even one descriptor is contained in a set, so we need several sets of descriptors(one per frame)
-        descriptorPoolCreateInfo.maxSets = BASE_MAX_FRAMES_IN_FLIGHT;
+        descriptorPoolCreateInfo.maxSets = base_maxFramesInFlight;
 
-        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &descriptorPool) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor pool!");
         }
 
         // Allocate descriptor sets(one descriptor set per frame)
-        descriptorSets.resize(BASE_MAX_FRAMES_IN_FLIGHT);
-        std::vector<VkDescriptorSetLayout> setsLayouts(BASE_MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+        descriptorSets.resize(base_maxFramesInFlight);
+        std::vector<VkDescriptorSetLayout> setsLayouts(base_maxFramesInFlight, descriptorSetLayout);
         VkDescriptorSetAllocateInfo setsAllocInfo{};
         setsAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         setsAllocInfo.descriptorPool = descriptorPool;
-        setsAllocInfo.descriptorSetCount = BASE_MAX_FRAMES_IN_FLIGHT;
+        setsAllocInfo.descriptorSetCount = base_maxFramesInFlight;
         setsAllocInfo.pSetLayouts = setsLayouts.data();
 
         if (vkAllocateDescriptorSets(base_vulkanDevice->logicalDevice, &setsAllocInfo, descriptorSets.data()) != VK_SUCCESS) {
@@ -200,7 +189,7 @@ public:
         }
 
         // Write descriptors
-        for (size_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < base_maxFramesInFlight; i++) {
             VkDescriptorBufferInfo bufferDescriptorInfo{};
             bufferDescriptorInfo.buffer = matrixBuffers[i].buffer;
             bufferDescriptorInfo.offset = 0;
@@ -362,7 +351,7 @@ public:
         pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
         pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -383,7 +372,7 @@ public:
         pipelineCreateInfo.renderPass = base_renderPass;
         pipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -401,10 +390,8 @@ public:
         matrix.projection = base_camera.matrices.perspective;
         matrix.view = base_camera.matrices.view;
 
-        void* mappedBufferData = nullptr;
-        matrixBuffers[currentFrame].map(&mappedBufferData);
-        memcpy(mappedBufferData, &matrix, sizeof(matrixes));
-        matrixBuffers[currentFrame].unmap();
+        matrixBuffers[currentFrame].write(0, matrix);
+        matrixBuffers[currentFrame].flushDirtyRanges();
     }
 
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
@@ -419,7 +406,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
         std::vector<VkClearValue> clearValues(2);
@@ -428,6 +415,10 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
@@ -453,8 +444,13 @@ public:
 
         vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
+        // Draw UI over the scene
+        recordUI(commandBuffer);
+
         vkCmdEndRenderPass(commandBuffer);
 
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to record command buffer!");
         }
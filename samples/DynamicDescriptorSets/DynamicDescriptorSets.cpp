@@ -23,7 +23,7 @@ class Sample : public BaseSample
         alignas(16) glm::mat4 view;
         alignas(16) glm::mat4 model;
     };
-    std::vector<VulkanBuffer>       matrixesBuffers;
+    FrameResourceRing<VulkanBuffer> matrixesBuffers;
     VkDescriptorSetLayout           matrixesDescriptorSetLayout = VK_NULL_HANDLE;
 
     std::vector<Vertex> vertexes = {
@@ -59,21 +59,19 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, getHostAllocationCallbacks());
 
         // Descriptor pool and allocated sets
-        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, nullptr);
+        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, getHostAllocationCallbacks());
 
         // Descriptor set layouts
-        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, matrixesDescriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, matrixesDescriptorSetLayout, getHostAllocationCallbacks());
 
         // Buffers
-        for (uint32_t i = 0; i < matrixesBuffers.size(); ++i) {
-            matrixesBuffers[i].destroy();
-        }
+        matrixesBuffers.destroy([](VulkanBuffer& buffer) { buffer.destroy(); });
         vertexBuffer.destroy();
     }
 
@@ -82,28 +80,21 @@ public:
         // Acquire image
         BaseSample::prepareFrame();
 
+        base_cpuProfiler.beginScope("Update");
         updateUniformBuffer(base_currentFrameIndex);
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -137,27 +128,25 @@ public:
     {
         // Vertex buffer
         vertexBuffer.setDeviceAndAllocator(base_vulkanDevice, base_vmaAllocator);
-        vertexBuffer.createBuffer(
+        // Device local, written directly with resizable BAR, otherwise through the staging copy
+        vertexBuffer.createStaticBuffer(
+            base_uploadManager,
             VkDeviceSize(sizeof(vertexes[0])) * vertexes.size(),
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-            vertexes.data(),
-            VkDeviceSize(sizeof(vertexes[0])) * vertexes.size()
+            vertexes.data()
         );
 
         // matrixes uniform buffers
-        for (uint32_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; ++i) {
-            matrixesBuffers.push_back({ base_vulkanDevice, base_vmaAllocator });
-            matrixesBuffers.back().createBuffer(
+        matrixesBuffers.create(base_maxFramesInFlight, [&](uint32_t frameIndex) {
+            VulkanBuffer buffer(base_vulkanDevice, base_vmaAllocator);
+            // Persistently mapped, it is written every frame
+            buffer.createDynamicBuffer(
                 (VkDeviceSize)dynamicUniformBufferAllignedSize(sizeof(UBOmatrixes)) * NUMBER_OF_TRIANGLES,
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+                base_memoryPools.getPool(MemoryPools::Category::PerFrame)
             );
-        }
+            return buffer;
+        });
     }
 
     void createDescriptorSetLayouts()
@@ -174,7 +163,7 @@ public:
         descriptorSetLayoutCreateInfo.bindingCount = 1;
         descriptorSetLayoutCreateInfo.pBindings = &uboLayoutBinding;
 
-        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &matrixesDescriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, getHostAllocationCallbacks(), &matrixesDescriptorSetLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor set!");
         }
     }
@@ -184,26 +173,26 @@ public:
         // We need several descriptors to bind the buffer(one per frame)
         VkDescriptorPoolSize descriptorPoolSize{};
         descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        descriptorPoolSize.descriptorCount = BASE_MAX_FRAMES_IN_FLIGHT;
+        descriptorPoolSize.descriptorCount = base_maxFramesInFlight;
 
         VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
         descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         descriptorPoolCreateInfo.poolSizeCount = 1;
         descriptorPoolCreateInfo.pPoolSizes = &descriptorPoolSize;
         // Even one descriptor is contained in a set, so we need several sets of descriptors(one per frame)
-        descriptorPoolCreateInfo.maxSets = BASE_MAX_FRAMES_IN_FLIGHT;
+        descriptorPoolCreateInfo.maxSets = base_maxFramesInFlight;
 
-        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &descriptorPool) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor pool!");
         }
 
         // Allocate descriptor sets(one descriptor set per frame)
-        descriptorSets.resize(BASE_MAX_FRAMES_IN_FLIGHT);
-        std::vector<VkDescriptorSetLayout> setsLayouts(BASE_MAX_FRAMES_IN_FLIGHT, matrixesDescriptorSetLayout);
+        descriptorSets.resize(base_maxFramesInFlight);
+        std::vector<VkDescriptorSetLayout> setsLayouts(base_maxFramesInFlight, matrixesDescriptorSetLayout);
         VkDescriptorSetAllocateInfo setsAllocInfo{};
         setsAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         setsAllocInfo.descriptorPool = descriptorPool;
-        setsAllocInfo.descriptorSetCount = BASE_MAX_FRAMES_IN_FLIGHT;
+        setsAllocInfo.descriptorSetCount = base_maxFramesInFlight;
         setsAllocInfo.pSetLayouts = setsLayouts.data();
 
         if (vkAllocateDescriptorSets(base_vulkanDevice->logicalDevice, &setsAllocInfo, descriptorSets.data()) != VK_SUCCESS) {
@@ -211,7 +200,7 @@ public:
         }
 
         // Write descriptors
-        for (size_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < base_maxFramesInFlight; i++) {
             VkDescriptorBufferInfo bufferDescriptorInfo{};
             bufferDescriptorInfo.buffer = matrixesBuffers[i].buffer;
             bufferDescriptorInfo.offset = 0;
@@ -371,7 +360,7 @@ public:
         pipelineLayoutInfo.setLayoutCount = 1;
         pipelineLayoutInfo.pSetLayouts = &matrixesDescriptorSetLayout;
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -392,7 +381,7 @@ public:
         pipelineCreateInfo.renderPass = base_renderPass;
         pipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -429,14 +418,11 @@ public:
         transform = glm::rotate(transform, glm::radians(rotation), glm::vec3(0.0f, 0.0f, 1.0f));
         matrixes[2].model = transform;
 
-        void* mappedBufferData = nullptr;
-        matrixesBuffers[currentFrame].map(&mappedBufferData);
         for (uint32_t i = 0; i < NUMBER_OF_TRIANGLES; ++i) {
-            byte* ptr = (byte*)mappedBufferData;
-            ptr += dynamicUniformBufferAllignedSize(sizeof(UBOmatrixes)) * i;
-            memcpy((void*)ptr, &matrixes[i], sizeof(UBOmatrixes));
+            matrixesBuffers[currentFrame].write(dynamicUniformBufferAllignedSize(sizeof(UBOmatrixes)) * i, matrixes[i]);
         }
-        matrixesBuffers[currentFrame].unmap();
+        // One flush for all matrices if the memory isn't coherent
+        matrixesBuffers[currentFrame].flushDirtyRanges();
     }
 
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
@@ -451,7 +437,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
         std::vector<VkClearValue> clearValues(2);
@@ -460,6 +446,10 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
@@ -488,8 +478,13 @@ public:
             vkCmdDraw(commandBuffer, 3, 1, 0, 0);
         }
 
+        // Draw UI over the scene
+        recordUI(commandBuffer);
+
         vkCmdEndRenderPass(commandBuffer);
 
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to record command buffer!");
         }
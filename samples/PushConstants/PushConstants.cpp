@@ -71,10 +71,10 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, getHostAllocationCallbacks());
 
         // Buffers
         vertexBuffer.destroy();
@@ -85,28 +85,21 @@ public:
         // Acquire image
         BaseSample::prepareFrame();
 
+        base_cpuProfiler.beginScope("Update");
         updatePushConstants();
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -293,7 +286,7 @@ public:
         pipelineLayoutInfo.pushConstantRangeCount = pushConstantsRanges.size();
         pipelineLayoutInfo.pPushConstantRanges = pushConstantsRanges.data();
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -314,7 +307,7 @@ public:
         pipelineCreateInfo.renderPass = base_renderPass;
         pipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -362,7 +355,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
         std::vector<VkClearValue> clearValues(2);
@@ -371,6 +364,10 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
@@ -399,8 +396,13 @@ public:
             vkCmdDraw(commandBuffer, 3, 1, 0, 0);
         }
 
+        // Draw UI over the scene
+        recordUI(commandBuffer);
+
         vkCmdEndRenderPass(commandBuffer);
 
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to record command buffer!");
         }
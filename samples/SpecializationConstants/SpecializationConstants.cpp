@@ -64,11 +64,11 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, cyanGraphicsPipeline, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, pinkGraphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, cyanGraphicsPipeline, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, pinkGraphicsPipeline, getHostAllocationCallbacks());
 
         // Buffers
         vertexBuffer.destroy();
@@ -79,28 +79,21 @@ public:
         // Acquire image
         BaseSample::prepareFrame();
 
+        base_cpuProfiler.beginScope("Update");
         updatePushConstants();
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -312,7 +305,7 @@ public:
         pipelineLayoutInfo.pushConstantRangeCount = 1;
         pipelineLayoutInfo.pPushConstantRanges = &vertexMatrixPushConstantRange;
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -334,7 +327,7 @@ public:
         pipelineCreateInfo.subpass = 0;
 
         // Create graphics pipeline with cyan specialization data for cyan triangle
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &cyanGraphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &cyanGraphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
 
@@ -349,7 +342,7 @@ public:
         specializationInfo.pData = &pinkSpecializationData;
 
         // Create graphics pipeline with pink specialization data for pink triangle
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pinkGraphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &pinkGraphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -386,7 +379,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
         std::vector<VkClearValue> clearValues(2);
@@ -395,6 +388,10 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         std::vector<VkDeviceSize> offsets(vertexes.size(), 0);
@@ -426,8 +423,13 @@ public:
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pinkGraphicsPipeline);
         vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
+        // Draw UI over the scene
+        recordUI(commandBuffer);
+
         vkCmdEndRenderPass(commandBuffer);
 
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to record command buffer!");
         }
@@ -435,8 +437,9 @@ public:
 
     void drawUI()
     {
-        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 200, 50 });
+        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 250, 120 });
         UIOverlay::printFPS((float)base_frameTime, 500);
+        UIOverlay::printGpuProfilerStatistics(base_gpuProfiler);
         UIOverlay::windowEnd();
     }
 };
@@ -68,14 +68,14 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, getHostAllocationCallbacks());
 
         // Descriptors data
-        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, nullptr);
-        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayout, nullptr);
+        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, getHostAllocationCallbacks());
+        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayout, getHostAllocationCallbacks());
 
         // Buffers
         indexBuffer.destroy();
@@ -90,28 +90,21 @@ public:
         // Acquire image
         BaseSample::prepareFrame();
 
+        base_cpuProfiler.beginScope("Update");
         updatePushConstants();
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -300,7 +293,7 @@ public:
         imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
         imageViewCreateInfo.subresourceRange.layerCount = vulkanTexture.layerCount;
 
-        if (vkCreateImageView(base_vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &vulkanTexture.imageView) != VK_SUCCESS) {
+        if (vkCreateImageView(base_vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &vulkanTexture.imageView) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create image view!");
         }
 
@@ -330,7 +323,7 @@ public:
         samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
         samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
 
-        if (vkCreateSampler(base_vulkanDevice->logicalDevice, &samplerCreateInfo, nullptr, &vulkanTexture.sampler) != VK_SUCCESS) {
+        if (vkCreateSampler(base_vulkanDevice->logicalDevice, &samplerCreateInfo, getHostAllocationCallbacks(), &vulkanTexture.sampler) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create sampler!");
         }
 
@@ -381,7 +374,7 @@ public:
         descriptorSetLayoutCreateInfo.bindingCount = 1;
         descriptorSetLayoutCreateInfo.pBindings = &layoutBinding;
 
-        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, getHostAllocationCallbacks(), &descriptorSetLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor set!");
         }
     }
@@ -398,7 +391,7 @@ public:
         descriptorPoolCreateInfo.pPoolSizes = &descriptorPoolSize;
         descriptorPoolCreateInfo.maxSets = 1;
 
-        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &descriptorPool) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor pool!");
         }
 
@@ -578,7 +571,7 @@ public:
         pipelineLayoutInfo.pushConstantRangeCount = pushConstantsRanges.size();
         pipelineLayoutInfo.pPushConstantRanges = pushConstantsRanges.data();
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -599,7 +592,7 @@ public:
         pipelineCreateInfo.renderPass = base_renderPass;
         pipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -628,7 +621,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
 
@@ -638,6 +631,10 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
@@ -665,8 +662,13 @@ public:
 
         vkCmdDrawIndexed(commandBuffer, 6, 1, 0, 0, 0);
 
+        // Draw UI over the scene
+        recordUI(commandBuffer);
+
         vkCmdEndRenderPass(commandBuffer);
 
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to record command buffer!");
         }
@@ -674,8 +676,9 @@ public:
 
     void drawUI()
     {
-        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 300, 100 });
+        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 300, 170 });
         UIOverlay::printFPS((float)base_frameTime, 500);
+        UIOverlay::printGpuProfilerStatistics(base_gpuProfiler);
         ImGui::SliderFloat("LOD bias", &pushConstantData.lodBias, 0.0f, (float)vulkanTexture.mipLevels);
         static int currentLayer = 0;
         ImGui::SliderInt("Layer", &currentLayer, 0, vulkanTexture.layerCount - 1);
@@ -15,9 +15,16 @@ class Sample : public BaseSample
     VulkanBuffer                    indexBuffer;
 
     VulkanTexture2D                 vulkanTexture{};
+    // The same file streamed by base_textureStreamer, its levels follow the screen size of the quad
+    // Drawn instead of vulkanTexture once its mip tail is resident
+    std::shared_ptr<StreamingTexture> streamingTexture;
+    bool                            useStreamingTexture = true;
 
     VkDescriptorPool                descriptorPool = VK_NULL_HANDLE;
-    VkDescriptorSet                 descriptorSet;
+    // One per frame, a set is rewritten when its frame slot comes around after the drawn texture has changed
+    // (the other frames in flight may still use their sets)
+    std::vector<VkDescriptorSet>    descriptorSets;
+    std::vector<bool>               descriptorSetsOutdated;
     VkDescriptorSetLayout           descriptorSetLayout;
 
     // Matrixes
@@ -82,14 +89,14 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, getHostAllocationCallbacks());
 
         // Descriptors data
-        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, nullptr);
-        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayout, nullptr);
+        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, getHostAllocationCallbacks());
+        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayout, getHostAllocationCallbacks());
 
         // Buffers
         indexBuffer.destroy();
@@ -97,6 +104,8 @@ public:
 
         // Texture
         vulkanTexture.destroy();
+        // Destroyed by the streamer
+        streamingTexture.reset();
     }
 
     void draw()
@@ -104,28 +113,25 @@ public:
         // Acquire image
         BaseSample::prepareFrame();
 
+        base_cpuProfiler.beginScope("Update");
         updatePushConstants();
+        requestTextureLevel();
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
+
+        // The set of this frame slot isn't used by the GPU anymore
+        updateDescriptorSet(base_currentFrameIndex);
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -312,7 +318,7 @@ public:
         imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
         imageViewCreateInfo.subresourceRange.layerCount = 1;
 
-        if (vkCreateImageView(base_vulkanDevice->logicalDevice, &imageViewCreateInfo, nullptr, &vulkanTexture.imageView) != VK_SUCCESS) {
+        if (vkCreateImageView(base_vulkanDevice->logicalDevice, &imageViewCreateInfo, getHostAllocationCallbacks(), &vulkanTexture.imageView) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create image view!");
         }
 
@@ -342,10 +348,16 @@ public:
         samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
         samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
 
-        if (vkCreateSampler(base_vulkanDevice->logicalDevice, &samplerCreateInfo, nullptr, &vulkanTexture.sampler) != VK_SUCCESS) {
+        if (vkCreateSampler(base_vulkanDevice->logicalDevice, &samplerCreateInfo, getHostAllocationCallbacks(), &vulkanTexture.sampler) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create sampler!");
         }
         //*/
+
+        // Starts with the mip tail, the higher levels are streamed in when the quad is close enough to need them
+        // The old images are destroyed by the streamer after the frames that used them have been completed
+        streamingTexture = base_textureStreamer.load(filePath, VK_FILTER_LINEAR, [this]() {
+            descriptorSetsOutdated.assign(descriptorSetsOutdated.size(), true);
+        });
     }
 
     void createBuffers()
@@ -389,7 +401,7 @@ public:
         descriptorSetLayoutCreateInfo.bindingCount = 1;
         descriptorSetLayoutCreateInfo.pBindings = &layoutBinding;
 
-        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorSetLayoutCreateInfo, getHostAllocationCallbacks(), &descriptorSetLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor set!");
         }
     }
@@ -398,15 +410,15 @@ public:
     {
         VkDescriptorPoolSize descriptorPoolSize{};
         descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorPoolSize.descriptorCount = 1;
+        descriptorPoolSize.descriptorCount = base_maxFramesInFlight;
 
         VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
         descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         descriptorPoolCreateInfo.poolSizeCount = 1;
         descriptorPoolCreateInfo.pPoolSizes = &descriptorPoolSize;
-        descriptorPoolCreateInfo.maxSets = 1;
+        descriptorPoolCreateInfo.maxSets = base_maxFramesInFlight;
 
-        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        if (vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolCreateInfo, getHostAllocationCallbacks(), &descriptorPool) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create descriptor pool!");
         }
 
@@ -414,24 +426,43 @@ public:
         VkDescriptorSetAllocateInfo setsAllocInfo{};
         setsAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         setsAllocInfo.descriptorPool = descriptorPool;
-        setsAllocInfo.descriptorSetCount = 1;
-        setsAllocInfo.pSetLayouts = &descriptorSetLayout;
+        std::vector<VkDescriptorSetLayout> setLayouts(base_maxFramesInFlight, descriptorSetLayout);
+        setsAllocInfo.descriptorSetCount = base_maxFramesInFlight;
+        setsAllocInfo.pSetLayouts = setLayouts.data();
 
-        if (vkAllocateDescriptorSets(base_vulkanDevice->logicalDevice, &setsAllocInfo, &descriptorSet) != VK_SUCCESS) {
+        descriptorSets.resize(base_maxFramesInFlight);
+        if (vkAllocateDescriptorSets(base_vulkanDevice->logicalDevice, &setsAllocInfo, descriptorSets.data()) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to allocate descriptor sets!");
         }
 
-        // Write descriptor
+        // Write descriptors
         vulkanTexture.updateDescriptor();
+        descriptorSetsOutdated.assign(base_maxFramesInFlight, true);
+        for (uint32_t i = 0; i < base_maxFramesInFlight; i++) {
+            updateDescriptorSet(i);
+        }
+    }
+
+    void updateDescriptorSet(uint32_t frameIndex)
+    {
+        if (!descriptorSetsOutdated[frameIndex]) {
+            return;
+        }
+        descriptorSetsOutdated[frameIndex] = false;
+
+        VulkanTexture2D* drawnTexture = &vulkanTexture;
+        if (useStreamingTexture && streamingTexture->get()) {
+            drawnTexture = streamingTexture->get();
+        }
 
         VkWriteDescriptorSet writeDescriptorSet{};
         writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writeDescriptorSet.dstSet = descriptorSet;
+        writeDescriptorSet.dstSet = descriptorSets[frameIndex];
         writeDescriptorSet.dstBinding = 0;
         writeDescriptorSet.dstArrayElement = 0;
         writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         writeDescriptorSet.descriptorCount = 1;
-        writeDescriptorSet.pImageInfo = &vulkanTexture.descriptor;
+        writeDescriptorSet.pImageInfo = &drawnTexture->descriptor;
 
         vkUpdateDescriptorSets(base_vulkanDevice->logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
     }
@@ -588,7 +619,7 @@ public:
         pipelineLayoutInfo.pushConstantRangeCount = pushConstantsRanges.size();
         pipelineLayoutInfo.pPushConstantRanges = pushConstantsRanges.data();
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -609,7 +640,7 @@ public:
         pipelineCreateInfo.renderPass = base_renderPass;
         pipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -621,6 +652,24 @@ public:
         pushConstantData.MVPmatrix = base_camera.matrices.perspective * base_camera.matrices.view;
     }
 
+    // Requested every frame, a texture that isn't requested loses its higher levels after TextureStreamer::evictionDelay frames
+    void requestTextureLevel()
+    {
+        if (!useStreamingTexture) {
+            return;
+        }
+        // Bounding sphere of the quad(half of its diagonal) at the origin, the camera looks along +Z in the view space
+        const float radius = 0.7071f;
+        glm::vec4 center = base_camera.matrices.view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        float screenSize = TextureStreamer::getProjectedSize(
+            radius,
+            center.z,
+            glm::radians(base_camera.getFov()),
+            static_cast<float>(base_vulkanSwapChain->surfaceExtent.height)
+        );
+        base_textureStreamer.requestScreenSize(*streamingTexture, screenSize);
+    }
+
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
     {
         VkCommandBufferBeginInfo commandBufferBeginInfo{};
@@ -633,7 +682,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
 
@@ -643,6 +692,10 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
@@ -664,14 +717,19 @@ public:
         std::vector<VkDeviceSize> offsets(vertexes.size(), 0);
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.buffer, offsets.data());
         vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[base_currentFrameIndex], 0, nullptr);
 
         vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantData), &pushConstantData);
         
         vkCmdDrawIndexed(commandBuffer, 6, 1, 0, 0, 0);
 
+        // Draw UI over the scene
+        recordUI(commandBuffer);
+
         vkCmdEndRenderPass(commandBuffer);
 
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to record command buffer!");
         }
@@ -679,9 +737,19 @@ public:
 
     void drawUI()
     {
-        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 300, 100 });
+        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 300, 220 });
         UIOverlay::printFPS((float)base_frameTime, 500);
+        UIOverlay::printGpuProfilerStatistics(base_gpuProfiler);
         ImGui::SliderFloat("LOD bias", &pushConstantData.lodBias, 0.0f, (float)vulkanTexture.mipLevels);
+        if (ImGui::Checkbox("Streamed texture", &useStreamingTexture)) {
+            descriptorSetsOutdated.assign(descriptorSetsOutdated.size(), true);
+        }
+        if (streamingTexture->isFailed()) {
+            ImGui::Text("Streaming failed: %s", streamingTexture->getError().c_str());
+        }
+        else if (streamingTexture->get()) {
+            ImGui::Text("Resident levels: %u-%u", streamingTexture->getResidentLevel(), streamingTexture->getLevelCount() - 1);
+        }
         UIOverlay::windowEnd();
     }
 };
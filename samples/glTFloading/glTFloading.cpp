@@ -4,7 +4,12 @@ std::string EXAMPLE_NAME_STR = std::string("glTFloading");
 
 class Sample : public BaseSample
 {
+    // Loaded in the background, the placeholder is drawn until the model is ready
+    std::shared_ptr<StreamedModel>  streamedModel;
+    // Set at the frame boundary when the model becomes ready
     vulkanglTF::Model*              model = nullptr;
+    // Textured cube created at once, released when the frames drawing it have been completed
+    std::unique_ptr<vulkanglTF::Model> placeholderModel;
 
     struct ShaderData {
         VulkanBuffer vulkanBuffer;
@@ -16,7 +21,7 @@ class Sample : public BaseSample
     };
 
     // One per frame
-    std::vector<ShaderData>         shaderData;
+    FrameResourceRing<ShaderData>   shaderData;
 
     VkShaderModule                  vertShaderModule = VK_NULL_HANDLE;
     VkShaderModule                  fragShaderModule = VK_NULL_HANDLE;
@@ -26,6 +31,12 @@ class Sample : public BaseSample
     std::vector<VkDescriptorSet>    descriptorSetsMatrices;
     VkDescriptorSetLayout           descriptorSetLayoutMatrices = VK_NULL_HANDLE;
     VkDescriptorPool                descriptorPool = VK_NULL_HANDLE;
+
+    // Scene draw list is split into ranges recorded into secondary command buffers by the job system
+    bool                            multithreadedRecording = true;
+    SecondaryCommandRecorder        secondaryCommandRecorder;
+    // Fewer primitives per command buffer are not worth the overhead
+    const uint32_t                  minPrimitivesPerTask = 16;
 public:
     Sample()
     {
@@ -42,6 +53,7 @@ public:
         createGraphicsPipeline();
         setupDescriptorPool();
         setupDescriptorSet();
+        secondaryCommandRecorder.init(base_vulkanDevice, base_vulkanDevice->queueFamilyIndices.graphics.value(), base_maxFramesInFlight, base_jobSystem.getThreadCount());
     }
 
     void cleanup()
@@ -49,53 +61,56 @@ public:
         vkDeviceWaitIdle(base_vulkanDevice->logicalDevice);
 
         // Pipeline
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, nullptr);
-        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, nullptr);
-        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, nullptr);
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, vertShaderModule, getHostAllocationCallbacks());
+        vkDestroyShaderModule(base_vulkanDevice->logicalDevice, fragShaderModule, getHostAllocationCallbacks());
+        vkDestroyPipelineLayout(base_vulkanDevice->logicalDevice, pipelineLayout, getHostAllocationCallbacks());
+        vkDestroyPipeline(base_vulkanDevice->logicalDevice, graphicsPipeline, getHostAllocationCallbacks());
 
         // Descriptor pool
-        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, nullptr);
+        vkDestroyDescriptorPool(base_vulkanDevice->logicalDevice, descriptorPool, getHostAllocationCallbacks());
 
         // Descriptor set layouts
-        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayoutMatrices, nullptr);
+        vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, descriptorSetLayoutMatrices, getHostAllocationCallbacks());
+
+        // Secondary command buffers
+        secondaryCommandRecorder.destroy();
 
         // Uniform buffer
-        for (uint32_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; ++i) {
-            shaderData[i].vulkanBuffer.destroy();
-        }
+        shaderData.destroy([](ShaderData& frameShaderData) { frameShaderData.vulkanBuffer.destroy(); });
 
         // Model
-        delete model;
+        model = nullptr;
+        streamedModel.reset();
+        placeholderModel.reset();
+        // The layout is destroyed with the model, but the model may have not been loaded
+        if (vulkanglTF::descriptorSetLayoutImage) {
+            vkDestroyDescriptorSetLayout(base_vulkanDevice->logicalDevice, vulkanglTF::descriptorSetLayoutImage, getHostAllocationCallbacks());
+            vulkanglTF::descriptorSetLayoutImage = VK_NULL_HANDLE;
+        }
     }
 
     void draw()
     {
         // Acquire image
         BaseSample::prepareFrame();
+        // The frame has been completed, its secondary command buffers can be reused
+        secondaryCommandRecorder.beginFrame(base_currentFrameIndex);
 
+        base_cpuProfiler.beginScope("Update");
         updateUniformBuffers(base_currentFrameIndex);
+        base_cpuProfiler.endScope();
+
+        // Build UI before recording, it is drawn at the end of the scene render pass
+        buildUI();
 
         // Record command buffer
+        base_cpuProfiler.beginScope("Record commands");
         vkResetCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], 0);
         recordCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex], base_currentImageIndex);
+        base_cpuProfiler.endScope();
 
-        // Draw UI
-        imguiUI.beginFrame();
-        drawUI();
-        imguiUI.endFrame();
-
-        VkCommandBuffer imguiCommandBuffer;
-        imguiCommandBuffer = imguiUI.recordAndGetCommandBuffer(base_currentFrameIndex, base_currentImageIndex);
-
-        std::vector<VkCommandBuffer> submittableCommandBuffer{ base_commandBuffersGraphics[base_currentFrameIndex], imguiCommandBuffer };
-
-        base_submitInfo.commandBufferCount = submittableCommandBuffer.size();
-        base_submitInfo.pCommandBuffers = submittableCommandBuffer.data();
-        setupSubmitInfo(base_currentFrameIndex);
-        if (vkQueueSubmit(base_graphicsQueue, 1, &base_submitInfo, base_inFlightFences[base_currentFrameIndex]) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to submit command buffers!");
-        }
+        // Submit the scene(and the UI if it is not recorded into the scene render pass)
+        submitFrameCommandBuffer(base_commandBuffersGraphics[base_currentFrameIndex]);
 
         // Present image
         BaseSample::submitFrame();
@@ -118,25 +133,135 @@ public:
 
     void loadAssets()
     {
-        model = new vulkanglTF::Model(base_vulkanDevice, base_graphicsQueue, base_commandPoolGraphics, base_vmaAllocator);
+        // The pipeline is created before the model is loaded
+        vulkanglTF::createDescriptorSetLayoutImage(base_vulkanDevice->logicalDevice);
         const uint32_t glTFLoadingFlags = vulkanglTF::PreTransformVertices | vulkanglTF::FileLoadingFlags::PreMultiplyVertexColors | vulkanglTF::FileLoadingFlags::FlipZ;
-        model->loadFromFile(ASSETS_DATA_PATH + "/models/FlightHelmet/glTF/FlightHelmet.gltf", glTFLoadingFlags, base_graphicsQueue, base_commandPoolGraphics);
+        createPlaceholderModel(glTFLoadingFlags);
+        streamedModel = base_assetStreamer.loadModel(
+            ASSETS_DATA_PATH + "/models/FlightHelmet/glTF/FlightHelmet.gltf",
+            glTFLoadingFlags,
+            1.0f,
+            [this]() {
+                if (streamedModel->isFailed()) {
+                    throw MakeErrorInfo("Failed to load model!\n" + streamedModel->getError());
+                }
+                model = streamedModel->get();
+                // Textures, vertex and index buffers can be moved by the defragmenter(F9 key or --defragment)
+                model->registerForDefragmentation(base_defragmenter);
+                // The frames in flight may still draw the placeholder, this frame draws the model
+                vulkanglTF::Model* releasedPlaceholderModel = placeholderModel.release();
+                base_deferredReleases.push(getFrameTimelineValue(), [releasedPlaceholderModel]() { delete releasedPlaceholderModel; });
+            }
+        );
         //"/models/BoomBoxWithAxesBlender/BoomBoxWithAxesBlender.gltf" - Tested on left handed coordinate system(with fliping Z load flag)
         //"/models/FlightHelmet/glTF/FlightHelmet.gltf"
     }
 
+    // Textured cube built as an in-memory glTF model, so it is drawn by the same pipeline and draw path as the loaded model
+    void createPlaceholderModel(uint32_t glTFLoadingFlags)
+    {
+        const float halfSize = 0.15f;
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> uvs;
+        std::vector<uint16_t> indices;
+        const glm::vec3 faceNormals[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        const glm::vec2 corners[4] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+        for (const glm::vec3& normal : faceNormals) {
+            // Axes of the face, counter-clockwise corners seen from outside
+            glm::vec3 up = normal.y != 0.0f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+            glm::vec3 right = glm::cross(up, normal);
+            uint16_t firstVertex = static_cast<uint16_t>(positions.size() / 3);
+            for (const glm::vec2& corner : corners) {
+                glm::vec3 position = (normal + right * corner.x + up * corner.y) * halfSize;
+                positions.insert(positions.end(), { position.x, position.y, position.z });
+                normals.insert(normals.end(), { normal.x, normal.y, normal.z });
+                uvs.insert(uvs.end(), { (corner.x + 1.0f) * 0.5f, (1.0f - corner.y) * 0.5f });
+            }
+            for (uint16_t index : { 0, 1, 2, 0, 2, 3 }) {
+                indices.push_back(firstVertex + index);
+            }
+        }
+
+        tinygltf::Model gltfModel;
+        tinygltf::Buffer buffer;
+        // Attribute and index data one after another, a buffer view and an accessor each
+        auto addAccessor = [&](const void* data, size_t size, size_t count, int type, int componentType) {
+            tinygltf::BufferView bufferView;
+            bufferView.buffer = 0;
+            bufferView.byteOffset = buffer.data.size();
+            bufferView.byteLength = size;
+            buffer.data.insert(buffer.data.end(), static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+            gltfModel.bufferViews.push_back(bufferView);
+            tinygltf::Accessor accessor;
+            accessor.bufferView = static_cast<int>(gltfModel.bufferViews.size() - 1);
+            accessor.count = count;
+            accessor.type = type;
+            accessor.componentType = componentType;
+            gltfModel.accessors.push_back(accessor);
+            return static_cast<int>(gltfModel.accessors.size() - 1);
+        };
+        tinygltf::Primitive primitive;
+        primitive.attributes["POSITION"] = addAccessor(positions.data(), positions.size() * sizeof(float), positions.size() / 3, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT);
+        gltfModel.accessors.back().minValues = { -halfSize, -halfSize, -halfSize };
+        gltfModel.accessors.back().maxValues = { halfSize, halfSize, halfSize };
+        primitive.attributes["NORMAL"] = addAccessor(normals.data(), normals.size() * sizeof(float), normals.size() / 3, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT);
+        primitive.attributes["TEXCOORD_0"] = addAccessor(uvs.data(), uvs.size() * sizeof(float), uvs.size() / 2, TINYGLTF_TYPE_VEC2, TINYGLTF_COMPONENT_TYPE_FLOAT);
+        primitive.indices = addAccessor(indices.data(), indices.size() * sizeof(uint16_t), indices.size(), TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT);
+        primitive.material = 0;
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+        gltfModel.buffers.push_back(buffer);
+
+        // Grey checkerboard, already decoded
+        tinygltf::Image image;
+        image.width = 8;
+        image.height = 8;
+        image.component = 4;
+        image.bits = 8;
+        image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        for (int y = 0; y < image.height; y++) {
+            for (int x = 0; x < image.width; x++) {
+                unsigned char value = (x + y) % 2 ? 96 : 160;
+                image.image.insert(image.image.end(), { value, value, value, 255 });
+            }
+        }
+        gltfModel.images.push_back(image);
+        tinygltf::Texture texture;
+        texture.source = 0;
+        gltfModel.textures.push_back(texture);
+        tinygltf::Material material;
+        material.values["baseColorTexture"].json_double_value["index"] = 0;
+        gltfModel.materials.push_back(material);
+
+        tinygltf::Mesh mesh;
+        mesh.primitives.push_back(primitive);
+        gltfModel.meshes.push_back(mesh);
+        tinygltf::Node node;
+        node.mesh = 0;
+        gltfModel.nodes.push_back(node);
+        tinygltf::Scene scene;
+        scene.nodes.push_back(0);
+        gltfModel.scenes.push_back(scene);
+
+        // Uploaded with the other uploads of the preparation, before the first frame
+        placeholderModel = std::make_unique<vulkanglTF::Model>(base_vulkanDevice, &base_uploadManager, base_vmaAllocator);
+        placeholderModel->memoryPools = base_useMemoryPools ? &base_memoryPools : nullptr;
+        placeholderModel->loadFromglTFModel(gltfModel, glTFLoadingFlags);
+    }
+
     void prepareUniformBuffers()
     {
-        shaderData.resize(BASE_MAX_FRAMES_IN_FLIGHT);
-        for (uint32_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; ++i) {
-            shaderData[i].vulkanBuffer.setDeviceAndAllocator(base_vulkanDevice, base_vmaAllocator);
-            shaderData[i].vulkanBuffer.createBuffer(
+        shaderData.create(base_maxFramesInFlight, [&](uint32_t frameIndex) {
+            ShaderData frameShaderData;
+            frameShaderData.vulkanBuffer.setDeviceAndAllocator(base_vulkanDevice, base_vmaAllocator);
+            // Persistently mapped, it is written every frame
+            frameShaderData.vulkanBuffer.createDynamicBuffer(
                 sizeof(ShaderData),
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+                base_memoryPools.getPool(MemoryPools::Category::PerFrame)
             );
-        }
+            return frameShaderData;
+        });
     }
 
     void setupDescriptorSetLayout()
@@ -155,7 +280,7 @@ public:
                 setLayoutBindings.data(),
                 setLayoutBindings.size());
 
-        VK_CHECK_RESULT(vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorLayout, nullptr, &descriptorSetLayoutMatrices));
+        VK_CHECK_RESULT(vkCreateDescriptorSetLayout(base_vulkanDevice->logicalDevice, &descriptorLayout, getHostAllocationCallbacks(), &descriptorSetLayoutMatrices));
     }
 
     void createGraphicsPipeline()
@@ -201,7 +326,7 @@ public:
         pipelineLayoutInfo.setLayoutCount = descriptorSetLayoutsList.size();
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayoutsList.data();
 
-        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        if (vkCreatePipelineLayout(base_vulkanDevice->logicalDevice, &pipelineLayoutInfo, getHostAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create pipeline layout!");
         }
 
@@ -222,7 +347,7 @@ public:
         pipelineCreateInfo.renderPass = base_renderPass;
         pipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(base_vulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, getHostAllocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw MakeErrorInfo("Failed to create graphics pipeline!");
         }
     }
@@ -232,7 +357,7 @@ public:
         std::vector<VkDescriptorPoolSize> poolSizes =
         {
             // One descriptor per frame
-            vulkanInitializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, BASE_MAX_FRAMES_IN_FLIGHT)
+            vulkanInitializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, base_maxFramesInFlight)
         };
 
         // One descriptor set per frame
@@ -240,27 +365,27 @@ public:
             vulkanInitializers::descriptorPoolCreateInfo(
                 poolSizes.size(),
                 poolSizes.data(),
-                BASE_MAX_FRAMES_IN_FLIGHT
+                base_maxFramesInFlight
             );
 
-        VK_CHECK_RESULT(vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolInfo, nullptr, &descriptorPool));
+        VK_CHECK_RESULT(vkCreateDescriptorPool(base_vulkanDevice->logicalDevice, &descriptorPoolInfo, getHostAllocationCallbacks(), &descriptorPool));
     }
 
     void setupDescriptorSet()
     {
-        // Allocate BASE_MAX_FRAMES_IN_FLIGHT descriptors sets
+        // Allocate base_maxFramesInFlight descriptors sets
         // One descriptor set per frame
-        std::vector<VkDescriptorSetLayout> setsLayouts(BASE_MAX_FRAMES_IN_FLIGHT, descriptorSetLayoutMatrices);
+        std::vector<VkDescriptorSetLayout> setsLayouts(base_maxFramesInFlight, descriptorSetLayoutMatrices);
         VkDescriptorSetAllocateInfo allocInfo =
             vulkanInitializers::descriptorSetAllocateInfo(
                 descriptorPool,
                 setsLayouts.data(),
-                BASE_MAX_FRAMES_IN_FLIGHT);
+                base_maxFramesInFlight);
 
-        descriptorSetsMatrices.resize(BASE_MAX_FRAMES_IN_FLIGHT);
+        descriptorSetsMatrices.resize(base_maxFramesInFlight);
         VK_CHECK_RESULT(vkAllocateDescriptorSets(base_vulkanDevice->logicalDevice, &allocInfo, descriptorSetsMatrices.data()));
 
-        for (uint32_t i = 0; i < BASE_MAX_FRAMES_IN_FLIGHT; ++i) {
+        for (uint32_t i = 0; i < base_maxFramesInFlight; ++i) {
             VkWriteDescriptorSet writeDescriptorSet =
             {
                 // Binding 0 : Vertex shader uniform buffer
@@ -286,10 +411,8 @@ public:
         shaderData[currentFrame].data.view = base_camera.matrices.view;
         shaderData[currentFrame].data.model = model_transform;
 
-        void* pMappedBuffer = nullptr;
-        shaderData[currentFrame].vulkanBuffer.map(&pMappedBuffer);
-        memcpy(pMappedBuffer, &shaderData[currentFrame].data, sizeof(ShaderData::Data));
-        shaderData[currentFrame].vulkanBuffer.unmap();
+        shaderData[currentFrame].vulkanBuffer.write(0, shaderData[currentFrame].data);
+        shaderData[currentFrame].vulkanBuffer.flushDirtyRanges();
     }
 
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
@@ -304,7 +427,7 @@ public:
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.renderPass = base_renderPass;
-        renderPassBeginInfo.framebuffer = base_swapChainFramebuffers[imageIndex];
+        renderPassBeginInfo.framebuffer = getFramebuffer(base_currentFrameIndex, imageIndex);
         renderPassBeginInfo.renderArea.offset = { 0, 0 };
         renderPassBeginInfo.renderArea.extent = base_vulkanSwapChain->surfaceExtent;
         std::vector<VkClearValue> clearValues(2);
@@ -313,8 +436,69 @@ public:
         renderPassBeginInfo.clearValueCount = clearValues.size();
         renderPassBeginInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // Reset GPU timestamp queries of this frame, must be done outside of the render pass
+        base_gpuProfiler.beginFrame(commandBuffer);
+        base_gpuProfiler.beginScope(commandBuffer, "Scene");
+
+        // The placeholder until the model is ready
+        const vulkanglTF::Model* drawnModel = model ? model : placeholderModel.get();
+        uint32_t primitivesCount = drawnModel ? drawnModel->drawList.size() : 0;
+        uint32_t threadCount = base_jobSystem.getThreadCount();
+        if (multithreadedRecording && threadCount > 1 && primitivesCount >= minPrimitivesPerTask * 2) {
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.renderPass = base_renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = renderPassBeginInfo.framebuffer;
+
+            uint32_t taskCount = primitivesCount / minPrimitivesPerTask;
+            if (taskCount > threadCount) {
+                taskCount = threadCount;
+            }
+            uint32_t primitivesPerTask = (primitivesCount + taskCount - 1) / taskCount;
+            const std::vector<VkCommandBuffer>& secondaryCommandBuffers = secondaryCommandRecorder.record(
+                base_jobSystem,
+                taskCount,
+                inheritanceInfo,
+                [&](VkCommandBuffer secondaryCommandBuffer, uint32_t taskIndex) {
+                    recordScene(secondaryCommandBuffer, *drawnModel, taskIndex * primitivesPerTask, primitivesPerTask);
+                }
+            );
+            // Inline commands are not allowed in this subpass, the UI gets its own secondary command buffer after the scene ones
+            // ImGui isn't thread safe, it is recorded on this thread
+            if (base_uiInSceneRenderPass) {
+                secondaryCommandRecorder.recordOnCallingThread(
+                    base_jobSystem,
+                    inheritanceInfo,
+                    [&](VkCommandBuffer secondaryCommandBuffer, uint32_t) { recordUI(secondaryCommandBuffer); }
+                );
+            }
+            vkCmdExecuteCommands(commandBuffer, secondaryCommandBuffers.size(), secondaryCommandBuffers.data());
+        }
+        else {
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            if (drawnModel) {
+                recordScene(commandBuffer, *drawnModel, 0, primitivesCount);
+            }
+            // Draw UI over the scene
+            recordUI(commandBuffer);
+        }
+
+        vkCmdEndRenderPass(commandBuffer);
+
+        base_gpuProfiler.endScope(commandBuffer, "Scene");
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw MakeErrorInfo("Failed to record command buffer!");
+        }
+    }
 
+    // Records the state and the draws of the primitives [firstPrimitive, firstPrimitive + primitivesCount) of the model
+    // Is called by the job system threads, must not modify the sample
+    void recordScene(VkCommandBuffer commandBuffer, const vulkanglTF::Model& drawnModel, uint32_t firstPrimitive, uint32_t primitivesCount)
+    {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 
         VkViewport viewport{};
@@ -332,21 +516,19 @@ public:
 
         // Bind scene matrices descriptor to set 0
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSetsMatrices[base_currentFrameIndex], 0, nullptr);
-        model->bindBuffers(commandBuffer);
-        model->draw(commandBuffer, vulkanglTF::RenderFlags::BindImages, pipelineLayout, 1);
-
-        vkCmdEndRenderPass(commandBuffer);
-
-        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-            throw MakeErrorInfo("Failed to record command buffer!");
-        }
+        drawnModel.drawRange(commandBuffer, firstPrimitive, primitivesCount, vulkanglTF::RenderFlags::BindImages, pipelineLayout, 1);
     }
 
     void drawUI()
     {
-        //UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 300, 100 });
-        //UIOverlay::printFPS((float)base_frameTime, 500);
-        //UIOverlay::windowEnd();
+        UIOverlay::windowBegin(base_title.c_str(), nullptr, { 0, 0 }, { 250, 145 });
+        UIOverlay::printFPS((float)base_frameTime, 500);
+        ImGui::Checkbox("Multithreaded recording", &multithreadedRecording);
+        if (!model) {
+            ImGui::Text("Loading model...");
+        }
+        UIOverlay::printGpuProfilerStatistics(base_gpuProfiler);
+        UIOverlay::windowEnd();
     }
 };
 